@@ -2192,6 +2192,18 @@ NetExpr* PECallFunction::elaborate_expr(Design*des, NetScope*scope,
 NetExpr* PECallFunction::elaborate_expr(Design*des, NetScope*scope,
 					ivl_type_t type, unsigned flags) const
 {
+	// A class object r-value may be the pop_back or pop_front of a
+	// queue of class objects.
+      if (dynamic_cast<const netclass_t*>(type)) {
+	    if (NetExpr*tmp = elaborate_expr_method_(des, scope, 0))
+		  return tmp;
+
+	    cerr << get_fileline() << ": sorry: I do not know how to "
+		 << "elaborate " << path_ << " as a class object." << endl;
+	    des->errors += 1;
+	    return 0;
+      }
+
       const netdarray_t*darray = dynamic_cast<const netdarray_t*>(type);
       assert(darray);
       return elaborate_expr(des, scope, darray->element_type()->packed_width(), flags);
@@ -2466,6 +2478,20 @@ NetExpr* PECallFunction::elaborate_expr_method_(Design*des, NetScope*scope,
 		  return sys_expr;
 	    }
 
+	      // The pop methods of a queue of class objects return
+	      // an object of the class type of the items.
+	    const netdarray_t*darray = net->darray_type();
+	    if (darray->element_base_type() == IVL_VT_CLASS
+		&& (method_name == "pop_back" || method_name == "pop_front")) {
+		  NetESFunc*sys_expr = new NetESFunc(method_name == "pop_back"
+						     ? "$ivl_darray_method$pop_back"
+						     : "$ivl_darray_method$pop_front",
+						     darray->element_type(), 1);
+		  sys_expr->parm(0, new NetESignal(net));
+		  sys_expr->set_line(*this);
+		  return sys_expr;
+	    }
+
 	    if (method_name == "pop_back") {
 		  NetESFunc*sys_expr = new NetESFunc("$ivl_darray_method$pop_back",
 						     expr_type_,
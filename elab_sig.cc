@@ -1217,7 +1217,16 @@ NetNet* PWire::elaborate_sig(Design*des, NetScope*scope) const
 	    ivl_assert(*this, class_type->save_elaborated_type);
 	    netclass_t*use_type = class_type->save_elaborated_type;
 
-	    sig = new NetNet(scope, name_, wtype, unpacked_dimensions, use_type);
+	      // A queue of class objects has the class as the type of
+	      // its items, and not the vector made up above.
+	    if (dynamic_cast<netqueue_t*>(netdarray)) {
+		  ivl_assert(*this, unpacked_dimensions.empty());
+		  delete netdarray;
+		  netdarray = new netqueue_t(use_type);
+		  sig = new NetNet(scope, name_, wtype, netdarray);
+	    } else {
+		  sig = new NetNet(scope, name_, wtype, unpacked_dimensions, use_type);
+	    }
 
       } else if (struct_type_t*struct_type = dynamic_cast<struct_type_t*>(set_data_type_)) {
 	      // If this is a struct type, then build the net with the
@@ -0,0 +1,86 @@
+// An unsigned array multiplier of about WIDTH*WIDTH full adders built
+// from primitive gates. Each new pair of operands ripples through the
+// whole array, so the run time goes into net to net propagation. Every
+// product is checked against the * operator. +count=N sets the number
+// of products and -Pmain.WIDTH=N the size of the array.
+
+module full_add(output s, output co, input a, input b, input ci);
+
+   wire t, c1, c2;
+
+   xor x1(t, a, b);
+   xor x2(s, t, ci);
+   and a1(c1, a, b);
+   and a2(c2, t, ci);
+   or  o1(co, c1, c2);
+
+endmodule
+
+module array_mult #(parameter WIDTH = 32)
+   (output [2*WIDTH-1:0] p, input [WIDTH-1:0] a, input [WIDTH-1:0] b);
+
+   // Row r of adders adds the partial product a*b[r] to the result of
+   // the row above shifted down one bit, and ripples its carries from
+   // column to column. sum[r] and carry[r] are the outputs of row r.
+   wire [WIDTH-1:0] sum [0:WIDTH-1];
+   wire [WIDTH-1:0] carry [0:WIDTH-1];
+   wire [WIDTH-1:0] pp [0:WIDTH-1];
+
+   genvar r, c;
+   generate for (r = 0 ; r < WIDTH ; r = r + 1) begin : pprod
+      for (c = 0 ; c < WIDTH ; c = c + 1) begin : pbit
+	 and g(pp[r][c], a[c], b[r]);
+      end
+   end endgenerate
+
+   // Row 0 is just the first partial product.
+   assign sum[0] = pp[0];
+   assign carry[0] = {WIDTH{1'b0}};
+   assign p[0] = pp[0][0];
+
+   generate for (r = 1 ; r < WIDTH ; r = r + 1) begin : row
+      for (c = 0 ; c < WIDTH ; c = c + 1) begin : col
+	 wire above = (c == WIDTH-1) ? carry[r-1][c] : sum[r-1][c+1];
+	 full_add fa(sum[r][c], carry[r][c], pp[r][c], above,
+		     (c == 0) ? 1'b0 : carry[r][c-1]);
+      end
+      assign p[r] = sum[r][0];
+   end endgenerate
+
+   // The last row holds the upper half of the product.
+   assign p[2*WIDTH-2:WIDTH] = sum[WIDTH-1][WIDTH-1:1];
+   assign p[2*WIDTH-1] = carry[WIDTH-1][WIDTH-1];
+
+endmodule
+
+module main;
+
+   parameter WIDTH = 32;
+
+   reg  [WIDTH-1:0] a, b;
+   wire [2*WIDTH-1:0] p;
+   integer count, idx, errors, seed;
+   reg [63:0] sum;
+
+   array_mult #(WIDTH) dut(p, a, b);
+
+   initial begin
+      if (!$value$plusargs("count=%d", count))
+	count = 100;
+
+      seed = 1;
+      errors = 0;
+      sum = 0;
+      for (idx = 0 ; idx < count ; idx = idx + 1) begin
+	 a = $random(seed);
+	 b = $random(seed);
+	 #1 if (p !== a*b) errors = errors + 1;
+	 sum = {sum[62:0], sum[63]} ^ p;
+      end
+
+      $display("width=%0d count=%0d errors=%0d sum=%h",
+	       WIDTH, count, errors, sum);
+      $finish;
+   end
+
+endmodule
@@ -0,0 +1,85 @@
+// This example is a stress test for vvp -j. Each of the LANES lanes is a
+// chain of STAGES mixing stages made only of gates, continuous bitwise
+// assigns, muxes, part selects and concatenations, with no arithmetic,
+// so the lanes become independent netlist regions that vvp -j can
+// evaluate in parallel. Each lane checks every result of its gates
+// against the same mix computed by a function, and prints its number
+// of errors and a checksum that should not change with the number of
+// threads. The +count=N plusarg sets the number of vectors per lane.
+
+module mix_stage #(parameter R = 1, parameter [31:0] K = 0)
+   (output [31:0] y, input [31:0] x);
+
+   wire [31:0] rot = {x[R-1:0], x[31:R]};
+   wire [31:0] t, m, n;
+
+   xor g[31:0] (t, x, rot);
+   nand h[31:0] (m, t, K);
+   assign n = t | {x[15:0], x[31:16]};
+   assign y = K[0] ? m : n;
+
+endmodule
+
+module main;
+
+   parameter LANES = 8;
+   parameter STAGES = 24;
+
+   function [31:0] key(input integer lane, input integer stage);
+      key = 32'h9e3779b9 ^ (stage * 32'h01000193) ^ (lane << 7);
+   endfunction
+
+   function [31:0] mix(input [31:0] x, input integer lane);
+      integer s, r;
+      reg [31:0] k, t;
+      begin
+	 for (s = 0 ; s < STAGES ; s = s + 1) begin
+	    r = s % 7 + 1;
+	    k = key(lane, s);
+	    t = x ^ ((x >> r) | (x << (32-r)));
+	    x = k[0] ? ~(t & k) : (t | {x[15:0], x[31:16]});
+	 end
+	 mix = x;
+      end
+   endfunction
+
+   genvar l, s;
+   generate for (l = 0 ; l < LANES ; l = l + 1) begin : lane
+      reg [31:0] x;
+      wire [31:0] y;
+      integer count, idx, errors;
+      reg [31:0] sum;
+
+      for (s = 0 ; s < STAGES ; s = s + 1) begin : stage
+	 wire [31:0] in, out;
+	 if (s == 0) begin : first
+	    assign in = x;
+	 end else begin : next
+	    assign in = lane[l].stage[s-1].out;
+	 end
+	 mix_stage #(.R(s % 7 + 1), .K(key(l, s))) mix(out, in);
+      end
+
+      assign y = stage[STAGES-1].out;
+
+      initial begin
+	 if (!$value$plusargs("count=%d", count))
+	   count = 2000;
+
+	 x = 32'h1 << l;
+	 errors = 0;
+	 sum = 0;
+	 for (idx = 0 ; idx < count ; idx = idx + 1) begin
+	    x = x ^ (x << 13);
+	    x = x ^ (x >> 17);
+	    x = x ^ (x << 5);
+	    #1 if (y !== mix(x, l)) errors = errors + 1;
+	    sum = {sum[30:0], sum[31]} ^ y;
+	 end
+
+	 $display("lane %0d: count=%0d errors=%0d sum=%h",
+		  l, count, errors, sum);
+      end
+   end endgenerate
+
+endmodule
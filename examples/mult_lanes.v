@@ -0,0 +1,80 @@
+// LANES gate level multipliers that share no nets, each fed by its own
+// process, so that vvp -j can evaluate them as separate regions. Every
+// lane checks its products against * and prints an error count and a
+// checksum. +count=N sets the number of products per lane.
+
+module full_add(output s, output co, input a, input b, input ci);
+
+   wire t, c1, c2;
+
+   xor x1(t, a, b);
+   xor x2(s, t, ci);
+   and a1(c1, a, b);
+   and a2(c2, t, ci);
+   or  o1(co, c1, c2);
+
+endmodule
+
+module lane_mult #(parameter WIDTH = 16)
+   (output [2*WIDTH-1:0] p, input [WIDTH-1:0] a, input [WIDTH-1:0] b);
+
+   // Row r adds the partial product a*b[r] to the result of the row
+   // above shifted down one bit. The wires are declared in each row
+   // rather than as net arrays, which would make VPI words of them.
+   genvar r;
+   generate for (r = 0 ; r < WIDTH ; r = r + 1) begin : row
+      wire [WIDTH-1:0] pp, s, c;
+
+      and g[WIDTH-1:0] (pp, a, {WIDTH{b[r]}});
+
+      if (r == 0) begin : first
+	 assign s = pp;
+	 assign c = {WIDTH{1'b0}};
+      end else begin : add
+	 full_add fa[WIDTH-1:0] (s, c, pp,
+				 {row[r-1].c[WIDTH-1], row[r-1].s[WIDTH-1:1]},
+				 {c[WIDTH-2:0], 1'b0});
+      end
+
+      assign p[r] = s[0];
+   end endgenerate
+
+   assign p[2*WIDTH-1:WIDTH] = {row[WIDTH-1].c[WIDTH-1],
+				row[WIDTH-1].s[WIDTH-1:1]};
+
+endmodule
+
+module main;
+
+   parameter WIDTH = 16;
+   parameter LANES = 8;
+
+   genvar k;
+   generate for (k = 0 ; k < LANES ; k = k + 1) begin : lane
+      reg  [WIDTH-1:0] a, b;
+      wire [2*WIDTH-1:0] p;
+      integer count, idx, errors, seed;
+      reg [63:0] sum;
+
+      lane_mult #(WIDTH) dut(p, a, b);
+
+      initial begin
+	 if (!$value$plusargs("count=%d", count))
+	   count = 1000;
+
+	 seed = k + 1;
+	 errors = 0;
+	 sum = 0;
+	 for (idx = 0 ; idx < count ; idx = idx + 1) begin
+	    a = $random(seed);
+	    b = $random(seed);
+	    #1 if (p !== a*b) errors = errors + 1;
+	    sum = {sum[62:0], sum[63]} ^ p;
+	 end
+
+	 $display("lane %0d: width=%0d count=%0d errors=%0d sum=%h",
+		  k, WIDTH, count, errors, sum);
+      end
+   end endgenerate
+
+endmodule
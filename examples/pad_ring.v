@@ -0,0 +1,60 @@
+// A ring of NPADS I/O pads at switch level. Each pad drives its pad net
+// through an output enable tranif1, and neighbouring pads are joined by
+// isolation switches that stay off. The whole ring is one tran island,
+// but a toggle of a core driver only reaches a pad or two. +time=N sets
+// the length of the run.
+
+module pad_cell(inout pad, inout core, input oe, input d);
+
+   // The pad is pulled down when its output enable is off.
+   assign core = d;
+   tranif1 obuf(core, pad, oe);
+   pulldown pd(pad);
+
+endmodule
+
+module main;
+
+   parameter NPADS = 1024;
+
+   wire pad [0:NPADS-1];
+   reg  iso;
+   integer toggles, run_time;
+   reg [31:0] sum;
+
+   genvar gi;
+   generate for (gi = 0 ; gi < NPADS ; gi = gi + 1) begin : ring
+      reg  d, oe;
+      wire core;
+
+      pad_cell pc(pad[gi], core, oe, d);
+      // The isolation switch to the next pad, around the ring.
+      tranif0 link_sw(pad[gi], pad[(gi+1) % NPADS], iso);
+
+      // Each pad has a core driver with its own period, and now and
+      // then turns its output enable around.
+      initial begin
+	 d = 1'b0;
+	 oe = 1'b1;
+      end
+      always #(2 + (gi*37) % 101) begin
+	 d = ~d;
+	 toggles = toggles + 1;
+      end
+      always #(1000 + (gi*53) % 997) oe = ~oe;
+
+      always @(pad[gi]) sum = {sum[30:0], sum[31]} ^ (gi + pad[gi]);
+   end endgenerate
+
+   initial begin
+      if (!$value$plusargs("time=%d", run_time))
+	run_time = 10000;
+
+      iso = 1'b1;
+      toggles = 0;
+      sum = 0;
+      #(run_time) $display("pads=%0d toggles=%0d sum=%h", NPADS, toggles, sum);
+      $finish;
+   end
+
+endmodule
@@ -0,0 +1,113 @@
+// Pushes, pops and q[i] reads on queues of int, bit, logic, string and
+// class items, the way a scoreboard or a FIFO model uses them. +n=N sets
+// the number of items per queue, and +queue=<name> runs one test alone.
+// Compile it with -g2012.
+
+module main;
+
+   class item;
+      int value;
+   endclass
+
+   int       iq[$];
+   bit [7:0] bq[$];
+   logic [31:0] lq[$];
+   string    sq[$];
+   item      oq[$];
+
+   integer n, idx, rep;
+   int       isum;
+   bit [7:0] bsum;
+   logic [31:0] lsum;
+   int       slen;
+   string    str;
+   int       osum;
+   item      obj;
+   string    which;
+
+   initial begin
+      if (!$value$plusargs("n=%d", n))
+	n = 100000;
+      if (!$value$plusargs("queue=%s", which))
+	which = "all";
+
+      // int: a FIFO that stays short, and a long queue read in place.
+      if (which == "all" || which == "int") begin
+	 isum = 0;
+	 for (idx = 0 ; idx < n ; idx = idx + 1) begin
+	    iq.push_back(idx);
+	    if (iq.size() > 16)
+	      isum = isum + iq.pop_front();
+	 end
+	 for (rep = 0 ; rep < 4 ; rep = rep + 1)
+	   for (idx = 0 ; idx < iq.size() ; idx = idx + 1)
+	     isum = isum ^ iq[idx];
+	 while (iq.size() > 0)
+	   isum = isum + iq.pop_back();
+	 for (idx = 0 ; idx < n ; idx = idx + 1)
+	   iq.push_front(idx);
+	 for (rep = 0 ; rep < 4 ; rep = rep + 1)
+	   for (idx = 0 ; idx < n ; idx = idx + 1)
+	     isum = isum + iq[idx];
+	 while (iq.size() > 0)
+	   isum = isum - iq.pop_front();
+	 $display("int:    %0d", isum);
+      end
+
+      // bit [7:0]
+      if (which == "all" || which == "bit") begin
+	 bsum = 0;
+	 for (idx = 0 ; idx < n ; idx = idx + 1)
+	   bq.push_back(idx);
+	 for (rep = 0 ; rep < 4 ; rep = rep + 1)
+	   for (idx = 0 ; idx < n ; idx = idx + 1)
+	     bsum = bsum + bq[idx];
+	 while (bq.size() > 0)
+	   bsum = bsum ^ bq.pop_front();
+	 $display("bit:    %0d", bsum);
+      end
+
+      // logic [31:0]
+      if (which == "all" || which == "logic") begin
+	 lsum = 0;
+	 for (idx = 0 ; idx < n ; idx = idx + 1)
+	   lq.push_back(idx * 3);
+	 for (rep = 0 ; rep < 4 ; rep = rep + 1)
+	   for (idx = 0 ; idx < n ; idx = idx + 1)
+	     lsum = lsum + lq[idx];
+	 while (lq.size() > 0)
+	   lsum = lsum ^ lq.pop_back();
+	 $display("logic:  %0d", lsum);
+      end
+
+      // string
+      if (which == "all" || which == "string") begin
+	 slen = 0;
+	 for (idx = 0 ; idx < n ; idx = idx + 1)
+	   sq.push_back("item");
+	 while (sq.size() > 0) begin
+	    str = sq.pop_front();
+	    slen = slen + str.len();
+	 end
+	 $display("string: %0d", slen);
+      end
+
+      // class objects
+      if (which == "all" || which == "object") begin
+	 osum = 0;
+	 for (idx = 0 ; idx < n ; idx = idx + 1) begin
+	    obj = new;
+	    obj.value = idx;
+	    oq.push_back(obj);
+	 end
+	 while (oq.size() > 0) begin
+	    obj = oq.pop_front();
+	    osum = osum + obj.value;
+	 end
+	 $display("object: %0d", osum);
+      end
+
+      $finish;
+   end
+
+endmodule
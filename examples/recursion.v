@@ -0,0 +1,66 @@
+// Automatic functions and tasks: a doubly recursive fibonacci (+fib=N),
+// a linear recursion deep enough to keep thousands of contexts live at
+// once (+depth=N), and +tasks=N automatic tasks forked to run together.
+// Compile it with -g2009.
+
+module main;
+
+   function automatic integer fib(input integer n);
+      if (n < 2)
+	fib = n;
+      else
+	fib = fib(n-1) + fib(n-2);
+   endfunction
+
+   // Sum the numbers 1..n with one call per number, so the recursion
+   // is n calls deep.
+   function automatic integer walk(input integer n);
+      if (n == 0)
+	walk = 0;
+      else
+	walk = n + walk(n-1);
+   endfunction
+
+   integer task_sum, next_id;
+
+   // The workers run for different times, so they finish in a
+   // different order than they were started. Each one takes its id
+   // from next_id when it starts to run.
+   task automatic worker;
+      integer id, idx;
+      begin
+	 id = next_id;
+	 next_id = next_id + 1;
+	 for (idx = 0 ; idx <= id % 16 ; idx = idx + 1)
+	   #1 task_sum = task_sum + id;
+      end
+   endtask
+
+   integer nfib, depth, ntasks, rep, result, idx;
+
+   initial begin
+      if (!$value$plusargs("fib=%d", nfib))
+	nfib = 20;
+      if (!$value$plusargs("depth=%d", depth))
+	depth = 2000;
+      if (!$value$plusargs("tasks=%d", ntasks))
+	ntasks = 1000;
+
+      $display("fib(%0d) = %0d", nfib, fib(nfib));
+
+      result = 0;
+      for (rep = 0 ; rep < 20 ; rep = rep + 1)
+	result = result + walk(depth);
+      $display("walk(%0d) x 20 = %0d", depth, result);
+
+      task_sum = 0;
+      next_id = 0;
+      for (idx = 0 ; idx < ntasks ; idx = idx + 1)
+	fork : spawn
+	   worker;
+	join_none
+      #20 $display("tasks(%0d) = %0d", ntasks, task_sum);
+      $finish;
+   end
+
+endmodule
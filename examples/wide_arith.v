@@ -0,0 +1,52 @@
+// Modular products of WIDTH bit operands (1024 bits by default), done
+// with the procedural * / % operators and again with continuous assigns.
+// Each step checks that the quotient and remainder give back the
+// product. +count=N sets the number of steps.
+
+module main;
+
+   parameter WIDTH = 1024;
+
+   reg  [WIDTH-1:0] x, m;
+   reg  [2*WIDTH-1:0] prod, quot, rem;
+   wire [2*WIDTH-1:0] net_prod = x * x;
+   wire [2*WIDTH-1:0] net_quot = net_prod / m;
+   wire [2*WIDTH-1:0] net_rem  = net_prod % m;
+   reg  [WIDTH-1:0] sum;
+   integer count, idx, word, errors;
+
+   initial begin
+      if (!$value$plusargs("count=%d", count))
+	count = 500;
+
+      // A random odd modulus, and a random starting value below it.
+      for (word = 0 ; word < WIDTH/32 ; word = word + 1) begin
+	 m[word*32 +: 32] = $random;
+	 x[word*32 +: 32] = $random;
+      end
+      m[WIDTH-1] = 1'b1;
+      m[0] = 1'b1;
+      x[WIDTH-1] = 1'b0;
+
+      errors = 0;
+      sum = 0;
+      for (idx = 0 ; idx < count ; idx = idx + 1) begin
+	 prod = x * x;
+	 quot = prod / m;
+	 rem = prod % m;
+	 if (quot * m + rem !== prod)
+	   errors = errors + 1;
+	 #1 if (net_quot !== quot || net_rem !== rem)
+	   errors = errors + 1;
+	 // Keep the next operand below the modulus, and make it
+	 // change even if the chain reaches a fixed point.
+	 x = rem[WIDTH-1:0] ^ idx;
+	 sum = sum ^ x;
+      end
+
+      $display("width=%0d count=%0d errors=%0d sum=%h",
+	       WIDTH, count, errors, sum[63:0]);
+      $finish;
+   end
+
+endmodule
@@ -245,6 +245,31 @@ static int eval_object_signal(ivl_expr_t expr)
       return 0;
 }
 
+/*
+ * A pop_back or pop_front of a queue of class objects leaves the
+ * popped object on the top of the object stack.
+ */
+static int eval_object_sfunc(ivl_expr_t ex)
+{
+      const char*fb;
+
+      if (strcmp(ivl_expr_name(ex), "$ivl_darray_method$pop_back")==0)
+	    fb = "b";
+      else if (strcmp(ivl_expr_name(ex), "$ivl_darray_method$pop_front")==0)
+	    fb = "f";
+      else {
+	    fprintf(vvp_out, "; ERROR: draw_eval_object: Invalid function %s\n",
+		    ivl_expr_name(ex));
+	    return 1;
+      }
+
+      ivl_expr_t arg = ivl_expr_parm(ex, 0);
+      assert(ivl_expr_type(arg) == IVL_EX_SIGNAL);
+
+      fprintf(vvp_out, "    %%qpop/%s/obj v%p_0;\n", fb, ivl_expr_signal(arg));
+      return 0;
+}
+
 static int eval_object_ufunc(ivl_expr_t ex)
 {
       draw_ufunc_object(ex);
@@ -279,6 +304,9 @@ int draw_eval_object(ivl_expr_t ex)
 	  case IVL_EX_SIGNAL:
 	    return eval_object_signal(ex);
 
+	  case IVL_EX_SFUNC:
+	    return eval_object_sfunc(ex);
+
 	  case IVL_EX_UFUNC:
 	    return eval_object_ufunc(ex);
 
@@ -1765,8 +1765,20 @@ static int show_push_frontback_method(ivl_statement_t net, bool is_front)
 	    draw_eval_string(parm1);
 	    fprintf(vvp_out, "    %%store/%s/str v%p_0;\n", type_code, var);
 	    break;
+	  case IVL_VT_CLASS:
+	    draw_eval_object(parm1);
+	    fprintf(vvp_out, "    %%store/%s/obj v%p_0;\n", type_code, var);
+	    break;
+	  case IVL_VT_BOOL:
+	      /* 2-state items go to a queue that packs them. */
+	    draw_eval_vec4(parm1);
+	    resize_vec4_wid(parm1, width_of_packed_type(element_type));
+	    fprintf(vvp_out, "    %%store/%s/vec2 v%p_0, %u;\n",
+		    type_code, var, width_of_packed_type(element_type));
+	    break;
 	  default:
 	    draw_eval_vec4(parm1);
+	    resize_vec4_wid(parm1, width_of_packed_type(element_type));
 	    fprintf(vvp_out, "    %%store/%s/v v%p_0, %u;\n",
 		    type_code, var, width_of_packed_type(element_type));
 	    break;
@@ -25,7 +25,9 @@
 # include  <climits>
 # include  <cmath> // Needed to get pow for as_double().
 # include  <cstdio> // Needed to get snprintf for as_string().
+# include  <cstring>
 # include  <algorithm>
+# include  <vector>
 
 #if !defined(HAVE_LROUND)
 /*
@@ -44,18 +46,141 @@ extern "C" long int lround(double x)
 
 static verinum::V add_with_carry(verinum::V l, verinum::V r, verinum::V&c);
 
+static const unsigned WORD_BITS = 64;
+
+static inline unsigned words_for(unsigned nbits)
+{
+      return (nbits + WORD_BITS - 1) / WORD_BITS;
+}
+
+/*
+ * Return a mask of the valid bits in word idx of a number that is
+ * nbits wide.
+ */
+static inline uint64_t word_mask(unsigned idx, unsigned nbits)
+{
+      unsigned base = idx * WORD_BITS;
+      if (base >= nbits)
+	    return 0;
+      if (nbits - base >= WORD_BITS)
+	    return ~(uint64_t)0;
+      return ((uint64_t)1 << (nbits - base)) - 1;
+}
+
+static inline uint64_t pad_abits(verinum::V pad)
+{
+      return (pad == verinum::V1 || pad == verinum::Vx)? ~(uint64_t)0 : 0;
+}
+
+static inline uint64_t pad_bbits(verinum::V pad)
+{
+      return (pad == verinum::Vx || pad == verinum::Vz)? ~(uint64_t)0 : 0;
+}
+
+static inline unsigned highest_bit(uint64_t val)
+{
+      assert(val != 0);
+      unsigned res = 0;
+      for (unsigned step = WORD_BITS/2 ; step > 0 ; step /= 2) {
+	    if (val >> step) {
+		  val >>= step;
+		  res += step;
+	    }
+      }
+      return res;
+}
+
+/*
+ * Return the index of the most significant bit below len that is
+ * different from pad, or -1 if all those bits match the pad.
+ */
+static int highest_diff(const verinum&val, unsigned len, verinum::V pad)
+{
+      uint64_t pa = pad_abits(pad);
+      uint64_t pb = pad_bbits(pad);
+      for (unsigned idx = words_for(len) ; idx > 0 ; idx -= 1) {
+	    uint64_t diff = (val.get_abits(idx-1) ^ pa) | (val.get_bbits(idx-1) ^ pb);
+	    diff &= word_mask(idx-1, len);
+	    if (diff)
+		  return (idx-1)*WORD_BITS + highest_bit(diff);
+      }
+      return -1;
+}
+
+/*
+ * Return the 64 bits of the A (or B) plane of val starting at bit
+ * off. Bits below bit 0 read as 0 and bits past the end read as pad.
+ */
+static uint64_t bits_at(const verinum&val, bool bplane, int64_t off,
+			verinum::V pad)
+{
+      if (off <= -(int64_t)WORD_BITS)
+	    return 0;
+
+      if (off < 0) {
+	    uint64_t word = bplane? val.get_bbits(0, pad) : val.get_abits(0, pad);
+	    return word << (-off);
+      }
+
+      unsigned idx = off / WORD_BITS;
+      unsigned shift = off % WORD_BITS;
+      uint64_t lo = bplane? val.get_bbits(idx, pad) : val.get_abits(idx, pad);
+      if (shift == 0)
+	    return lo;
+
+      uint64_t hi = bplane? val.get_bbits(idx+1, pad) : val.get_abits(idx+1, pad);
+      return (lo >> shift) | (hi << (WORD_BITS - shift));
+}
+
+/*
+ * Copy wid bits from the src words into the dst words starting at
+ * bit off of the destination.
+ */
+static void insert_bits(uint64_t*dst, unsigned off, const uint64_t*src,
+			unsigned wid)
+{
+      for (unsigned idx = 0 ; idx < wid ; idx += WORD_BITS) {
+	    unsigned cnt = min(WORD_BITS, wid - idx);
+	    uint64_t mask = word_mask(0, cnt);
+	    uint64_t val = src[idx/WORD_BITS] & mask;
+
+	    unsigned pos = off + idx;
+	    unsigned wdx = pos / WORD_BITS;
+	    unsigned shift = pos % WORD_BITS;
+	    dst[wdx] = (dst[wdx] & ~(mask << shift)) | (val << shift);
+	    if (shift != 0 && shift + cnt > WORD_BITS) {
+		  unsigned back = WORD_BITS - shift;
+		  dst[wdx+1] = (dst[wdx+1] & ~(mask >> back)) | (val >> back);
+	    }
+      }
+}
+
+void verinum::allocate_(unsigned nbits)
+{
+      nbits_ = nbits;
+      unsigned nw = words_for(nbits);
+      if (nw == 0) {
+	    abits_ = 0;
+	    bbits_ = 0;
+	    return;
+      }
+
+      abits_ = new uint64_t[2*nw];
+      bbits_ = abits_ + nw;
+      memset(abits_, 0, 2*nw*sizeof(uint64_t));
+}
+
 verinum::verinum()
-: bits_(0), nbits_(0), has_len_(false), has_sign_(false), is_single_(false), string_flag_(false)
+: abits_(0), bbits_(0), nbits_(0), has_len_(false), has_sign_(false), is_single_(false), string_flag_(false)
 {
 }
 
 verinum::verinum(const V*bits, unsigned nbits, bool has_len__)
 : has_len_(has_len__), has_sign_(false), is_single_(false), string_flag_(false)
 {
-      nbits_ = nbits;
-      bits_ = new V [nbits];
+      allocate_(nbits);
       for (unsigned idx = 0 ;  idx < nbits ;  idx += 1) {
-	    bits_[idx] = bits[idx];
+	    set(idx, bits[idx]);
       }
 }
 
@@ -116,58 +241,43 @@ verinum::verinum(const string&s)
 : has_len_(true), has_sign_(false), is_single_(false), string_flag_(true)
 {
       string str = process_verilog_string_quotes(s);
-      nbits_ = str.length() * 8;
 
 	// Special case: The string "" is 8 bits of 0.
-      if (nbits_ == 0) {
-	    nbits_ = 8;
-	    bits_ = new V [nbits_];
-	    bits_[0] = V0;
-	    bits_[1] = V0;
-	    bits_[2] = V0;
-	    bits_[3] = V0;
-	    bits_[4] = V0;
-	    bits_[5] = V0;
-	    bits_[6] = V0;
-	    bits_[7] = V0;
+      if (str.length() == 0) {
+	    allocate_(8);
 	    return;
       }
 
-      bits_ = new V [nbits_];
+      allocate_(str.length() * 8);
 
-      unsigned idx, cp;
-      V*bp = bits_+nbits_;
-      for (idx = nbits_, cp = 0 ;  idx > 0 ;  idx -= 8, cp += 1) {
-	    char ch = str[cp];
-	    *(--bp) = (ch&0x80) ? V1 : V0;
-	    *(--bp) = (ch&0x40) ? V1 : V0;
-	    *(--bp) = (ch&0x20) ? V1 : V0;
-	    *(--bp) = (ch&0x10) ? V1 : V0;
-	    *(--bp) = (ch&0x08) ? V1 : V0;
-	    *(--bp) = (ch&0x04) ? V1 : V0;
-	    *(--bp) = (ch&0x02) ? V1 : V0;
-	    *(--bp) = (ch&0x01) ? V1 : V0;
+	// The first character of the string is the most significant
+	// byte of the number.
+      unsigned cp = str.length();
+      for (unsigned idx = 0 ;  idx < nbits_ ;  idx += 8) {
+	    unsigned char ch = str[--cp];
+	    abits_[idx/WORD_BITS] |= (uint64_t)ch << (idx%WORD_BITS);
       }
 }
 
 verinum::verinum(verinum::V val, unsigned n, bool h)
 : has_len_(h), has_sign_(false), is_single_(false), string_flag_(false)
 {
-      nbits_ = n;
-      bits_ = new V[nbits_];
-      for (unsigned idx = 0 ;  idx < nbits_ ;  idx += 1)
-	    bits_[idx] = val;
+      allocate_(n);
+      uint64_t pa = pad_abits(val);
+      uint64_t pb = pad_bbits(val);
+      for (unsigned idx = 0 ;  idx < nwords() ;  idx += 1) {
+	    uint64_t mask = word_mask(idx, nbits_);
+	    abits_[idx] = pa & mask;
+	    bbits_[idx] = pb & mask;
+      }
 }
 
 verinum::verinum(uint64_t val, unsigned n)
 : has_len_(true), has_sign_(false), is_single_(false), string_flag_(false)
 {
-      nbits_ = n;
-      bits_ = new V[nbits_];
-      for (unsigned idx = 0 ;  idx < nbits_ ;  idx += 1) {
-	    bits_[idx] = (val&1) ? V1 : V0;
-	    val >>= (uint64_t)1;
-      }
+      allocate_(n);
+      if (nbits_ > 0)
+	    abits_[0] = val & word_mask(0, nbits_);
 }
 
 /* The second argument is not used! It is there to make this
@@ -182,9 +292,8 @@ verinum::verinum(double val, bool)
 
 	/* We return `bx for a NaN or +/- infinity. */
       if (val != val || (val && (val == 0.5*val))) {
-	    nbits_ = 1;
-	    bits_ = new V[nbits_];
-	    bits_[0] = Vx;
+	    allocate_(1);
+	    set(0, Vx);
 	    return;
       }
 
@@ -200,17 +309,13 @@ verinum::verinum(double val, bool)
 
 	/* Get the exponent and fractional part of the number. */
       fraction = frexp(val, &exponent);
-      nbits_ = exponent+1;
-      bits_ = new V[nbits_];
+      allocate_(exponent+1);
 
 	/* If the value is small enough just use lround(). */
       if (nbits_ <= BITS_IN_LONG) {
 	    long sval = lround(val);
 	    if (is_neg) sval = -sval;
-	    for (unsigned idx = 0; idx < nbits_; idx += 1) {
-		  bits_[idx] = (sval&1) ? V1 : V0;
-		  sval >>= 1;
-	    }
+	    abits_[0] = (uint64_t)(int64_t)sval & word_mask(0, nbits_);
 	      /* Trim the result. */
 	    signed_trim();
 	    return;
@@ -224,7 +329,7 @@ verinum::verinum(double val, bool)
 	    unsigned long bits = (unsigned long) fraction;
 	    fraction = fraction - (double) bits;
 	    for (unsigned idx = 0; idx < nbits_; idx += 1) {
-		  bits_[idx] = (bits&1) ? V1 : V0;
+		  set(idx, (bits&1) ? V1 : V0);
 		  bits >>= 1;
 	    }
       } else {
@@ -234,7 +339,7 @@ verinum::verinum(double val, bool)
 		  unsigned max_idx = (wd+1)*BITS_IN_LONG;
 		  if (max_idx > nbits_) max_idx = nbits_;
 		  for (unsigned idx = wd*BITS_IN_LONG; idx < max_idx; idx += 1) {
-			bits_[idx] = (bits&1) ? V1 : V0;
+			set(idx, (bits&1) ? V1 : V0);
 			bits >>= 1;
 		  }
 		  fraction = ldexp(fraction, BITS_IN_LONG);
@@ -255,63 +360,51 @@ verinum::verinum(double val, bool)
  * extra sign bits that can occur when calculating a negative value. */
 void verinum::signed_trim()
 {
-	/* Do we have any extra digits? */
-      unsigned tlen = nbits_-1;
-      verinum::V sign = bits_[tlen];
-      while ((tlen > 0) && (bits_[tlen] == sign)) tlen -= 1;
-
-	/* tlen now points to the first digit that is not the sign.
-	 * or bit 0. Set the length to include this bit and one proper
+	/* Find the first digit that is not the sign, if there is
+	 * one. Set the length to include this bit and one proper
 	 * sign bit if needed. */
-      if (bits_[tlen] != sign) tlen += 1;
-      tlen += 1;
+      int top = highest_diff(*this, nbits_, get(nbits_-1));
+      unsigned tlen = top < 0? 1 : top + 2;
 
 	/* Trim the bits if needed. */
       if (tlen < nbits_) {
-	    V* tbits = new V[tlen];
-	    for (unsigned idx = 0; idx < tlen; idx += 1)
-		  tbits[idx] = bits_[idx];
-	    delete[] bits_;
-	    bits_ = tbits;
-	    nbits_ = tlen;
+	    verinum tmp (*this, tlen);
+	    tmp.has_len_ = has_len_;
+	    tmp.string_flag_ = string_flag_;
+	    tmp.is_single_ = is_single_;
+	    *this = tmp;
       }
 }
 
 verinum::verinum(const verinum&that)
 {
       string_flag_ = that.string_flag_;
-      nbits_ = that.nbits_;
-      bits_ = new V[nbits_];
       has_len_ = that.has_len_;
       has_sign_ = that.has_sign_;
       is_single_ = that.is_single_;
-      for (unsigned idx = 0 ;  idx < nbits_ ;  idx += 1)
-	    bits_[idx] = that.bits_[idx];
+      allocate_(that.nbits_);
+      if (nbits_ > 0)
+	    memcpy(abits_, that.abits_, 2*nwords()*sizeof(uint64_t));
 }
 
 verinum::verinum(const verinum&that, unsigned nbits)
 {
       string_flag_ = that.string_flag_ && (that.nbits_ == nbits);
-      nbits_ = nbits;
-      bits_ = new V[nbits_];
       has_len_ = true;
       has_sign_ = that.has_sign_;
       is_single_ = false;
+      allocate_(nbits);
 
-      unsigned copy = nbits;
-      if (copy > that.nbits_)
-	    copy = that.nbits_;
-      for (unsigned idx = 0 ;  idx < copy ;  idx += 1)
-	    bits_[idx] = that.bits_[idx];
+	// If this is wider than the source, pad with the sign bit if
+	// this is signed, or with zero.
+      V pad = V0;
+      if (that.nbits_ > 0 && (has_sign_ || that.is_single_))
+	    pad = that.get(that.nbits_-1);
 
-      if (copy < nbits_) {
-	    if (has_sign_ || that.is_single_) {
-		  for (unsigned idx = copy ;  idx < nbits_ ;  idx += 1)
-			bits_[idx] = bits_[idx-1];
-	    } else {
-		  for (unsigned idx = copy ;  idx < nbits_ ;  idx += 1)
-			bits_[idx] = verinum::V0;
-	    }
+      for (unsigned idx = 0 ;  idx < nwords() ;  idx += 1) {
+	    uint64_t mask = word_mask(idx, nbits_);
+	    abits_[idx] = that.get_abits(idx, pad) & mask;
+	    bbits_[idx] = that.get_bbits(idx, pad) & mask;
       }
 }
 
@@ -322,36 +415,37 @@ verinum::verinum(int64_t that)
 
       if (that < 0) tmp = (that+1)/2;
       else tmp = that/2;
-      nbits_ = 1;
+      unsigned nbits = 1;
       while (tmp != 0) {
-	    nbits_ += 1;
+	    nbits += 1;
 	    tmp /= 2;
       }
 
-      nbits_ += 1;
+      nbits += 1;
 
-      bits_ = new V[nbits_];
-      for (unsigned idx = 0 ;  idx < nbits_ ;  idx += 1) {
-	    bits_[idx] = (that & 1)? V1 : V0;
-	    that >>= 1;
+      allocate_(nbits);
+      uint64_t pad = that < 0? ~(uint64_t)0 : 0;
+      for (unsigned idx = 0 ;  idx < nwords() ;  idx += 1) {
+	    uint64_t word = idx == 0? (uint64_t)that : pad;
+	    abits_[idx] = word & word_mask(idx, nbits_);
       }
 }
 
 verinum::~verinum()
 {
-      delete[]bits_;
+      delete[]abits_;
 }
 
 verinum& verinum::operator= (const verinum&that)
 {
       if (this == &that) return *this;
-      if (nbits_ != that.nbits_) {
-            delete[]bits_;
-            nbits_ = that.nbits_;
-            bits_ = new V[that.nbits_];
+      if (nwords() != that.nwords()) {
+            delete[]abits_;
+            allocate_(that.nbits_);
       }
-      for (unsigned idx = 0 ;  idx < nbits_ ;  idx += 1)
-	    bits_[idx] = that.bits_[idx];
+      nbits_ = that.nbits_;
+      if (nbits_ > 0)
+	    memcpy(abits_, that.abits_, 2*nwords()*sizeof(uint64_t));
 
       has_len_ = that.has_len_;
       has_sign_ = that.has_sign_;
@@ -363,77 +457,89 @@ verinum& verinum::operator= (const verinum&that)
 verinum::V verinum::get(unsigned idx) const
 {
       assert(idx < nbits_);
-      return bits_[idx];
+      static const V vals[4] = { V0, V1, Vz, Vx };
+      unsigned wdx = idx / WORD_BITS;
+      unsigned shift = idx % WORD_BITS;
+      unsigned a = (abits_[wdx] >> shift) & 1;
+      unsigned b = (bbits_[wdx] >> shift) & 1;
+      return vals[a | (b << 1)];
 }
 
 verinum::V verinum::set(unsigned idx, verinum::V val)
 {
       assert(idx < nbits_);
-      return bits_[idx] = val;
+      unsigned wdx = idx / WORD_BITS;
+      uint64_t mask = (uint64_t)1 << (idx % WORD_BITS);
+      abits_[wdx] = (abits_[wdx] & ~mask) | (pad_abits(val) & mask);
+      bbits_[wdx] = (bbits_[wdx] & ~mask) | (pad_bbits(val) & mask);
+      return val;
 }
 
 void verinum::set(unsigned off, const verinum&val)
 {
       assert(off + val.len() <= nbits_);
-      for (unsigned idx = 0 ; idx < val.len() ; idx += 1)
-	    bits_[off+idx] = val[idx];
+      insert_bits(abits_, off, val.abits_, val.nbits_);
+      insert_bits(bbits_, off, val.bbits_, val.nbits_);
 }
 
-unsigned verinum::as_unsigned() const
+uint64_t verinum::get_abits(unsigned idx, V pad) const
 {
-      if (nbits_ == 0)
-	    return 0;
-
-      if (!is_defined())
-	    return 0;
+      uint64_t mask = word_mask(idx, nbits_);
+      uint64_t word = mask? abits_[idx] : 0;
+      return word | (pad_abits(pad) & ~mask);
+}
 
-      unsigned val = 0;
-      unsigned mask = 1;
-      for (unsigned idx = 0 ;  idx < nbits_ ;  idx += 1, mask <<= 1)
-	    if (bits_[idx] == V1) {
-		  if (mask == 0) return ~mask;
-		  val |= mask;
-	    }
+uint64_t verinum::get_bbits(unsigned idx, V pad) const
+{
+      uint64_t mask = word_mask(idx, nbits_);
+      uint64_t word = mask? bbits_[idx] : 0;
+      return word | (pad_bbits(pad) & ~mask);
+}
 
-      return val;
+void verinum::set_bits(unsigned idx, uint64_t abits, uint64_t bbits)
+{
+      assert(idx < nwords());
+      uint64_t mask = word_mask(idx, nbits_);
+      abits_[idx] = abits & mask;
+      bbits_[idx] = bbits & mask;
 }
 
-unsigned long verinum::as_ulong() const
+/*
+ * Return the value of a defined number as an unsigned integer that is
+ * wid bits wide. If any bits past that are set, return all ones.
+ */
+static uint64_t as_unsigned_wid(const verinum&val, unsigned wid)
 {
-      if (nbits_ == 0)
+      if (val.len() == 0)
 	    return 0;
 
-      if (!is_defined())
+      if (!val.is_defined())
 	    return 0;
 
-      unsigned long val = 0;
-      unsigned long mask = 1;
-      for (unsigned idx = 0 ;  idx < nbits_ ;  idx += 1, mask <<= 1)
-	    if (bits_[idx] == V1) {
-		  if (mask == 0) return ~mask;
-		  val |= mask;
-	    }
-
-      return val;
+      uint64_t max = word_mask(0, wid);
+      uint64_t res = val.get_abits(0);
+      if (res & ~max)
+	    return max;
+      for (unsigned idx = 1 ;  idx < val.nwords() ;  idx += 1) {
+	    if (val.get_abits(idx))
+		  return max;
+      }
+      return res;
 }
 
-uint64_t verinum::as_ulong64() const
+unsigned verinum::as_unsigned() const
 {
-      if (nbits_ == 0)
-	    return 0;
-
-      if (!is_defined())
-	    return 0;
+      return as_unsigned_wid(*this, 8*sizeof(unsigned));
+}
 
-      uint64_t val = 0;
-      uint64_t mask = 1;
-      for (unsigned idx = 0 ;  idx < nbits_ ;  idx += 1, mask <<= 1)
-	    if (bits_[idx] == V1) {
-		  if (mask == 0) return ~mask;
-		  val |= mask;
-	    }
+unsigned long verinum::as_ulong() const
+{
+      return as_unsigned_wid(*this, 8*sizeof(unsigned long));
+}
 
-      return val;
+uint64_t verinum::as_ulong64() const
+{
+      return as_unsigned_wid(*this, 8*sizeof(uint64_t));
 }
 
 /*
@@ -466,28 +572,15 @@ signed long verinum::as_long() const
       }
       int lost_bits=0;
 
-      if (has_sign_ && (bits_[nbits_-1] == V1)) {
-	    val = -1;
-	    signed long mask = ~1L;
-	    for (unsigned idx = 0 ;  idx < top ;  idx += 1) {
-		  if (bits_[idx] == V0) val &= mask;
-		  mask = (mask << 1) | 1L;
-	    }
-	    if (diag_top) {
-		  for (unsigned idx = top; idx < diag_top; idx += 1) {
-			if (bits_[idx] == V0) lost_bits=1;
-		  }
-	    }
+      uint64_t mask = word_mask(0, top);
+      if (has_sign_ && (get(nbits_-1) == V1)) {
+	    val = (signed long)(int64_t)(abits_[0] | ~mask);
+	    if (diag_top && highest_diff(*this, diag_top, V1) >= (int)top)
+		  lost_bits=1;
       } else {
-	    signed long mask = 1;
-	    for (unsigned idx = 0 ;  idx < top ;  idx += 1, mask <<= 1) {
-		  if (bits_[idx] == V1) val |= mask;
-	    }
-	    if (diag_top) {
-		  for (unsigned idx = top; idx < diag_top; idx += 1) {
-			if (bits_[idx] == V1) lost_bits=1;
-		  }
-	    }
+	    val = (signed long)(abits_[0] & mask);
+	    if (diag_top && highest_diff(*this, diag_top, V0) >= (int)top)
+		  lost_bits=1;
       }
 
       if (lost_bits) cerr << "warning: verinum::as_long() truncated " <<
@@ -502,17 +595,17 @@ double verinum::as_double() const
 
       double val = 0.0;
         /* Do we have/want a signed value? */
-      if (has_sign_ && bits_[nbits_-1] == V1) {
+      if (has_sign_ && get(nbits_-1) == V1) {
 	    V carry = V1;
 	    for (unsigned idx = 0; idx < nbits_; idx += 1) {
-		  V sum = add_with_carry(~bits_[idx], V0, carry);
+		  V sum = add_with_carry(~get(idx), V0, carry);
 		  if (sum == V1)
 			val += pow(2.0, (double)idx);
 	    }
 	    val *= -1.0;
       } else {
 	    for (unsigned idx = 0; idx < nbits_; idx += 1) {
-		  if (bits_[idx] == V1)
+		  if (get(idx) == V1)
 			val += pow(2.0, (double)idx);
 	    }
       }
@@ -527,17 +620,10 @@ string verinum::as_string() const
 
       string res;
       for (unsigned idx = nbits_ ;  idx > 0 ;  idx -= 8) {
-	    char char_val = 0;
-	    V*bp = bits_+idx;
-
-	    if (*(--bp) == V1) char_val |= 0x80;
-	    if (*(--bp) == V1) char_val |= 0x40;
-	    if (*(--bp) == V1) char_val |= 0x20;
-	    if (*(--bp) == V1) char_val |= 0x10;
-	    if (*(--bp) == V1) char_val |= 0x08;
-	    if (*(--bp) == V1) char_val |= 0x04;
-	    if (*(--bp) == V1) char_val |= 0x02;
-	    if (*(--bp) == V1) char_val |= 0x01;
+	    unsigned wdx = (idx-8) / WORD_BITS;
+	    unsigned shift = (idx-8) % WORD_BITS;
+	    uint64_t ones = abits_[wdx] & ~bbits_[wdx];
+	    char char_val = (char)((ones >> shift) & 0xff);
 
 	    if (char_val == '"' || char_val == '\\') {
 		  char tmp[5];
@@ -559,55 +645,58 @@ bool verinum::is_before(const verinum&that) const
       if (that.nbits_ > nbits_) return true;
       if (that.nbits_ < nbits_) return false;
 
-      for (unsigned idx = nbits_  ;  idx > 0 ;  idx -= 1) {
-	    if (bits_[idx-1] < that.bits_[idx-1]) return true;
-	    if (bits_[idx-1] > that.bits_[idx-1]) return false;
+      for (unsigned idx = nwords() ;  idx > 0 ;  idx -= 1) {
+	    uint64_t diff = (abits_[idx-1] ^ that.abits_[idx-1])
+		  | (bbits_[idx-1] ^ that.bbits_[idx-1]);
+	    if (diff == 0)
+		  continue;
+
+	    unsigned bit = (idx-1)*WORD_BITS + highest_bit(diff);
+	    return get(bit) < that.get(bit);
       }
       return false;
 }
 
 bool verinum::is_defined() const
 {
-      for (unsigned idx = 0 ;  idx < nbits_ ;  idx += 1) {
-	    if (bits_[idx] == Vx) return false;
-	    if (bits_[idx] == Vz) return false;
+      for (unsigned idx = 0 ;  idx < nwords() ;  idx += 1) {
+	    if (bbits_[idx]) return false;
       }
       return true;
 }
 
 bool verinum::is_zero() const
 {
-      for (unsigned idx = 0 ;  idx < nbits_ ;  idx += 1)
-	    if (bits_[idx] != V0) return false;
+      for (unsigned idx = 0 ;  idx < nwords() ;  idx += 1)
+	    if (abits_[idx] | bbits_[idx]) return false;
 
       return true;
 }
 
 bool verinum::is_negative() const
 {
-      return (bits_[nbits_-1] == V1) && has_sign();
+      return (get(nbits_-1) == V1) && has_sign();
 }
 
 unsigned verinum::significant_bits() const
 {
-      unsigned sbits = nbits_;
+      if (nbits_ == 0)
+	    return 0;
 
       if (has_sign_) {
-	    V sign_bit = bits_[sbits-1];
-	    while ((sbits > 1) && (bits_[sbits-2] == sign_bit))
-		  sbits -= 1;
+	    int top = highest_diff(*this, nbits_-1, get(nbits_-1));
+	    return top + 2;
       } else {
-	    while ((sbits > 1) && (bits_[sbits-1] == verinum::V0))
-		  sbits -= 1;
+	    int top = highest_diff(*this, nbits_, V0);
+	    return top < 0? 1 : top + 1;
       }
-      return sbits;
 }
 
 void verinum::cast_to_int2()
 {
-      for (unsigned idx = 0 ;  idx < nbits_ ;  idx += 1) {
-	    if (bits_[idx] == Vx || bits_[idx] == Vz)
-		  bits_[idx] = V0;
+      for (unsigned idx = 0 ;  idx < nwords() ;  idx += 1) {
+	    abits_[idx] &= ~bbits_[idx];
+	    bbits_[idx] = 0;
       }
 }
 
@@ -633,9 +722,7 @@ verinum pad_to_width(const verinum&that, unsigned width)
       }
 
       verinum val(pad, width, that.has_len());
-
-      for (unsigned idx = 0 ;  idx < that.len() ;  idx += 1)
-	    val.set(idx, that[idx]);
+      val.set(0, that);
 
       val.has_sign(that.has_sign());
       if (that.is_string() && (width % 8) == 0) {
@@ -669,9 +756,7 @@ verinum cast_to_width(const verinum&that, unsigned width)
       }
 
       verinum val(pad, width, true);
-
-      for (unsigned idx = 0 ;  idx < that.len() ;  idx += 1)
-	    val.set(idx, that[idx]);
+      val.set(0, that);
 
       val.has_sign(that.has_sign());
       return val;
@@ -696,48 +781,35 @@ verinum trim_vnum(const verinum&that)
 	    return that;
 
       if (that.has_sign()) {
-	    unsigned top = that.len()-1;
-	    verinum::V sign = that.get(top);
-
-	    while ((top > 0) && (that.get(top) == sign))
-		  top -= 1;
+	    verinum::V sign = that.get(that.len()-1);
 
-	      /* top points to the first digit that is not the
-		 sign. Set the length to include this and one proper
-		 sign bit. */
-
-	    if (that.get(top) != sign)
-		  top += 1;
-
-	    tlen = top+1;
+	      /* Find the first digit that is not the sign. Set the
+		 length to include this and one proper sign bit. */
+	    int top = highest_diff(that, that.len(), sign);
+	    tlen = top < 0? 1 : top + 2;
 
       } else {
 
 	      /* If the result is unsigned and has an indefinite
 		 length, then trim off all but one leading zero. */
-	    unsigned top = that.len()-1;
-	    while ((top > 0) && (that.get(top) == verinum::V0))
-		  top -= 1;
+	    int top = highest_diff(that, that.len(), verinum::V0);
 
 	      /* Now top is the index of the highest non-zero bit. If
 		 that turns out to the highest bit in the vector, then
 		 there is no trimming possible. */
-	    if (top+1 == that.len())
+	    if (top+1 == (int)that.len())
 		  return that;
 
 	      /* Make tlen wide enough to include the highest non-zero
-		 bit, plus one extra 0 bit. */
-	    tlen = top+2;
-
-	      /* This can only happen when the verinum is all zeros,
-		 so make it a single bit wide. */
-	    if (that.get(top) == verinum::V0) tlen -= 1;
+		 bit, plus one extra 0 bit. If the verinum is all
+		 zeros, make it a single bit wide. */
+	    tlen = top < 0? 1 : top + 2;
       }
 
       verinum tmp (verinum::V0, tlen, false);
       tmp.has_sign(that.has_sign());
-      for (unsigned idx = 0 ;  idx < tmp.len() ;  idx += 1)
-	    tmp.set(idx, that.get(idx));
+      for (unsigned idx = 0 ;  idx < tmp.nwords() ;  idx += 1)
+	    tmp.set_bits(idx, that.get_abits(idx), that.get_bbits(idx));
 
       return tmp;
 }
@@ -842,16 +914,51 @@ verinum::V operator == (const verinum&left, const verinum&right)
       if (right.len() > max_len)
 	    max_len = right.len();
 
-      for (unsigned idx = 0 ;  idx < max_len ;  idx += 1) {
-	    verinum::V left_bit  = idx < left.len() ? left[idx]  : left_pad;
-	    verinum::V right_bit = idx < right.len()? right[idx] : right_pad;
-	    if (left_bit != right_bit)
+      for (unsigned idx = 0 ;  idx < words_for(max_len) ;  idx += 1) {
+	    uint64_t diff = (left.get_abits(idx, left_pad) ^ right.get_abits(idx, right_pad))
+		  | (left.get_bbits(idx, left_pad) ^ right.get_bbits(idx, right_pad));
+	    if (diff & word_mask(idx, max_len))
 		  return verinum::V0;
       }
 
       return verinum::V1;
 }
 
+/*
+ * Compare the bits that the left and right values have in common,
+ * from the most significant down. Return Vx if an x or z bit is found
+ * before a difference, otherwise V1 if left is less than right, V0 if
+ * it is greater, and if_equal if the bits are all the same.
+ */
+static verinum::V compare_common(const verinum&left, const verinum&right,
+				 verinum::V if_equal)
+{
+      unsigned len = min(left.len(), right.len());
+      for (unsigned idx = words_for(len) ;  idx > 0 ;  idx -= 1) {
+	    uint64_t xz = left.get_bbits(idx-1) | right.get_bbits(idx-1);
+	    uint64_t la = left.get_abits(idx-1);
+	    uint64_t diff = xz | (la ^ right.get_abits(idx-1));
+	    diff &= word_mask(idx-1, len);
+	    if (diff == 0)
+		  continue;
+
+	    uint64_t bit = (uint64_t)1 << highest_bit(diff);
+	    if (xz & bit) return verinum::Vx;
+	    if (la & bit) return verinum::V0;
+	    return verinum::V1;
+      }
+
+      return if_equal;
+}
+
+/*
+ * Return true if the bits of val from bit off up are not all pad.
+ */
+static bool differs_from_pad(const verinum&val, unsigned off, verinum::V pad)
+{
+      return highest_diff(val, val.len(), pad) >= (int)off;
+}
+
 verinum::V operator <= (const verinum&left, const verinum&right)
 {
       verinum::V left_pad = verinum::V0;
@@ -867,41 +974,19 @@ verinum::V operator <= (const verinum&left, const verinum&right)
 		  return verinum::V0;
       }
 
-      unsigned idx;
-      for (idx = left.len() ; idx > right.len() ;  idx -= 1) {
-	    if (left[idx-1] != right_pad) {
-		      // A change of padding for a negative left argument
-		      // denotes the left value is less than the right.
-		   return (signed_calc &&
-		           (left_pad == verinum::V1)) ? verinum::V1 :
-		                                        verinum::V0;
-	    }
-      }
+	// A change of padding for a negative left argument denotes
+	// the left value is less than the right.
+      if (left.len() > right.len() && differs_from_pad(left, right.len(), right_pad))
+	    return (signed_calc && (left_pad == verinum::V1)) ? verinum::V1 :
+							      verinum::V0;
 
-      for (idx = right.len() ; idx > left.len() ;  idx -= 1) {
-	    if (right[idx-1] != left_pad) {
-		      // A change of padding for a negative right argument
-		      // denotes the left value is not less than the right.
-		   return (signed_calc &&
-		           (right_pad == verinum::V1)) ? verinum::V0 :
-		                                         verinum::V1;
-	    }
-      }
+	// A change of padding for a negative right argument denotes
+	// the left value is not less than the right.
+      if (right.len() > left.len() && differs_from_pad(right, left.len(), left_pad))
+	    return (signed_calc && (right_pad == verinum::V1)) ? verinum::V0 :
+							       verinum::V1;
 
-      idx = right.len();
-      if (left.len() < idx) idx = left.len();
-
-      while (idx > 0) {
-	    if (left[idx-1] == verinum::Vx) return verinum::Vx;
-	    if (left[idx-1] == verinum::Vz) return verinum::Vx;
-	    if (right[idx-1] == verinum::Vx) return verinum::Vx;
-	    if (right[idx-1] == verinum::Vz) return verinum::Vx;
-	    if (left[idx-1] > right[idx-1]) return verinum::V0;
-	    if (left[idx-1] < right[idx-1]) return verinum::V1;
-	    idx -= 1;
-      }
-
-      return verinum::V1;
+      return compare_common(left, right, verinum::V1);
 }
 
 verinum::V operator < (const verinum&left, const verinum&right)
@@ -919,38 +1004,19 @@ verinum::V operator < (const verinum&left, const verinum&right)
 		  return verinum::V0;
       }
 
-      unsigned idx;
-      for (idx = left.len() ; idx > right.len() ;  idx -= 1) {
-	    if (left[idx-1] != right_pad) {
-		      // A change of padding for a negative left argument
-		      // denotes the left value is less than the right.
-		   return (signed_calc &&
-		           (left_pad == verinum::V1)) ? verinum::V1 :
-		                                        verinum::V0;
-	    }
-      }
+	// A change of padding for a negative left argument denotes
+	// the left value is less than the right.
+      if (left.len() > right.len() && differs_from_pad(left, right.len(), right_pad))
+	    return (signed_calc && (left_pad == verinum::V1)) ? verinum::V1 :
+							      verinum::V0;
 
-      for (idx = right.len() ; idx > left.len() ;  idx -= 1) {
-	    if (right[idx-1] != left_pad) {
-		      // A change of padding for a negative right argument
-		      // denotes the left value is not less than the right.
-		   return (signed_calc &&
-		           (right_pad == verinum::V1)) ? verinum::V0 :
-		                                         verinum::V1;
-	    }
-      }
-
-      while (idx > 0) {
-	    if (left[idx-1] == verinum::Vx) return verinum::Vx;
-	    if (left[idx-1] == verinum::Vz) return verinum::Vx;
-	    if (right[idx-1] == verinum::Vx) return verinum::Vx;
-	    if (right[idx-1] == verinum::Vz) return verinum::Vx;
-	    if (left[idx-1] > right[idx-1]) return verinum::V0;
-	    if (left[idx-1] < right[idx-1]) return verinum::V1;
-	    idx -= 1;
-      }
+	// A change of padding for a negative right argument denotes
+	// the left value is not less than the right.
+      if (right.len() > left.len() && differs_from_pad(right, left.len(), left_pad))
+	    return (signed_calc && (right_pad == verinum::V1)) ? verinum::V0 :
+							       verinum::V1;
 
-      return verinum::V0;
+      return compare_common(left, right, verinum::V0);
 }
 
 static verinum::V add_with_carry(verinum::V l, verinum::V r, verinum::V&c)
@@ -1001,38 +1067,106 @@ static verinum::V add_with_carry(verinum::V l, verinum::V r, verinum::V&c)
 	    return verinum::V0;
 }
 
+/*
+ * Add two words and a carry, and return the carry out in carry.
+ */
+static inline uint64_t add_with_carry(uint64_t l, uint64_t r, uint64_t&carry)
+{
+      uint64_t sum = l + r;
+      uint64_t res = sum + carry;
+      carry = (sum < l || res < sum)? 1 : 0;
+      return res;
+}
+
+/*
+ * Multiply two words and add a carry word. Return the low word of the
+ * result and leave the high word in carry. This works in 32 bit halves
+ * so that it does not need a double width integer type.
+ */
+static inline uint64_t multiply_with_carry(uint64_t a, uint64_t b, uint64_t&carry)
+{
+      const uint64_t LOW = 0xffffffffUL;
+      uint64_t a0 = a & LOW, a1 = a >> 32;
+      uint64_t b0 = b & LOW, b1 = b >> 32;
+
+      uint64_t p00 = a0 * b0;
+      uint64_t p01 = a0 * b1;
+      uint64_t p10 = a1 * b0;
+      uint64_t p11 = a1 * b1;
+
+      uint64_t mid = (p00 >> 32) + (p01 & LOW) + (p10 & LOW);
+      uint64_t lo = (p00 & LOW) | (mid << 32);
+      uint64_t hi = p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+
+      lo += carry;
+      if (lo < carry) hi += 1;
+      carry = hi;
+      return lo;
+}
+
 verinum operator ~ (const verinum&left)
 {
+	// A 0 becomes 1, a 1 becomes 0 and an x or z becomes x.
       verinum val = left;
-      for (unsigned idx = 0 ;  idx < val.len() ;  idx += 1)
-	    switch (val[idx]) {
-		case verinum::V0:
-		  val.set(idx, verinum::V1);
-		  break;
-		case verinum::V1:
-		  val.set(idx, verinum::V0);
-		  break;
-		default:
-		  val.set(idx, verinum::Vx);
-		  break;
-	    }
+      for (unsigned idx = 0 ;  idx < val.nwords() ;  idx += 1) {
+	    uint64_t bbits = left.get_bbits(idx);
+	    val.set_bits(idx, ~left.get_abits(idx) | bbits, bbits);
+      }
 
       return val;
 }
 
 /*
- * Addition and subtraction works a bit at a time, from the least
+ * Addition and subtraction works a word at a time, from the least
  * significant up to the most significant. The result is signed only
  * if both of the operands are signed. If either operand is unsized,
  * the result is expanded as needed to prevent overflow.
+ *
+ * The sum is calculated one bit wider than the widest operand, with
+ * both operands extended by their sign bit, so that the extra bit
+ * can be used to decide whether an unsized result needs to grow.
  */
+static verinum add_words(const verinum&left, const verinum&right, bool subtract,
+			 bool has_len_flag, bool signed_flag)
+{
+      unsigned max_len = max(left.len(), right.len());
+
+      verinum::V lpad = sign_bit(left);
+      verinum::V rpad = sign_bit(right);
+
+      unsigned nwords = words_for(max_len+1);
+      vector<uint64_t> sum (nwords);
+      uint64_t carry = subtract? 1 : 0;
+      for (unsigned idx = 0 ;  idx < nwords ;  idx += 1) {
+	    uint64_t rword = right.get_abits(idx, rpad);
+	    if (subtract) rword = ~rword;
+	    sum[idx] = add_with_carry(left.get_abits(idx, lpad), rword, carry);
+      }
+
+      unsigned len = max_len;
+      bool grow = false;
+      if (!has_len_flag && max_len > 0) {
+	    bool top = (sum[max_len/WORD_BITS] >> (max_len%WORD_BITS)) & 1;
+	    bool next = (sum[(max_len-1)/WORD_BITS] >> ((max_len-1)%WORD_BITS)) & 1;
+	    if (signed_flag)
+		  grow = top != next;
+	    else if (!subtract)
+		  grow = top;
+      }
+      if (grow) len += 1;
+
+      verinum result (verinum::V0, len, has_len_flag);
+      for (unsigned idx = 0 ;  idx < result.nwords() ;  idx += 1)
+	    result.set_bits(idx, sum[idx]);
+      result.has_sign(signed_flag);
+      return result;
+}
 
 verinum operator + (const verinum&left, const verinum&right)
 {
       const bool has_len_flag = left.has_len() && right.has_len();
       const bool signed_flag = left.has_sign() && right.has_sign();
 
-      unsigned min_len = min(left.len(), right.len());
       unsigned max_len = max(left.len(), right.len());
 
 	// If either the left or right values are undefined, the
@@ -1044,41 +1178,7 @@ verinum operator + (const verinum&left, const verinum&right)
 	    return result;
       }
 
-      verinum::V*val_bits = new verinum::V[max_len+1];
-
-      verinum::V carry = verinum::V0;
-      for (unsigned idx = 0 ;  idx < min_len ;  idx += 1)
-	    val_bits[idx] = add_with_carry(left[idx], right[idx], carry);
-
-      verinum::V rpad = sign_bit(right);
-      verinum::V lpad = sign_bit(left);
-
-      if (left.len() > right.len()) {
-
-	    for (unsigned idx = min_len ;  idx < max_len ;  idx += 1)
-		  val_bits[idx] = add_with_carry(left[idx], rpad, carry);
-
-      } else {
-
-	    for (unsigned idx = min_len ;  idx < max_len ;  idx += 1)
-		  val_bits[idx] = add_with_carry(lpad, right[idx], carry);
-      }
-
-      unsigned len = max_len;
-      if (!has_len_flag) {
-	    val_bits[max_len] = add_with_carry(lpad, rpad, carry);
-	    if (signed_flag) {
-		  if (val_bits[max_len] != val_bits[max_len-1]) len += 1;
-	    } else {
-		  if (val_bits[max_len] != verinum::V0) len += 1;
-	    }
-      }
-      verinum result (val_bits, len, has_len_flag);
-      result.has_sign(signed_flag);
-
-      delete[]val_bits;
-
-      return result;
+      return add_words(left, right, false, has_len_flag, signed_flag);
 }
 
 verinum operator - (const verinum&left, const verinum&right)
@@ -1086,7 +1186,6 @@ verinum operator - (const verinum&left, const verinum&right)
       const bool has_len_flag = left.has_len() && right.has_len();
       const bool signed_flag = left.has_sign() && right.has_sign();
 
-      unsigned min_len = min(left.len(), right.len());
       unsigned max_len = max(left.len(), right.len());
 
 	// If either the left or right values are undefined, the
@@ -1098,37 +1197,7 @@ verinum operator - (const verinum&left, const verinum&right)
 	    return result;
       }
 
-      verinum::V*val_bits = new verinum::V[max_len+1];
-
-      verinum::V carry = verinum::V1;
-      for (unsigned idx = 0 ;  idx < min_len ;  idx += 1)
-	    val_bits[idx] = add_with_carry(left[idx], ~right[idx], carry);
-
-      verinum::V rpad = sign_bit(right);
-      verinum::V lpad = sign_bit(left);
-
-      if (left.len() > right.len()) {
-
-	    for (unsigned idx = min_len ;  idx < max_len ;  idx += 1)
-		  val_bits[idx] = add_with_carry(left[idx], ~rpad, carry);
-
-      } else {
-
-	    for (unsigned idx = min_len ;  idx < max_len ;  idx += 1)
-		  val_bits[idx] = add_with_carry(lpad, ~right[idx], carry);
-      }
-
-      unsigned len = max_len;
-      if (signed_flag && !has_len_flag) {
-	    val_bits[max_len] = add_with_carry(lpad, ~rpad, carry);
-	    if (val_bits[max_len] != val_bits[max_len-1]) len += 1;
-      }
-      verinum result (val_bits, len, has_len_flag);
-      result.has_sign(signed_flag);
-
-      delete[]val_bits;
-
-      return result;
+      return add_words(left, right, true, has_len_flag, signed_flag);
 }
 
 verinum operator - (const verinum&right)
@@ -1146,22 +1215,10 @@ verinum operator - (const verinum&right)
 	    return result;
       }
 
-      verinum::V*val_bits = new verinum::V[len+1];
-
-      verinum::V carry = verinum::V1;
-      for (unsigned idx = 0 ;  idx < len ;  idx += 1)
-	    val_bits[idx] = add_with_carry(verinum::V0, ~right[idx], carry);
-
-      if (signed_flag && !has_len_flag) {
-	    val_bits[len] = add_with_carry(verinum::V0, ~sign_bit(right), carry);
-	    if (val_bits[len] != val_bits[len-1]) len += 1;
-      }
-      verinum result (val_bits, len, has_len_flag);
-      result.has_sign(signed_flag);
-
-      delete[]val_bits;
-
-      return result;
+	// Negate by subtracting from a zero of the same width, which
+	// is padded with zero however this is signed.
+      verinum zero (verinum::V0, len, has_len_flag);
+      return add_words(zero, right, true, has_len_flag, signed_flag);
 }
 
 /*
@@ -1170,8 +1227,9 @@ verinum operator - (const verinum&right)
  * operand is unsized, the resulting number is as large as the sum of
  * the sizes of the operands.
  *
- * The algorithm used is successive shift and add operations,
- * implemented as the nested loops.
+ * The operands are extended with their sign bits to the width of the
+ * result, and multiplied a word at a time keeping only the low words
+ * of the product.
  */
 verinum operator * (const verinum&left, const verinum&right)
 {
@@ -1194,23 +1252,31 @@ verinum operator * (const verinum&left, const verinum&right)
       verinum result(verinum::V0, len, has_len_flag);
       result.has_sign(signed_flag);
 
+      verinum::V l_sign = sign_bit(left);
       verinum::V r_sign = sign_bit(right);
-      for (unsigned rdx = 0 ;  rdx < len ;  rdx += 1) {
 
-	    verinum::V r_bit = rdx < r_len ? right.get(rdx) : r_sign;
-	    if (r_bit == verinum::V0)
+      unsigned nwords = result.nwords();
+      vector<uint64_t> lwords (nwords);
+      vector<uint64_t> prod (nwords);
+      for (unsigned idx = 0 ;  idx < nwords ;  idx += 1)
+	    lwords[idx] = left.get_abits(idx, l_sign);
+
+      for (unsigned rdx = 0 ;  rdx < nwords ;  rdx += 1) {
+	    uint64_t rword = right.get_abits(rdx, r_sign);
+	    if (rword == 0)
 		  continue;
 
-	    verinum::V l_sign = sign_bit(left);
-	    verinum::V carry = verinum::V0;
-	    for (unsigned ldx = 0 ;  ldx < (len - rdx) ;  ldx += 1) {
-		  verinum::V l_bit = ldx < l_len ? left[ldx] : l_sign;
-		  result.set(ldx+rdx, add_with_carry(l_bit,
-						     result[rdx+ldx],
-						     carry));
+	    uint64_t mcarry = 0;
+	    uint64_t acarry = 0;
+	    for (unsigned ldx = 0 ;  ldx < (nwords - rdx) ;  ldx += 1) {
+		  uint64_t tmp = multiply_with_carry(lwords[ldx], rword, mcarry);
+		  prod[rdx+ldx] = add_with_carry(prod[rdx+ldx], tmp, acarry);
 	    }
       }
 
+      for (unsigned idx = 0 ;  idx < nwords ;  idx += 1)
+	    result.set_bits(idx, prod[idx]);
+
       return trim_vnum(result);
 }
 
@@ -1314,8 +1380,11 @@ verinum operator << (const verinum&that, unsigned shift)
       verinum result(verinum::V0, len, has_len_flag);
       result.has_sign(that.has_sign());
 
-      for (unsigned idx = shift ;  idx < len ;  idx += 1)
-	    result.set(idx, that.get(idx - shift));
+      for (unsigned idx = 0 ;  idx < result.nwords() ;  idx += 1) {
+	    int64_t off = (int64_t)idx*WORD_BITS - shift;
+	    result.set_bits(idx, bits_at(that, false, off, verinum::V0),
+			    bits_at(that, true, off, verinum::V0));
+      }
 
       return trim_vnum(result);
 }
@@ -1339,47 +1408,75 @@ verinum operator >> (const verinum&that, unsigned shift)
       verinum result(sign_bit, len, has_len_flag);
       result.has_sign(that.has_sign());
 
-      for (unsigned idx = shift ;  idx < that.len() ;  idx += 1)
-	    result.set(idx-shift, that.get(idx));
+      for (unsigned idx = 0 ;  idx < result.nwords() ;  idx += 1) {
+	    int64_t off = (int64_t)idx*WORD_BITS + shift;
+	    result.set_bits(idx, bits_at(that, false, off, sign_bit),
+			    bits_at(that, true, off, sign_bit));
+      }
 
       return trim_vnum(result);
 }
 
+/*
+ * Divide the nbits wide num by den, which must not be zero, with a
+ * shift and subtract loop that works on whole words. The quotient is
+ * left in quot, which must be nbits wide, and the remainder in rem,
+ * which must be one bit wider than nbits.
+ */
+static void divide_words(const verinum&num, const verinum&den, unsigned nbits,
+			 vector<uint64_t>&quot, vector<uint64_t>&rem)
+{
+      unsigned nwords = rem.size();
+      vector<uint64_t> dwords (nwords);
+      for (unsigned idx = 0 ;  idx < nwords ;  idx += 1)
+	    dwords[idx] = den.get_abits(idx);
+
+      for (unsigned bit = nbits ;  bit > 0 ;  bit -= 1) {
+	    unsigned ndx = bit - 1;
+
+	      // Shift the next bit of the numerator into the remainder.
+	    for (unsigned idx = nwords ;  idx > 1 ;  idx -= 1)
+		  rem[idx-1] = (rem[idx-1] << 1) | (rem[idx-2] >> (WORD_BITS-1));
+	    rem[0] = (rem[0] << 1) | ((num.get_abits(ndx/WORD_BITS) >> (ndx%WORD_BITS)) & 1);
+
+	      // If the divisor fits, subtract it and set the quotient bit.
+	    unsigned idx = nwords;
+	    while (idx > 0 && rem[idx-1] == dwords[idx-1])
+		  idx -= 1;
+	    if (idx > 0 && rem[idx-1] < dwords[idx-1])
+		  continue;
+
+	    uint64_t carry = 1;
+	    for (idx = 0 ;  idx < nwords ;  idx += 1)
+		  rem[idx] = add_with_carry(rem[idx], ~dwords[idx], carry);
+	    quot[ndx/WORD_BITS] |= (uint64_t)1 << (ndx%WORD_BITS);
+      }
+}
+
 static verinum unsigned_divide(verinum num, verinum den, bool signed_result)
 {
 	// We need the following calculations to be lossless. The
 	// result will be cast to the required width by the caller.
-      num.has_len(false);
-      den.has_len(false);
-
-      unsigned nwid = num.len();
-      while (nwid > 0 && (num.get(nwid-1) == verinum::V0))
-	    nwid -= 1;
-
-      unsigned dwid = den.len();
-      while (dwid > 0 && (den.get(dwid-1) == verinum::V0))
-	    dwid -= 1;
+      int ntop = highest_diff(num, num.len(), verinum::V0);
+      int dtop = highest_diff(den, den.len(), verinum::V0);
+      unsigned nwid = ntop + 1;
+      unsigned dwid = dtop + 1;
 
       if (dwid > nwid)
 	    return verinum(verinum::V0, 1);
 
-      den = den << (nwid-dwid);
+      vector<uint64_t> quot (words_for(nwid));
+      vector<uint64_t> rem (words_for(nwid+1));
+      divide_words(num, den, nwid, quot, rem);
 
       unsigned idx = nwid - dwid + 1;
       verinum result (verinum::V0, signed_result ? idx + 1 : idx);
+      for (unsigned wdx = 0 ;  wdx < words_for(idx) ;  wdx += 1)
+	    result.set_bits(wdx, quot[wdx]);
       if (signed_result) {
 	    result.set(idx, verinum::V0);
 	    result.has_sign(true);
       }
-      while (idx > 0) {
-	    if (den <= num) {
-		  verinum dif = num - den;
-		  num = dif;
-		  result.set(idx-1, verinum::V1);
-	    }
-	    den = den >> 1;
-	    idx -= 1;
-      }
 
       return result;
 }
@@ -1391,30 +1488,40 @@ static verinum unsigned_modulus(verinum num, verinum den)
       num.has_len(false);
       den.has_len(false);
 
-      unsigned nwid = num.len();
-      while (nwid > 0 && (num.get(nwid-1) == verinum::V0))
-	    nwid -= 1;
-
-      unsigned dwid = den.len();
-      while (dwid > 0 && (den.get(dwid-1) == verinum::V0))
-	    dwid -= 1;
+      int ntop = highest_diff(num, num.len(), verinum::V0);
+      int dtop = highest_diff(den, den.len(), verinum::V0);
+      unsigned nwid = ntop + 1;
+      unsigned dwid = dtop + 1;
 
       if (dwid > nwid)
 	    return num;
 
-      den = den << (nwid-dwid);
-
-      unsigned idx = nwid - dwid + 1;
-      while (idx > 0) {
-	    if (den <= num) {
-		  verinum dif = num - den;
-		  num = dif;
+      vector<uint64_t> quot (words_for(nwid));
+      vector<uint64_t> rem (words_for(nwid+1));
+      divide_words(num, den, nwid, quot, rem);
+
+	// The remainder is as wide as the numerator, unless the
+	// divisor had to be shifted up past it. The divisor is first
+	// subtracted at the most significant quotient bit.
+      unsigned len = num.len();
+      int qtop = -1;
+      for (unsigned idx = quot.size() ;  idx > 0 ;  idx -= 1) {
+	    if (quot[idx-1]) {
+		  qtop = (idx-1)*WORD_BITS + highest_bit(quot[idx-1]);
+		  break;
 	    }
-	    den = den >> 1;
-	    idx -= 1;
       }
+      if (qtop >= 0) {
+	    unsigned dlen = dwid + qtop;
+	    if (dwid < den.len()) dlen += 1;
+	    len = max(len, dlen);
+      }
+
+      verinum result (verinum::V0, len, false);
+      for (unsigned wdx = 0 ;  wdx < result.nwords() ;  wdx += 1)
+	    result.set_bits(wdx, wdx < rem.size()? rem[wdx] : 0);
 
-      return num;
+      return result;
 }
 
 /*
@@ -1447,10 +1554,7 @@ verinum operator / (const verinum&left, const verinum&right)
 		  long r = right.as_long();
 		  bool overflow = (l == LONG_MIN) && (r == -1);
 		  long v = overflow ? LONG_MIN : l / r;
-		  for (unsigned idx = 0 ;  idx < use_len ;  idx += 1) {
-			result.set(idx,  (v & 1)? verinum::V1 : verinum::V0);
-			v >>= 1;
-		  }
+		  result.set_bits(0, (uint64_t)(int64_t)v);
 
 	    } else {
 		  verinum use_left, use_right;
@@ -1481,10 +1585,7 @@ verinum operator / (const verinum&left, const verinum&right)
 		  unsigned long l = left.as_ulong();
 		  unsigned long r = right.as_ulong();
 		  unsigned long v = l / r;
-		  for (unsigned idx = 0 ;  idx < use_len ;  idx += 1) {
-			result.set(idx,  (v & 1)? verinum::V1 : verinum::V0);
-			v >>= 1;
-		  }
+		  result.set_bits(0, v);
 
 	    } else {
 		  result = unsigned_divide(left, right, false);
@@ -1522,10 +1623,7 @@ verinum operator % (const verinum&left, const verinum&right)
 		  long r = right.as_long();
 		  bool overflow = (l == LONG_MIN) && (r == -1);
 		  long v = overflow ? 0 : l % r;
-		  for (unsigned idx = 0 ;  idx < use_len ;  idx += 1) {
-			result.set(idx,  (v & 1)? verinum::V1 : verinum::V0);
-			v >>= 1;
-		  }
+		  result.set_bits(0, (uint64_t)(int64_t)v);
 	    } else {
 		  verinum use_left, use_right;
 		  bool negative = false;
@@ -1551,10 +1649,7 @@ verinum operator % (const verinum&left, const verinum&right)
 		  unsigned long l = left.as_ulong();
 		  unsigned long r = right.as_ulong();
 		  unsigned long v = l % r;
-		  for (unsigned idx = 0 ;  idx < use_len ;  idx += 1) {
-			result.set(idx,  (v & 1)? verinum::V1 : verinum::V0);
-			v >>= 1;
-		  }
+		  result.set_bits(0, v);
 	    } else {
 		  result = unsigned_modulus(left, right);
 	    }
@@ -1576,11 +1671,8 @@ verinum concat(const verinum&left, const verinum&right)
       }
 
       verinum res (verinum::V0, left.len() + right.len());
-      for (unsigned idx = 0 ;  idx < right.len() ;  idx += 1)
-	    res.set(idx, right.get(idx));
-
-      for (unsigned idx = 0 ;  idx < left.len() ;  idx += 1)
-	    res.set(idx+right.len(), left.get(idx));
+      res.set(0, right);
+      res.set(right.len(), left);
 
       return res;
 }
@@ -35,6 +35,12 @@ using namespace std;
  * possible values: 0, 1, x or z. The verinum number is store in
  * little-endian format. This means that if the long value is 2b'10,
  * get(0) is 0 and get(1) is 1.
+ *
+ * The bits are packed 64 to a word in two planes, the same way the
+ * vvp run time does it. The A plane holds the value and the B plane
+ * is set for x or z bits, so 0 is A=0/B=0, 1 is A=1/B=0, z is
+ * A=0/B=1 and x is A=1/B=1. The unused bits of the last word are
+ * always zero.
  */
 class verinum {
 
@@ -100,6 +106,15 @@ class verinum {
 
       V operator[] (unsigned idx) const { return get(idx); }
 
+	// Word access to the packed bits. Word idx holds bits
+	// 64*idx to 64*idx+63, and bits past the end of the number
+	// read as the pad value. The set_bits method ignores bits
+	// past the end of the number.
+      unsigned nwords() const { return (nbits_ + 63) / 64; }
+      uint64_t get_abits(unsigned idx, V pad =V0) const;
+      uint64_t get_bbits(unsigned idx, V pad =V0) const;
+      void set_bits(unsigned idx, uint64_t abits, uint64_t bbits =0);
+
 	// Return the value as a native unsigned integer. If the value is
 	// larger than can be represented by the returned type, return
 	// the maximum value of that type. If the value has any x or z
@@ -113,9 +128,11 @@ class verinum {
       string as_string() const;
     private:
       void signed_trim();
+      void allocate_(unsigned nbits);
 
     private:
-      V* bits_;
+      uint64_t*abits_;
+      uint64_t*bbits_;
       unsigned nbits_;
       bool has_len_;
       bool has_sign_;
@@ -93,6 +93,8 @@ struct strobe_cb_info {
       vpiHandle*items;
       unsigned nitems;
       unsigned fd_mcd;
+	/* Precompiled constant format strings, indexed like items. */
+      struct format_plan**formats;
 };
 
 /*
@@ -137,6 +139,7 @@ static int vpi_get_dec_size(vpiHandle item)
 
 static void array_from_iterator(struct strobe_cb_info*info, vpiHandle argv)
 {
+      info->formats = 0;
       if (argv) {
 	    vpiHandle item;
 	    unsigned nitems = 1;
@@ -880,54 +883,151 @@ static unsigned int get_format_char(char **rtn, int ljust, int plus,
   return size - 1;
 }
 
-/* We can't use the normal str functions on the return value since
- * %u and %z can insert NULL characters into the stream. */
-static unsigned int get_format(char **rtn, char *fmt,
-                               const struct strobe_cb_info *info, unsigned int *idx)
+/*
+ * The output of the display tasks is assembled in a display_buf. The
+ * contents may include NULL characters (see %u/%z), so the size is
+ * kept explicitly, but the buffer is always NULL terminated.
+ */
+struct display_buf {
+      char*data;
+      unsigned size;
+      unsigned alloc;
+};
+
+/* Make room for cnt more characters and the terminating NULL, and
+ * return a pointer to the end of the current contents. */
+static char* display_buf_reserve(struct display_buf*buf, unsigned cnt)
 {
-  char *cp = fmt;
-  unsigned int size;
+      if (buf->size + cnt + 1 > buf->alloc) {
+	    buf->alloc = 2*buf->alloc;
+	    if (buf->alloc < buf->size + cnt + 1)
+		  buf->alloc = buf->size + cnt + 1;
+	    if (buf->alloc < 256)
+		  buf->alloc = 256;
+	    buf->data = realloc(buf->data, buf->alloc*sizeof(char));
+      }
+      return buf->data + buf->size;
+}
 
-  *rtn = strdup("");
-  size = 1;
-  while (*cp) {
-    size_t cnt = strcspn(cp, "%");
+static void display_buf_append(struct display_buf*buf, const char*src,
+                               unsigned cnt)
+{
+      memcpy(display_buf_reserve(buf, cnt), src, cnt);
+      buf->size += cnt;
+}
 
-    if (cnt > 0) {
-      *rtn = realloc(*rtn, (size+cnt)*sizeof(char));
-      memcpy(*rtn+size-1, cp, cnt);
-      size += cnt;
-      cp += cnt;
-    } else {
-      int ljust = 0, plus = 0, ld_zero = 0, width = -1, prec = -1;
-      char *result;
-
-      cp += 1;
-      while ((*cp == '-') || (*cp == '+')) {
-        if (*cp == '-') ljust = 1;
-        else plus = 1;
-        cp += 1;
-      }
-      if (*cp == '0') {
-        ld_zero = 1;
-        cp += 1;
+/*
+ * A format string is parsed into a list of segments. Each segment is
+ * a run of literal text followed by at most one format specification.
+ * Constant format strings are parsed once and the plan is kept with
+ * the call, other format strings are parsed each time they are used.
+ */
+struct format_seg {
+      unsigned lit_off, lit_len;
+      int has_spec;
+      int ljust, plus, ld_zero, width, prec;
+      char fmt;
+};
+
+struct format_plan {
+      char*text;
+      unsigned nsegs;
+      struct format_seg*segs;
+};
+
+static struct format_plan* compile_format(const char*fmt)
+{
+      struct format_plan*plan = malloc(sizeof(struct format_plan));
+      char*cp;
+
+      plan->text = strdup(fmt);
+      plan->nsegs = 0;
+      plan->segs = 0;
+
+      cp = plan->text;
+      while (*cp) {
+	    struct format_seg seg;
+	    seg.lit_off = cp - plan->text;
+	    seg.lit_len = strcspn(cp, "%");
+	    seg.has_spec = 0;
+	    seg.ljust = 0;
+	    seg.plus = 0;
+	    seg.ld_zero = 0;
+	    seg.width = -1;
+	    seg.prec = -1;
+	    seg.fmt = 0;
+	    cp += seg.lit_len;
+
+	    if (*cp == '%') {
+		  seg.has_spec = 1;
+		  cp += 1;
+		  while ((*cp == '-') || (*cp == '+')) {
+			if (*cp == '-') seg.ljust = 1;
+			else seg.plus = 1;
+			cp += 1;
+		  }
+		  if (*cp == '0') {
+			seg.ld_zero = 1;
+			cp += 1;
+		  }
+		  if (isdigit((int)*cp)) seg.width = strtoul(cp, &cp, 10);
+		  if (*cp == '.') {
+			cp += 1;
+			seg.prec = strtoul(cp, &cp, 10);
+		  }
+		  seg.fmt = *cp;
+		  if (*cp) cp += 1;
+	    }
+
+	    plan->segs = realloc(plan->segs,
+	                         (plan->nsegs+1)*sizeof(struct format_seg));
+	    plan->segs[plan->nsegs] = seg;
+	    plan->nsegs += 1;
       }
-      if (isdigit((int)*cp)) width = strtoul(cp, &cp, 10);
-      if (*cp == '.') {
-        cp += 1;
-        prec = strtoul(cp, &cp, 10);
+
+      return plan;
+}
+
+static void free_format(struct format_plan*plan)
+{
+      free(plan->text);
+      free(plan->segs);
+      free(plan);
+}
+
+static void run_format(struct display_buf*out, const struct format_plan*plan,
+                       const struct strobe_cb_info *info, unsigned int *idx)
+{
+      unsigned sdx;
+      for (sdx = 0 ; sdx < plan->nsegs ; sdx += 1) {
+	    const struct format_seg*seg = plan->segs + sdx;
+	    display_buf_append(out, plan->text+seg->lit_off, seg->lit_len);
+	    if (seg->has_spec) {
+		  char *result;
+		  unsigned int cnt;
+		  cnt = get_format_char(&result, seg->ljust, seg->plus,
+		                        seg->ld_zero, seg->width, seg->prec,
+		                        seg->fmt, info, idx);
+		  display_buf_append(out, result, cnt);
+		  free(result);
+	    }
       }
-      cnt = get_format_char(&result, ljust, plus, ld_zero, width, prec, *cp,
-                            info, idx);
-      *rtn = realloc(*rtn, (size+cnt)*sizeof(char));
-      memcpy(*rtn+size-1, result, cnt);
-      free(result);
-      size += cnt;
-      if (*cp) cp += 1;
-    }
-  }
-  *(*rtn+size-1) = '\0';
-  return size - 1;
+}
+
+/* We can't use the normal str functions on the return value since
+ * %u and %z can insert NULL characters into the stream. */
+static unsigned int get_format(char **rtn, char *fmt,
+                               const struct strobe_cb_info *info, unsigned int *idx)
+{
+  struct display_buf out = { 0, 0, 0 };
+  struct format_plan*plan = compile_format(fmt);
+
+  display_buf_reserve(&out, 0);
+  run_format(&out, plan, info, idx);
+  free_format(plan);
+  out.data[out.size] = '\0';
+  *rtn = out.data;
+  return out.size;
 }
 
 static unsigned int get_numeric(char **rtn, const struct strobe_cb_info *info,
@@ -959,16 +1059,17 @@ static unsigned int get_numeric(char **rtn, const struct strobe_cb_info *info,
 
 /* In many places we can't use the normal str functions since %u and %z
  * can insert NULL characters into the stream. */
-static char *get_display(unsigned int *rtnsz, const struct strobe_cb_info *info)
+static void get_display_buf(struct display_buf *out,
+                            const struct strobe_cb_info *info)
 {
-  char *result, *fmt, *rtn, *func_name;
+  char *result, *fmt, *func_name;
   const char *cresult;
   s_vpi_value value;
-  unsigned int idx, size, width;
+  unsigned int idx, width;
   char buf[256];
 
-  rtn = strdup("");
-  size = 1;
+  out->size = 0;
+  display_buf_reserve(out, 0);
   for  (idx = 0; idx < info->nitems; idx += 1) {
     vpiHandle item = info->items[idx];
 
@@ -976,12 +1077,15 @@ static char *get_display(unsigned int *rtnsz, const struct strobe_cb_info *info)
 
       case vpiConstant:
       case vpiParameter:
-        if (vpi_get(vpiConstType, item) == vpiStringConst) {
+        if (info->formats && info->formats[idx]) {
+          run_format(out, info->formats[idx], info, &idx);
+        } else if (vpi_get(vpiConstType, item) == vpiStringConst) {
+          struct format_plan*plan;
           value.format = vpiStringVal;
           vpi_get_value(item, &value);
-          fmt = strdup(value.value.str);
-          width = get_format(&result, fmt, info, &idx);
-          free(fmt);
+          plan = compile_format(value.value.str);
+          run_format(out, plan, info, &idx);
+          free_format(plan);
         } else if (vpi_get(vpiConstType, item) == vpiRealConst) {
           value.format = vpiRealVal;
           vpi_get_value(item, &value);
@@ -997,14 +1101,12 @@ static char *get_display(unsigned int *rtnsz, const struct strobe_cb_info *info)
 #else
           sprintf(buf, compatible_flag ? "%g" : "%#g", value.value.real);
 #endif
-          result = strdup(buf);
-          width = strlen(result);
+          display_buf_append(out, buf, strlen(buf));
         } else {
           width = get_numeric(&result, info, item);
+          display_buf_append(out, result, width);
+          free(result);
         }
-        rtn = realloc(rtn, (size+width)*sizeof(char));
-        memcpy(rtn+size-1, result, width);
-        free(result);
         break;
 
       case vpiNet:
@@ -1018,8 +1120,7 @@ static char *get_display(unsigned int *rtnsz, const struct strobe_cb_info *info)
       case vpiMemoryWord:
       case vpiPartSelect:
         width = get_numeric(&result, info, item);
-        rtn = realloc(rtn, (size+width)*sizeof(char));
-        memcpy(rtn+size-1, result, width);
+        display_buf_append(out, result, width);
         free(result);
         break;
 
@@ -1033,8 +1134,8 @@ static char *get_display(unsigned int *rtnsz, const struct strobe_cb_info *info)
                  vpi_get(vpiTimeUnit, info->scope));
         width = strlen(buf);
         if (width  < timeformat_info.width) width = timeformat_info.width;
-        rtn = realloc(rtn, (size+width)*sizeof(char));
-        sprintf(rtn+size-1, "%*s", width, buf);
+        sprintf(display_buf_reserve(out, width), "%*s", width, buf);
+        out->size += width;
         break;
 
       /* Realtime variables are also processed here. */
@@ -1053,9 +1154,7 @@ static char *get_display(unsigned int *rtnsz, const struct strobe_cb_info *info)
 #else
         sprintf(buf, compatible_flag ? "%g" : "%#g", value.value.real);
 #endif
-        width = strlen(buf);
-        rtn = realloc(rtn, (size+width)*sizeof(char));
-        memcpy(rtn+size-1, buf, width);
+        display_buf_append(out, buf, strlen(buf));
         break;
 
        /* Process string variables like string constants: interpret
@@ -1066,8 +1165,7 @@ static char *get_display(unsigned int *rtnsz, const struct strobe_cb_info *info)
 	fmt = strdup(value.value.str);
 	width = get_format(&result, fmt, info, &idx);
 	free(fmt);
-        rtn = realloc(rtn, (size+width)*sizeof(char));
-        memcpy(rtn+size-1, result, width);
+        display_buf_append(out, result, width);
         free(result);
 	break;
 
@@ -1078,24 +1176,27 @@ static char *get_display(unsigned int *rtnsz, const struct strobe_cb_info *info)
           vpi_get_value(item, &value);
           width = strlen(value.value.str);
           if (width  < 20) width = 20;
-          rtn = realloc(rtn, (size+width)*sizeof(char));
-          sprintf(rtn+size-1, "%*s", width, value.value.str);
+          sprintf(display_buf_reserve(out, width), "%*s", width,
+                  value.value.str);
+          out->size += width;
 
         } else if (strcmp(func_name, "$stime") == 0) {
           value.format = vpiDecStrVal;
           vpi_get_value(item, &value);
           width = strlen(value.value.str);
           if (width  < 10) width = 10;
-          rtn = realloc(rtn, (size+width)*sizeof(char));
-          sprintf(rtn+size-1, "%*s", width, value.value.str);
+          sprintf(display_buf_reserve(out, width), "%*s", width,
+                  value.value.str);
+          out->size += width;
 
         } else if (strcmp(func_name, "$simtime") == 0) {
           value.format = vpiDecStrVal;
           vpi_get_value(item, &value);
           width = strlen(value.value.str);
           if (width  < 20) width = 20;
-          rtn = realloc(rtn, (size+width)*sizeof(char));
-          sprintf(rtn+size-1, "%*s", width, value.value.str);
+          sprintf(display_buf_reserve(out, width), "%*s", width,
+                  value.value.str);
+          out->size += width;
 
         } else if (strcmp(func_name, "$realtime") == 0) {
           /* Use the local scope precision. */
@@ -1105,17 +1206,13 @@ static char *get_display(unsigned int *rtnsz, const struct strobe_cb_info *info)
           value.format = vpiRealVal;
           vpi_get_value(item, &value);
           sprintf(buf, "%.*f", use_prec, value.value.real);
-          width = strlen(buf);
-          rtn = realloc(rtn, (size+width)*sizeof(char));
-          sprintf(rtn+size-1, "%*s", width, buf);
+          display_buf_append(out, buf, strlen(buf));
 
         } else {
           vpi_printf("WARNING: %s:%d: %s does not support %s as an argument!\n",
                      info->filename, info->lineno, info->name, func_name);
           strcpy(buf, "<?>");
-          width = strlen(buf);
-          rtn = realloc(rtn, (size+width)*sizeof(char));
-          memcpy(rtn+size-1, buf, width);
+          display_buf_append(out, buf, strlen(buf));
         }
         break;
 
@@ -1124,16 +1221,19 @@ static char *get_display(unsigned int *rtnsz, const struct strobe_cb_info *info)
                    info->filename, info->lineno, vpi_get_str(vpiType, item),
                    info->name);
         cresult = "<?>";
-        width = strlen(cresult);
-        rtn = realloc(rtn, (size+width)*sizeof(char));
-        memcpy(rtn+size-1, cresult, width);
+        display_buf_append(out, cresult, strlen(cresult));
         break;
     }
-    size += width;
   }
-  rtn[size-1] = '\0';
-  *rtnsz = size - 1;
-  return rtn;
+  out->data[out->size] = '\0';
+}
+
+static char *get_display(unsigned int *rtnsz, const struct strobe_cb_info *info)
+{
+  struct display_buf out = { 0, 0, 0 };
+  get_display_buf(&out, info);
+  *rtnsz = out.size;
+  return out.data;
 }
 
 #ifdef BR916_STOPGAP_FIX
@@ -1262,40 +1362,133 @@ static PLI_INT32 sys_common_compiletf(ICARUS_VPI_CONST PLI_BYTE8*name, int no_au
       return 0;
 }
 
+/*
+ * The $display/$write family of tasks keeps the arguments of each call
+ * and its compiled constant format strings in a display_plan that is
+ * attached to the call as user data. That way a call does not scan its
+ * arguments or parse its format strings each time it is executed. The
+ * output is assembled in a buffer that is reused for every call.
+ */
+struct display_plan {
+      vpiHandle fd;
+      struct strobe_cb_info info;
+      struct display_plan*next;
+};
+
+static struct display_plan*display_plans = 0;
+static struct display_buf display_out = { 0, 0, 0 };
+
+static struct display_plan* display_plan_new(vpiHandle callh,
+                                             const char*name)
+{
+      struct display_plan*plan = calloc(1, sizeof(struct display_plan));
+      vpiHandle argv = vpi_iterate(vpiArgument, callh);
+      unsigned idx;
+
+      if (argv && name[1] == 'f') plan->fd = vpi_scan(argv);
+
+	/* We could use vpi_get_str(vpiName, callh) to get the task name,
+	 * but name is already defined. */
+      plan->info.name = name;
+      plan->info.filename = strdup(vpi_get_str(vpiFile, callh));
+      plan->info.lineno = (int)vpi_get(vpiLineNo, callh);
+      plan->info.default_format = get_default_format(name);
+      plan->info.scope = vpi_handle(vpiScope, callh);
+      assert(plan->info.scope);
+      array_from_iterator(&plan->info, argv);
+
+	/* Compile the format strings that can not change. */
+      for (idx = 0 ; idx < plan->info.nitems ; idx += 1) {
+	    vpiHandle item = plan->info.items[idx];
+	    s_vpi_value val;
+
+	    switch (vpi_get(vpiType, item)) {
+	      case vpiConstant:
+	      case vpiParameter:
+		  if (vpi_get(vpiConstType, item) != vpiStringConst) break;
+		  if (plan->info.formats == 0)
+			plan->info.formats = calloc(plan->info.nitems,
+			                            sizeof(struct format_plan*));
+		  val.format = vpiStringVal;
+		  vpi_get_value(item, &val);
+		  plan->info.formats[idx] = compile_format(val.value.str);
+		  break;
+	      default:
+		  break;
+	    }
+      }
+
+      plan->next = display_plans;
+      display_plans = plan;
+      return plan;
+}
+
+static void display_plans_delete(void)
+{
+      while (display_plans) {
+	    struct display_plan*plan = display_plans;
+	    unsigned idx;
+	    display_plans = plan->next;
+	    if (plan->info.formats) {
+		  for (idx = 0 ; idx < plan->info.nitems ; idx += 1)
+			if (plan->info.formats[idx])
+			      free_format(plan->info.formats[idx]);
+		  free(plan->info.formats);
+	    }
+	    free(plan->info.filename);
+	    free(plan->info.items);
+	    free(plan);
+      }
+      free(display_out.data);
+      display_out.data = 0;
+      display_out.size = 0;
+      display_out.alloc = 0;
+}
+
 /* Check the $display, $write, $fdisplay and $fwrite based tasks. */
 static PLI_INT32 sys_display_compiletf(ICARUS_VPI_CONST PLI_BYTE8*name)
 {
+      vpiHandle callh = vpi_handle(vpiSysTfCall, 0);
+
 	/* These tasks can have automatic variables and are not monitor. */
-      return sys_common_compiletf(name, 0, 0);
+      sys_common_compiletf(name, 0, 0);
+
+	/* The severity tasks share this check, but not the calltf. */
+      if ((strcmp(name, "$error") != 0) &&
+          (strcmp(name, "$warning") != 0) &&
+          (strcmp(name, "$info") != 0)) {
+	    vpi_put_userdata(callh, display_plan_new(callh, name));
+      }
+      return 0;
 }
 
 /* This implements the $sformatf, $display/$fdisplay
  * and the $write/$fwrite based tasks. */
 static PLI_INT32 sys_display_calltf(ICARUS_VPI_CONST PLI_BYTE8 *name)
 {
-      vpiHandle callh, argv, scope;
-      struct strobe_cb_info info;
-      char* result;
-      unsigned int size;
+      vpiHandle callh;
+      struct display_plan*plan;
       PLI_UINT32 fd_mcd;
       s_vpi_value val;
 
       callh = vpi_handle(vpiSysTfCall, 0);
-      argv = vpi_iterate(vpiArgument, callh);
+
+	/* $sformatf has its own compiletf, so it gets its plan here. */
+      plan = (struct display_plan*)vpi_get_userdata(callh);
+      if (plan == 0) {
+	    plan = display_plan_new(callh, name);
+	    vpi_put_userdata(callh, plan);
+      }
 
 	/* Get the file/MC descriptor and verify it is valid. */
       if(name[1] == 'f') {
 	      errno = 0;
-	      vpiHandle arg = vpi_scan(argv);
 	      val.format = vpiIntVal;
-	      vpi_get_value(arg, &val);
+	      vpi_get_value(plan->fd, &val);
 	      fd_mcd = val.value.integer;
 
 		/* If the MCD is zero we have nothing to do so just return. */
-	      if (fd_mcd == 0)  {
-		    vpi_free_object(argv);
-		    return 0;
-	      }
+	      if (fd_mcd == 0) return 0;
 
 	      if ((! IS_MCD(fd_mcd) && vpi_get_file(fd_mcd) == NULL) ||
 	          ( IS_MCD(fd_mcd) && my_mcd_printf(fd_mcd, "") == EOF)) {
@@ -1304,7 +1497,6 @@ static PLI_INT32 sys_display_calltf(ICARUS_VPI_CONST PLI_BYTE8 *name)
 		    vpi_printf("invalid file descriptor/MCD (0x%x) given "
 		               "to %s.\n", (unsigned int)fd_mcd, name);
 		    errno = EBADF;
-		    vpi_free_object(argv);
 		    return 0;
 	      }
       } else if(strncmp(name,"$sformatf",9) == 0) {
@@ -1315,35 +1507,21 @@ static PLI_INT32 sys_display_calltf(ICARUS_VPI_CONST PLI_BYTE8 *name)
 	      fd_mcd = 1;
       }
 
-      scope = vpi_handle(vpiScope, callh);
-      assert(scope);
-	/* We could use vpi_get_str(vpiName, callh) to get the task name,
-	 * but name is already defined. */
-      info.name = name;
-      info.filename = strdup(vpi_get_str(vpiFile, callh));
-      info.lineno = (int)vpi_get(vpiLineNo, callh);
-      info.default_format = get_default_format(name);
-      info.scope = scope;
-      array_from_iterator(&info, argv);
-
 	/* Because %u and %z may put embedded NULL characters into the
 	 * returned string strlen() may not match the real size! */
-      result = get_display(&size, &info);
+      get_display_buf(&display_out, &plan->info);
 
       if(fd_mcd > 0) {
-	      my_mcd_rawwrite(fd_mcd, result, size);
+	      my_mcd_rawwrite(fd_mcd, display_out.data, display_out.size);
 	      if ((strncmp(name,"$display",8) == 0) ||
 	          (strncmp(name,"$fdisplay",9) == 0)) my_mcd_rawwrite(fd_mcd, "\n", 1);
       } else {
 	      /* Return as a string ($sformatf) */
 	      val.format = vpiStringVal;
-	      val.value.str = result;
+	      val.value.str = display_out.data;
 	      vpi_put_value(callh, &val, 0, vpiNoDelay);
       }
 
-      free(result);
-      free(info.filename);
-      free(info.items);
       return 0;
 }
 
@@ -1463,7 +1641,7 @@ static PLI_INT32 sys_strobe_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
  * though that monitor may be watching many variables).
  */
 
-static struct strobe_cb_info monitor_info = { 0, 0, 0, 0, 0, 0, 0, 0 };
+static struct strobe_cb_info monitor_info = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
 static vpiHandle *monitor_callbacks = 0;
 static int monitor_scheduled = 0;
 static int monitor_enabled = 1;
@@ -2181,6 +2359,8 @@ static PLI_INT32 sys_end_of_simulation(p_cb_data cb_data)
 
       free(timeformat_info.suff);
       timeformat_info.suff = 0;
+
+      display_plans_delete();
       return 0;
 }
 
@@ -82,10 +82,11 @@ static void show_this_item(struct vcd_info*info)
 	    value.format = vpiRealVal;
 	    vpi_get_value(info->item, &value);
 	    fstWriterEmitValueChange(dump_file, info->handle, &value.value.real);
+      } else if (type == vpiNamedEvent) {
+	    fstWriterEmitValueChange(dump_file, info->handle, "1");
       } else {
-	    value.format = vpiBinStrVal;
-	    vpi_get_value(info->item, &value);
-	    fstWriterEmitValueChange(dump_file, info->handle, (type != vpiNamedEvent) ? value.value.str : "1");
+	    fstWriterEmitValueChange(dump_file, info->handle,
+	                             vcd_get_bits(info->item));
       }
 }
 
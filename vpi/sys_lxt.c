@@ -171,11 +171,9 @@ static void show_this_item(struct vcd_info*info)
 	    lt_emit_value_double(dump_file, info->sym, 0, value.value.real);
 
       } else {
-	    value.format = vpiBinStrVal;
-	    vpi_get_value(info->item, &value);
 	    lt_emit_value_bit_string(dump_file, info->sym,
 	                             0 /* array row */,
-	                             value.value.str);
+	                             vcd_get_bits(info->item));
       }
 }
 
@@ -227,9 +227,7 @@ static void show_this_item(struct vcd_info*info)
 	    vcd_work_emit_double(info->sym, value.value.real);
 
       } else {
-	    value.format = vpiBinStrVal;
-	    vpi_get_value(info->item, &value);
-	    vcd_work_emit_bits(info->sym, value.value.str);
+	    vcd_work_emit_bits(info->sym, vcd_get_bits(info->item));
       }
 }
 
@@ -23,13 +23,235 @@
 # include  <stdlib.h>
 # include  <stdio.h>
 # include  <assert.h>
-# include  "sys_readmem_lex.h"
 # include  <sys/stat.h>
 # include  "ivl_alloc.h"
 
 char **search_list = NULL;
 unsigned sl_count = 0;
 
+/*
+ * The memory file is scanned by hand. The syntax is simple: white
+ * space, line and block comments, @ followed by a hex address, and words
+ * of hex (or binary) digits that may include x, z and _. Words are
+ * decoded straight into a s_vpi_vecval array, with the rightmost
+ * digit in the least significant bits.
+ */
+# define MEM_EOF     0
+# define MEM_ADDRESS 1
+# define MEM_WORD    2
+# define MEM_ERROR   3
+
+struct readmem_scan {
+      FILE*file;
+      int bin_flag;
+      unsigned wwid;
+	/* Input buffer. */
+      char buf[64*1024];
+      size_t pos, fill;
+	/* The digits of the current token, without any _. */
+      char*tok;
+      size_t tok_len, tok_size;
+	/* Token results. */
+      unsigned addr;
+      char err[2];
+};
+
+static int scan_getc(struct readmem_scan*sc)
+{
+      if (sc->pos == sc->fill) {
+	    sc->fill = fread(sc->buf, 1, sizeof sc->buf, sc->file);
+	    sc->pos = 0;
+	    if (sc->fill == 0) return EOF;
+      }
+      return (unsigned char)sc->buf[sc->pos++];
+}
+
+static void scan_ungetc(struct readmem_scan*sc)
+{
+      assert(sc->pos > 0);
+      sc->pos -= 1;
+}
+
+static int hex_digit_value(int ch)
+{
+      if (ch >= '0' && ch <= '9') return ch - '0';
+      if (ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
+      if (ch >= 'A' && ch <= 'F') return ch - 'A' + 10;
+      return -1;
+}
+
+static int is_word_char(const struct readmem_scan*sc, int ch)
+{
+      switch (ch) {
+	  case '0': case '1':
+	  case 'x': case 'X': case 'z': case 'Z':
+	  case '_':
+	    return 1;
+	  default:
+	    return !sc->bin_flag && hex_digit_value(ch) >= 0;
+      }
+}
+
+static void scan_word(struct readmem_scan*sc, int ch, s_vpi_vecval*val)
+{
+      unsigned step = sc->bin_flag? 1 : 4;
+      unsigned long mask = sc->bin_flag? 1 : 15;
+      unsigned pos;
+      size_t idx;
+
+      sc->tok_len = 0;
+      for ( ; ch != EOF && is_word_char(sc, ch) ; ch = scan_getc(sc)) {
+	    if (ch == '_') continue;
+	    if (sc->tok_len == sc->tok_size) {
+		  sc->tok_size = sc->tok_size? 2*sc->tok_size : 256;
+		  sc->tok = (char*)realloc(sc->tok, sc->tok_size);
+	    }
+	    sc->tok[sc->tok_len++] = ch;
+      }
+      if (ch != EOF) scan_ungetc(sc);
+
+      for (idx = 0 ; idx < (sc->wwid+31)/32 ; idx += 1) {
+	    val[idx].aval = 0;
+	    val[idx].bval = 0;
+      }
+
+	/* Fill in the digits from the right until the word is full. */
+      for (idx = sc->tok_len, pos = 0 ; idx > 0 && pos < sc->wwid
+		 ; idx -= 1, pos += step) {
+	    unsigned long aval, bval;
+	    switch (sc->tok[idx-1]) {
+		case 'x':
+		case 'X':
+		  aval = mask;
+		  bval = mask;
+		  break;
+		case 'z':
+		case 'Z':
+		  aval = 0;
+		  bval = mask;
+		  break;
+		default:
+		  aval = hex_digit_value(sc->tok[idx-1]);
+		  bval = 0;
+		  break;
+	    }
+	    val[pos/32].aval |= aval << (pos%32);
+	    val[pos/32].bval |= bval << (pos%32);
+      }
+}
+
+static int readmem_scan(struct readmem_scan*sc, s_vpi_vecval*val)
+{
+      int ch;
+
+      for (;;) {
+	    ch = scan_getc(sc);
+	    switch (ch) {
+		case EOF:
+		  return MEM_EOF;
+
+		case ' ':
+		case '\t':
+		case '\f':
+		case '\n':
+		case '\r':
+		  continue;
+
+		case '/':
+		  ch = scan_getc(sc);
+		  if (ch == '/') {
+			while ((ch = scan_getc(sc)) != EOF && ch != '\n') ;
+			continue;
+		  }
+		  if (ch == '*') {
+			int prev = 0;
+			while ((ch = scan_getc(sc)) != EOF) {
+			      if (prev == '*' && ch == '/') break;
+			      prev = ch;
+			}
+			continue;
+		  }
+		  if (ch != EOF) scan_ungetc(sc);
+		  sc->err[0] = '/';
+		  return MEM_ERROR;
+
+		case '@':
+		  ch = scan_getc(sc);
+		  if (ch == EOF || hex_digit_value(ch) < 0) {
+			if (ch != EOF) scan_ungetc(sc);
+			sc->err[0] = '@';
+			return MEM_ERROR;
+		  }
+		  sc->addr = 0;
+		  for ( ; ch != EOF && hex_digit_value(ch) >= 0
+			      ; ch = scan_getc(sc))
+			sc->addr = 16*sc->addr + hex_digit_value(ch);
+		  if (ch != EOF) scan_ungetc(sc);
+		  return MEM_ADDRESS;
+
+		default:
+		  if (is_word_char(sc, ch)) {
+			scan_word(sc, ch, val);
+			return MEM_WORD;
+		  }
+		  sc->err[0] = ch;
+		  return MEM_ERROR;
+	    }
+      }
+}
+
+/*
+ * Words are collected in runs of consecutive addresses and written
+ * to the memory with a single vpip_put_array_words call. If the
+ * memory does not support bulk access, the words are written one at
+ * a time through their handles.
+ */
+struct readmem_run {
+      vpiHandle mitem;
+      int bulk;
+      int incr;
+      unsigned stride;
+      unsigned max;
+      int first;
+      unsigned count;
+      s_vpi_vecval*vals;
+};
+
+static void readmem_flush(struct readmem_run*run)
+{
+      unsigned idx;
+
+      if (run->count == 0) return;
+
+      if (!run->bulk || !vpip_put_array_words(run->mitem, run->first,
+                                              run->incr, run->count,
+                                              run->vals)) {
+	    s_vpi_value value;
+	    value.format = vpiVectorVal;
+	    for (idx = 0 ; idx < run->count ; idx += 1) {
+		  vpiHandle word_index;
+		  word_index = vpi_handle_by_index(run->mitem,
+		                                   run->first + (int)idx*run->incr);
+		  assert(word_index);
+		  value.value.vector = run->vals + idx*run->stride;
+		  vpi_put_value(word_index, &value, 0, vpiNoDelay);
+	    }
+      }
+      run->count = 0;
+}
+
+static void readmem_add_word(struct readmem_run*run, int addr,
+                             const s_vpi_vecval*val)
+{
+      if (run->count > 0 && (run->count == run->max ||
+			     addr != run->first + (int)run->count*run->incr))
+	    readmem_flush(run);
+      if (run->count == 0) run->first = addr;
+      memcpy(run->vals + run->count*run->stride, val,
+	     run->stride*sizeof(s_vpi_vecval));
+      run->count += 1;
+}
+
 static void get_mem_params(vpiHandle argv, vpiHandle callh, const char *name,
                            char **fname, vpiHandle *mitem,
                            vpiHandle *start_item, vpiHandle *stop_item)
@@ -263,7 +485,9 @@ static PLI_INT32 sys_readmem_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
       int code, wwid, addr;
       FILE*file;
       char *fname = 0;
-      s_vpi_value value;
+      s_vpi_vecval*value;
+      struct readmem_scan*scan;
+      struct readmem_run run;
       vpiHandle callh = vpi_handle(vpiSysTfCall, 0);
       vpiHandle argv = vpi_iterate(vpiArgument, callh);
       vpiHandle mitem = 0;
@@ -323,27 +547,38 @@ static PLI_INT32 sys_readmem_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 	/* We need this many words from the file. */
       word_count = max_addr-min_addr+1;
 
-      wwid = vpi_get(vpiSize, vpi_handle_by_index(mitem, min_addr));
-
-      /* variable that will be used by the lexer to pass values
-	 back to this code */
-      value.format = vpiVectorVal;
-      value.value.vector = calloc((wwid+31)/32, sizeof(s_vpi_vecval));
-
-      /* Configure the readmem lexer */
-      if (strcmp(name,"$readmemb") == 0)
-	  sys_readmem_start_file(file, 1, wwid, value.value.vector);
-      else
-	  sys_readmem_start_file(file, 0, wwid, value.value.vector);
+      /* Get the word width without making word handles if the
+	 memory can be loaded in bulk. */
+      run.mitem = mitem;
+      wwid = vpip_array_word_size(mitem);
+      run.bulk = wwid > 0;
+      if (! run.bulk)
+	  wwid = vpi_get(vpiSize, vpi_handle_by_index(mitem, min_addr));
+      run.incr = addr_incr;
+      run.stride = (wwid+31)/32;
+      run.max = 64*1024 / run.stride;
+      if (run.max == 0) run.max = 1;
+      run.first = 0;
+      run.count = 0;
+      run.vals = malloc(run.max*run.stride*sizeof(s_vpi_vecval));
+
+      /* The scanner decodes each word into this buffer. */
+      value = calloc(run.stride, sizeof(s_vpi_vecval));
+
+      /* Configure the scanner */
+      scan = calloc(1, sizeof(struct readmem_scan));
+      scan->file = file;
+      scan->bin_flag = strcmp(name,"$readmemb") == 0;
+      scan->wwid = wwid;
 
       /*======================================== Read memory file */
 
       /* Run through the input file and store the new contents in the memory */
       addr = start_addr;
-      while ((code = readmemlex()) != 0) {
+      while ((code = readmem_scan(scan, value)) != MEM_EOF) {
 	  switch (code) {
 	  case MEM_ADDRESS:
-	      addr = value.value.vector->aval;
+	      addr = scan->addr;
 	      if (addr < min_addr || addr > max_addr) {
 		  vpi_printf("ERROR: %s:%d: ", vpi_get_str(vpiFile, callh),
 		             (int)vpi_get(vpiLineNo, callh));
@@ -361,10 +596,7 @@ static PLI_INT32 sys_readmem_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 
 	  case MEM_WORD:
 	      if (addr >= min_addr && addr <= max_addr) {
-		  vpiHandle word_index;
-		  word_index = vpi_handle_by_index(mitem, addr);
-		  assert(word_index);
-		  vpi_put_value(word_index, &value, 0, vpiNoDelay);
+		  readmem_add_word(&run, addr, value);
 
 		  if (word_count > 0) word_count -= 1;
 	      } else {
@@ -383,7 +615,7 @@ static PLI_INT32 sys_readmem_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 	      vpi_printf("ERROR: %s:%d: ", vpi_get_str(vpiFile, callh),
 	                 (int)vpi_get(vpiLineNo, callh));
 	      vpi_printf("%s(%s): Invalid input character: %s\n", name,
-	                 fname, readmem_error_token);
+	                 fname, scan->err);
 	      goto bailout;
 	      break;
 
@@ -403,10 +635,13 @@ static PLI_INT32 sys_readmem_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
       }
 
  bailout:
-      free(value.value.vector);
+      readmem_flush(&run);
+      free(run.vals);
+      free(value);
+      free(scan->tok);
+      free(scan);
       free(fname);
       fclose(file);
-      destroy_readmem_lexor();
       return 0;
 }
 
@@ -509,12 +744,40 @@ static PLI_INT32 sys_readmempath_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
       return 0;
 }
 
+/*
+ * Format a memory word for $writemem the same way vpi_get_value
+ * formats a vpiHexStrVal or vpiBinStrVal value. A hex digit with some
+ * x or z bits is an X or Z, or an x or z if all its bits are x or z.
+ */
+static void format_mem_word(char*buf, const s_vpi_vecval*val,
+                            unsigned wid, int bin_flag)
+{
+      unsigned step = bin_flag? 1 : 4;
+      unsigned len = (wid + step - 1) / step;
+      unsigned idx, pos;
+
+      buf[len] = 0;
+      for (idx = len, pos = 0 ; idx > 0 ; idx -= 1, pos += step) {
+	    unsigned nbits = wid-pos < step? wid-pos : step;
+	    PLI_UINT32 mask = (1U << nbits) - 1U;
+	    PLI_UINT32 aval = ((PLI_UINT32)val[pos/32].aval >> pos%32) & mask;
+	    PLI_UINT32 bval = ((PLI_UINT32)val[pos/32].bval >> pos%32) & mask;
+	    PLI_UINT32 xbits = aval & bval;
+
+	    if (bval == 0) buf[idx-1] = "0123456789abcdef"[aval];
+	    else if (xbits == 0) buf[idx-1] = bval == mask? 'z' : 'Z';
+	    else buf[idx-1] = xbits == mask? 'x' : 'X';
+      }
+}
+
 static PLI_INT32 sys_writemem_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 {
-      int addr;
+      int addr, wwid, bin_flag;
       FILE*file;
       char*fname = 0;
-      unsigned cnt;
+      char*str;
+      unsigned cnt, total, stride, chunk, idx;
+      s_vpi_vecval*vals;
       s_vpi_value value;
       vpiHandle callh = vpi_handle(vpiSysTfCall, 0);
       vpiHandle argv = vpi_iterate(vpiArgument, callh);
@@ -523,7 +786,7 @@ static PLI_INT32 sys_writemem_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
       vpiHandle stop_item = 0;
 
       int start_addr, stop_addr, addr_incr;
-      int min_addr, max_addr; // Not used in this routine.
+      int min_addr, max_addr;
 
       /*======================================== Get parameters */
 
@@ -551,13 +814,43 @@ static PLI_INT32 sys_writemem_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 	    return 0;
       }
 
-      if (strcmp(name,"$writememb")==0) value.format = vpiBinStrVal;
+      bin_flag = strcmp(name,"$writememb")==0;
+      if (bin_flag) value.format = vpiBinStrVal;
       else value.format = vpiHexStrVal;
 
       /*======================================== Write memory file */
 
+      /* If the memory supports bulk access, read the words in chunks
+	 and format them here. Otherwise get each word as a string
+	 through its handle. */
+      wwid = vpip_array_word_size(mitem);
+      total = max_addr - min_addr + 1;
       cnt = 0;
-      for(addr=start_addr; addr!=stop_addr+addr_incr; addr+=addr_incr, ++cnt) {
+      addr = start_addr;
+      if (wwid > 0) {
+	  stride = (wwid+31)/32;
+	  chunk = 64*1024 / stride;
+	  if (chunk == 0) chunk = 1;
+	  vals = malloc(chunk*stride*sizeof(s_vpi_vecval));
+	  str = malloc(wwid+1);
+	  while (cnt < total) {
+	      unsigned count = total - cnt;
+	      if (count > chunk) count = chunk;
+	      if (! vpip_get_array_words(mitem, addr, addr_incr, count, vals))
+		  break;
+	      for (idx = 0 ; idx < count ; idx += 1, ++cnt) {
+		  if (cnt%16 == 0) fprintf(file, "// 0x%08x\n", cnt);
+		  format_mem_word(str, vals + idx*stride, wwid, bin_flag);
+		  fputs(str, file);
+		  fputc('\n', file);
+	      }
+	      addr += (int)count*addr_incr;
+	  }
+	  free(str);
+	  free(vals);
+      }
+
+      for( ; cnt < total; addr+=addr_incr, ++cnt) {
 	  vpiHandle word_index;
 
 	  if (cnt%16 == 0) fprintf(file, "// 0x%08x\n", cnt);
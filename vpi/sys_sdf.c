@@ -22,6 +22,7 @@
 # include  <stdlib.h>
 # include  <string.h>
 # include  <assert.h>
+# include  <time.h>
 
 /*
  * These are static context
@@ -37,14 +38,42 @@ static vpiHandle sdf_callh = 0;
   /* The cell in process. */
 static vpiHandle sdf_cur_cell;
 
+  /* Counts for the -sdf-info summary of an annotation. */
+static unsigned sdf_cell_count;
+static unsigned sdf_iopath_count;
+
+static unsigned hash_string(unsigned hash, const char*str)
+{
+      while (*str) {
+	    hash ^= (unsigned char) *str++;
+	    hash *= 16777619U;
+      }
+      return hash;
+}
+
+/*
+ * Find the module instance named name in scope. The name is looked up
+ * with vpi_handle_by_name, which the run time answers from its own
+ * index of the scope, so a CELL of a large gate level netlist does
+ * not cost a scan of all the instances around it. That lookup also
+ * matches the scope itself if it has the same name, so only take a
+ * module whose parent is the scope, and otherwise fall back to the
+ * scan of the modules in the scope.
+ */
 static vpiHandle find_scope(vpiHandle scope, const char*name)
 {
-      vpiHandle idx = vpi_iterate(vpiModule, scope);
+      vpiHandle idx, cur;
+
+      cur = vpi_handle_by_name(name, scope);
+      if (cur && vpi_get(vpiType, cur) == vpiModule
+	  && vpi_handle(vpiScope, cur) == scope)
+	    return cur;
+
+      idx = vpi_iterate(vpiModule, scope);
 	/* If this scope has no modules then it can't have the one we
 	 * are looking for so just return 0. */
       if (idx == 0) return 0;
 
-      vpiHandle cur;
       while ( (cur = vpi_scan(idx)) ) {
 
 	    if ( strcmp(name, vpi_get_str(vpiName,cur)) == 0) {
@@ -56,6 +85,132 @@ static vpiHandle find_scope(vpiHandle scope, const char*name)
       return 0;
 }
 
+/*
+ * The modpath index holds the modpaths of the current cell, keyed by
+ * the names of the source and destination ports. Paths with the same
+ * ports (but different edges) are chained in the order that the
+ * modpath iterator returned them, and the edge is checked while
+ * walking the chain, since an IOPATH with no edge matches all of
+ * them. The index is built the first time an IOPATH of the cell is
+ * processed and is dropped when another cell is selected.
+ */
+struct sdf_path_entry_s {
+      char*src;
+      char*dst;
+      vpiHandle path;
+      int edge;
+      unsigned hash;
+      int next;
+};
+
+static vpiHandle path_cell = 0;
+static struct sdf_path_entry_s*path_list = 0;
+static unsigned path_count = 0;
+static int*path_table = 0;
+static unsigned path_table_size = 0;
+
+static unsigned path_hash(const char*src, const char*dst)
+{
+      unsigned hash = hash_string(2166136261U, src);
+      hash ^= '/';
+      hash *= 16777619U;
+      return hash_string(hash, dst);
+}
+
+/*
+ * Return the slot of the path table that holds the head of the chain
+ * for (src,dst), or the empty slot (-1) where it would be.
+ */
+static int*path_slot(const char*src, const char*dst, unsigned hash)
+{
+      unsigned mask = path_table_size - 1;
+      unsigned idx = hash & mask;
+
+      while (path_table[idx] >= 0) {
+	    struct sdf_path_entry_s*cur = path_list + path_table[idx];
+	    if (cur->hash == hash && strcmp(src, cur->src) == 0
+		&& strcmp(dst, cur->dst) == 0)
+		  return path_table + idx;
+	    idx = (idx + 1) & mask;
+      }
+
+      return path_table + idx;
+}
+
+static void path_index_clear(void)
+{
+      unsigned idx;
+      for (idx = 0 ;  idx < path_count ;  idx += 1) {
+	    free(path_list[idx].src);
+	    free(path_list[idx].dst);
+      }
+      free(path_list);
+      free(path_table);
+      path_list = 0;
+      path_count = 0;
+      path_table = 0;
+      path_table_size = 0;
+      path_cell = 0;
+}
+
+static void path_index_build(vpiHandle cell)
+{
+      vpiHandle iter = vpi_iterate(vpiModPath, cell);
+      vpiHandle path;
+      unsigned list_size = 0;
+      unsigned idx;
+      int*tail;
+
+      path_index_clear();
+      path_cell = cell;
+
+      if (iter) while ( (path = vpi_scan(iter)) ) {
+	    struct sdf_path_entry_s*cur;
+
+	    vpiHandle path_t_in = vpi_handle(vpiModPathIn,path);
+	    vpiHandle path_t_out = vpi_handle(vpiModPathOut,path);
+
+	    vpiHandle path_in = vpi_handle(vpiExpr,path_t_in);
+	    vpiHandle path_out = vpi_handle(vpiExpr,path_t_out);
+
+	      /* The expressions for the path terms must be signals,
+	         vpiNet or vpiReg. */
+	    assert(vpi_get(vpiType,path_in) == vpiNet);
+	    assert(vpi_get(vpiType,path_out) == vpiNet
+		   || vpi_get(vpiType,path_out) == vpiReg);
+
+	    if (path_count == list_size) {
+		  list_size = list_size? 2*list_size : 16;
+		  path_list = realloc(path_list, list_size*sizeof(*path_list));
+	    }
+
+	    cur = path_list + path_count;
+	    cur->src = strdup(vpi_get_str(vpiName,path_in));
+	    cur->dst = strdup(vpi_get_str(vpiName,path_out));
+	    cur->path = path;
+	    cur->edge = vpi_get(vpiEdge,path_t_in);
+	    cur->hash = path_hash(cur->src, cur->dst);
+	    cur->next = -1;
+	    path_count += 1;
+      }
+
+      path_table_size = 16;
+      while (path_table_size < 2*path_count)
+	    path_table_size *= 2;
+      path_table = malloc(path_table_size*sizeof(*path_table));
+      for (idx = 0 ;  idx < path_table_size ;  idx += 1)
+	    path_table[idx] = -1;
+
+	/* Append each path to the end of its chain to keep the order. */
+      for (idx = 0 ;  idx < path_count ;  idx += 1) {
+	    struct sdf_path_entry_s*cur = path_list + idx;
+	    tail = path_slot(cur->src, cur->dst, cur->hash);
+	    while (*tail >= 0)
+		  tail = &path_list[*tail].next;
+	    *tail = idx;
+      }
+}
+
 /*
  * These functions are called by the SDF parser during parsing to
  * handling items discovered in the parse.
@@ -65,6 +220,8 @@ void sdf_select_instance(const char*celltype, const char*cellinst)
 {
       char buffer[128];
 
+      sdf_cell_count += 1;
+
 	/* First follow the hierarchical parts of the cellinst name to
 	   get to the cell that I'm looking for. */
       vpiHandle scope = sdf_scope;
@@ -138,46 +295,32 @@ static const char*edge_str(int vpi_edge)
 void sdf_iopath_delays(int vpi_edge, const char*src, const char*dst,
 		       const struct sdf_delval_list_s*delval_list)
 {
-      vpiHandle iter, path;
+      int cur;
       int match_count = 0;
 
       if (sdf_cur_cell == 0)
 	    return;
 
-      iter = vpi_iterate(vpiModPath, sdf_cur_cell);
+      if (path_cell != sdf_cur_cell)
+	    path_index_build(sdf_cur_cell);
 
-	/* Search for the modpath that matches the IOPATH by looking
-	   for the modpath that uses the same ports as the ports that
+      sdf_iopath_count += 1;
+
+	/* Search for the modpaths that match the IOPATH by looking
+	   up the modpaths that use the same ports as the ports that
 	   the parser has found. */
-      if (iter) while ( (path = vpi_scan(iter)) ) {
+      cur = *path_slot(src, dst, path_hash(src, dst));
+      for ( ; cur >= 0 ; cur = path_list[cur].next) {
+	    vpiHandle path = path_list[cur].path;
 	    s_vpi_delay delays;
 	    struct t_vpi_time delay_vals[12];
 	    int idx;
 
-	    vpiHandle path_t_in = vpi_handle(vpiModPathIn,path);
-	    vpiHandle path_t_out = vpi_handle(vpiModPathOut,path);
-
-	    vpiHandle path_in = vpi_handle(vpiExpr,path_t_in);
-	    vpiHandle path_out = vpi_handle(vpiExpr,path_t_out);
-
-	      /* The expressions for the path terms must be signals,
-	         vpiNet or vpiReg. */
-	    assert(vpi_get(vpiType,path_in) == vpiNet);
-	    assert(vpi_get(vpiType,path_out) == vpiNet
-		   || vpi_get(vpiType,path_out) == vpiReg);
-
-	      /* If the src name doesn't match, go on. */
-	    if (strcmp(src,vpi_get_str(vpiName,path_in)) != 0)
-		  continue;
 	      /* The edge type must match too. But note that if this
 	         IOPATH has no edge, then it matches with all edges of
 	         the modpath object. */
 /* --> Is this correct in the context of the 10, 01, etc. edges? */
-	    if (vpi_edge != vpiNoEdge && vpi_get(vpiEdge,path_t_in) != vpi_edge)
-		  continue;
-
-	      /* If the dst name doesn't match, go on. */
-	    if (strcmp(dst,vpi_get_str(vpiName,path_out)) != 0)
+	    if (vpi_edge != vpiNoEdge && path_list[cur].edge != vpi_edge)
 		  continue;
 
 	      /* Ah, this must be a match! */
@@ -287,6 +430,7 @@ static PLI_INT32 sys_sdf_annotate_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
       vpiHandle callh = vpi_handle(vpiSysTfCall, 0);
       vpiHandle argv = vpi_iterate(vpiArgument, callh);
       FILE *sdf_fd;
+      clock_t start;
       char *fname = get_filename(callh, name, vpi_scan(argv));
 
       if (fname == 0) {
@@ -315,9 +459,27 @@ static PLI_INT32 sys_sdf_annotate_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 
       sdf_cur_cell = 0;
       sdf_callh = callh;
+      sdf_cell_count = 0;
+      sdf_iopath_count = 0;
+      start = clock();
       sdf_process_file(sdf_fd, fname);
       sdf_callh = 0;
 
+	/* The modpath index is only kept for the length of an
+	   annotation. */
+      path_index_clear();
+
+      if (sdf_flag_inform) {
+	    double secs = (double)(clock() - start) / CLOCKS_PER_SEC;
+	    long bytes = ftell(sdf_fd);
+	    vpi_printf("%s:SDF INFO: Annotated %u cells and %u IOPATHs"
+		       " (%ld bytes) in %.2f seconds", fname,
+		       sdf_cell_count, sdf_iopath_count, bytes, secs);
+	    if (secs > 0.0)
+		  vpi_printf(", %.0f cells/s", sdf_cell_count / secs);
+	    vpi_printf(".\n");
+      }
+
       fclose(sdf_fd);
       free(fname);
       return 0;
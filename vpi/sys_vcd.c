@@ -28,9 +28,15 @@
 # include  <stdlib.h>
 # include  <string.h>
 # include  <assert.h>
+# include  <stdarg.h>
 # include  <time.h>
 # include  "ivl_alloc.h"
 
+#if defined(HAVE_LIBPTHREAD) && defined(__GNUC__)
+# define VCD_ASYNC_WRITER
+# include  <pthread.h>
+#endif
+
 static char *dump_path = NULL;
 static FILE *dump_file = NULL;
 
@@ -101,26 +107,401 @@ static char *truncate_bitvec(char *s)
       }
 }
 
+static void show_this_item(struct vcd_info*info);
+
+/*
+ * When threads are available the VCD text is written by a separate
+ * writer thread. The simulation thread captures each value change as
+ * a compact binary record (the raw aval/bval words of a vector, or a
+ * real value) in a single producer, single consumer ring buffer, and
+ * the writer thread formats the records and does the file I/O. Other
+ * output is passed through the ring as text so that everything reaches
+ * the file in order. The ring has a fixed size, and the simulation
+ * waits for the writer if it fills.
+ */
+#ifdef VCD_ASYNC_WRITER
+
+# define VCD_RING_SIZE (1024*1024)
+# define VCD_RING_MASK (VCD_RING_SIZE-1)
+# define VCD_ALIGN(x) (((x) + 7) & ~(size_t)7)
+
+enum vcd_record_kind {
+      VCD_REC_PAD,
+      VCD_REC_TEXT,
+      VCD_REC_VECTOR,
+      VCD_REC_REAL,
+      VCD_REC_EVENT,
+      VCD_REC_STOP
+};
+
+struct vcd_record {
+      unsigned kind;
+	/* Bytes of text, or the width of a vector. */
+      unsigned size;
+	/* Length of the record in the ring, including this header. */
+      size_t len;
+      const char *ident;
+};
+
+# define VCD_REC_HDR VCD_ALIGN(sizeof(struct vcd_record))
+
+static char *vcd_ring = 0;
+static size_t vcd_ring_head = 0;
+static size_t vcd_ring_tail = 0;
+  /* The producer fills records ahead of the head it has published. */
+static size_t vcd_ring_fill = 0;
+static int vcd_writer_waiting = 0;
+static int vcd_producer_waiting = 0;
+static int vcd_writer_running = 0;
+static pthread_t vcd_writer;
+static pthread_mutex_t vcd_ring_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t vcd_ring_data = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t vcd_ring_space = PTHREAD_COND_INITIALIZER;
+
+# define VCD_WORD_BITS (8*sizeof(unsigned long))
+
+static void vcd_write_vector(const struct vcd_record *rec)
+{
+      size_t words = (rec->size + VCD_WORD_BITS - 1) / VCD_WORD_BITS;
+      const unsigned long *abits = (const unsigned long*)
+                                   ((const char*)rec + VCD_REC_HDR);
+      const unsigned long *bbits = abits + words;
+      char buf[256];
+      char *str = rec->size < sizeof(buf) ? buf : malloc(rec->size+1);
+      unsigned idx;
+
+      for (idx = 0 ;  idx < rec->size ;  idx += 1) {
+	    unsigned bit = rec->size - idx - 1;
+	    unsigned long mask = 1UL << (bit % VCD_WORD_BITS);
+	    int aval = (abits[bit / VCD_WORD_BITS] & mask) != 0;
+	    int bval = (bbits[bit / VCD_WORD_BITS] & mask) != 0;
+	    str[idx] = bval ? (aval ? 'x' : 'z') : (aval ? '1' : '0');
+      }
+      str[rec->size] = 0;
+
+      if (rec->size == 1)
+	    fprintf(dump_file, "%s%s\n", str, rec->ident);
+      else
+	    fprintf(dump_file, "b%s %s\n", truncate_bitvec(str), rec->ident);
+
+      if (str != buf) free(str);
+}
+
+static void* vcd_writer_thread(void *arg)
+{
+      size_t tail = vcd_ring_tail;
+
+      (void)arg; /* Parameter is not used. */
+
+      for (;;) {
+	    size_t pos = tail & VCD_RING_MASK;
+	    const struct vcd_record *rec;
+	    int stop = 0;
+
+	    if (__atomic_load_n(&vcd_ring_head, __ATOMIC_ACQUIRE) == tail) {
+		  pthread_mutex_lock(&vcd_ring_lock);
+		  __atomic_store_n(&vcd_writer_waiting, 1, __ATOMIC_SEQ_CST);
+		  while (__atomic_load_n(&vcd_ring_head, __ATOMIC_SEQ_CST) == tail)
+			pthread_cond_wait(&vcd_ring_data, &vcd_ring_lock);
+		  __atomic_store_n(&vcd_writer_waiting, 0, __ATOMIC_SEQ_CST);
+		  pthread_mutex_unlock(&vcd_ring_lock);
+	    }
+
+	      /* A record never starts where there is no room left
+	         for its header. */
+	    if (VCD_RING_SIZE - pos < VCD_REC_HDR) {
+		  tail += VCD_RING_SIZE - pos;
+		  __atomic_store_n(&vcd_ring_tail, tail, __ATOMIC_SEQ_CST);
+		  continue;
+	    }
+
+	    rec = (const struct vcd_record*)(vcd_ring + pos);
+	    switch (rec->kind) {
+		case VCD_REC_PAD:
+		  break;
+		case VCD_REC_TEXT:
+		  fwrite((const char*)rec + VCD_REC_HDR, 1, rec->size,
+		         dump_file);
+		  break;
+		case VCD_REC_VECTOR:
+		  vcd_write_vector(rec);
+		  break;
+		case VCD_REC_REAL:
+		  fprintf(dump_file, "r%.16g %s\n",
+		          *(const double*)((const char*)rec + VCD_REC_HDR),
+		          rec->ident);
+		  break;
+		case VCD_REC_EVENT:
+		  fprintf(dump_file, "1%s\n", rec->ident);
+		  break;
+		case VCD_REC_STOP:
+		  stop = 1;
+		  break;
+		default:
+		  assert(0);
+	    }
+
+	    tail += rec->len;
+	    __atomic_store_n(&vcd_ring_tail, tail, __ATOMIC_SEQ_CST);
+	    if (__atomic_load_n(&vcd_producer_waiting, __ATOMIC_SEQ_CST)) {
+		  pthread_mutex_lock(&vcd_ring_lock);
+		  pthread_cond_signal(&vcd_ring_space);
+		  pthread_mutex_unlock(&vcd_ring_lock);
+	    }
+
+	    if (stop) return 0;
+      }
+}
+
+/*
+ * Wait until the ring has room for len more bytes. Waiting for the
+ * whole ring waits for the writer to consume everything.
+ */
+static void vcd_ring_wait(size_t len)
+{
+      if (vcd_ring_fill + len -
+          __atomic_load_n(&vcd_ring_tail, __ATOMIC_ACQUIRE) <= VCD_RING_SIZE)
+	    return;
+
+      pthread_mutex_lock(&vcd_ring_lock);
+      __atomic_store_n(&vcd_producer_waiting, 1, __ATOMIC_SEQ_CST);
+      while (vcd_ring_fill + len -
+             __atomic_load_n(&vcd_ring_tail, __ATOMIC_SEQ_CST) > VCD_RING_SIZE)
+	    pthread_cond_wait(&vcd_ring_space, &vcd_ring_lock);
+      __atomic_store_n(&vcd_producer_waiting, 0, __ATOMIC_SEQ_CST);
+      pthread_mutex_unlock(&vcd_ring_lock);
+}
+
+/*
+ * Reserve room for a record with the given payload size. The record
+ * is not visible to the writer until vcd_ring_commit() is called.
+ */
+static struct vcd_record* vcd_ring_reserve(unsigned kind, size_t payload)
+{
+      size_t len = VCD_REC_HDR + VCD_ALIGN(payload);
+      size_t room = VCD_RING_SIZE - (vcd_ring_fill & VCD_RING_MASK);
+      struct vcd_record *rec;
+
+      assert(len <= VCD_RING_SIZE/2);
+
+	/* Records do not wrap, so pad out the end of the ring. */
+      if (room < len) {
+	    vcd_ring_wait(room);
+	    if (room >= VCD_REC_HDR) {
+		  rec = (struct vcd_record*)
+		        (vcd_ring + (vcd_ring_fill & VCD_RING_MASK));
+		  rec->kind = VCD_REC_PAD;
+		  rec->len = room;
+	    }
+	    vcd_ring_fill += room;
+      }
+
+      vcd_ring_wait(len);
+      rec = (struct vcd_record*)(vcd_ring + (vcd_ring_fill & VCD_RING_MASK));
+      rec->kind = kind;
+      rec->size = 0;
+      rec->len = len;
+      rec->ident = 0;
+      return rec;
+}
+
+static void vcd_ring_commit(struct vcd_record *rec)
+{
+      vcd_ring_fill += rec->len;
+      __atomic_store_n(&vcd_ring_head, vcd_ring_fill, __ATOMIC_SEQ_CST);
+      if (__atomic_load_n(&vcd_writer_waiting, __ATOMIC_SEQ_CST)) {
+	    pthread_mutex_lock(&vcd_ring_lock);
+	    pthread_cond_signal(&vcd_ring_data);
+	    pthread_mutex_unlock(&vcd_ring_lock);
+      }
+}
+
+static void vcd_start_writer(void)
+{
+      vcd_ring = malloc(VCD_RING_SIZE);
+      vcd_ring_head = 0;
+      vcd_ring_tail = 0;
+      vcd_ring_fill = 0;
+      if (pthread_create(&vcd_writer, 0, vcd_writer_thread, 0) != 0) {
+	    free(vcd_ring);
+	    vcd_ring = 0;
+	    return;
+      }
+      vcd_writer_running = 1;
+}
+
+static void vcd_stop_writer(void)
+{
+      if (!vcd_writer_running) return;
+
+      vcd_ring_commit(vcd_ring_reserve(VCD_REC_STOP, 0));
+      pthread_join(vcd_writer, 0);
+      vcd_writer_running = 0;
+      free(vcd_ring);
+      vcd_ring = 0;
+}
+
+/*
+ * Wait for the writer to catch up, so that the simulation thread may
+ * use the dump file directly.
+ */
+static void vcd_sync(void)
+{
+      if (vcd_writer_running) vcd_ring_wait(VCD_RING_SIZE);
+}
+
+static void vcd_push_text(const char *text, size_t size)
+{
+      struct vcd_record *rec;
+
+      if (VCD_REC_HDR + VCD_ALIGN(size) > VCD_RING_SIZE/2) {
+	    vcd_sync();
+	    fwrite(text, 1, size, dump_file);
+	    return;
+      }
+
+      rec = vcd_ring_reserve(VCD_REC_TEXT, size);
+      rec->size = size;
+      memcpy((char*)rec + VCD_REC_HDR, text, size);
+      vcd_ring_commit(rec);
+}
+
+/*
+ * Capture the current value of the item. Vectors are captured as
+ * their a and b words, read directly from the signal where the run
+ * time supports it, which is much cheaper than building a string.
+ */
+static void vcd_push_item(struct vcd_info *info, PLI_INT32 type)
+{
+      s_vpi_value value;
+      struct vcd_record *rec;
+
+      if (type == vpiRealVar) {
+	    value.format = vpiRealVal;
+	    vpi_get_value(info->item, &value);
+	    rec = vcd_ring_reserve(VCD_REC_REAL, sizeof(double));
+	    *(double*)((char*)rec + VCD_REC_HDR) = value.value.real;
+      } else if (type == vpiNamedEvent) {
+	    rec = vcd_ring_reserve(VCD_REC_EVENT, 0);
+      } else {
+	    s_vpip_vec4_raw raw;
+	    int have_raw = vpip_get_vec4_raw(info->item, &raw);
+	    unsigned size = have_raw ? raw.size
+	                         : (unsigned)vpi_get(vpiSize, info->item);
+	    size_t words = (size + VCD_WORD_BITS - 1) / VCD_WORD_BITS;
+	    size_t bytes = 2 * words * sizeof(unsigned long);
+	    unsigned long *abits, *bbits;
+
+	    if (VCD_REC_HDR + VCD_ALIGN(bytes) > VCD_RING_SIZE/2) {
+		  vcd_sync();
+		  vcd_writer_running = 0;
+		  show_this_item(info);
+		  vcd_writer_running = 1;
+		  return;
+	    }
+
+	    rec = vcd_ring_reserve(VCD_REC_VECTOR, bytes);
+	    rec->size = size;
+	    abits = (unsigned long*)((char*)rec + VCD_REC_HDR);
+	    bbits = abits + words;
+
+	    if (have_raw) {
+		  assert(raw.word_bits == VCD_WORD_BITS);
+		  memcpy(abits, raw.aval, words * sizeof(unsigned long));
+		  memcpy(bbits, raw.bval, words * sizeof(unsigned long));
+	    } else {
+		  unsigned idx;
+		  value.format = vpiVectorVal;
+		  vpi_get_value(info->item, &value);
+		  memset(abits, 0, bytes);
+		  for (idx = 0 ;  idx < (size + 31) / 32 ;  idx += 1) {
+			unsigned wdx = idx * 32 / VCD_WORD_BITS;
+			unsigned sft = idx * 32 % VCD_WORD_BITS;
+			abits[wdx] |= (unsigned long)
+			      (PLI_UINT32)value.value.vector[idx].aval << sft;
+			bbits[wdx] |= (unsigned long)
+			      (PLI_UINT32)value.value.vector[idx].bval << sft;
+		  }
+	    }
+      }
+
+      rec->ident = info->ident;
+      vcd_ring_commit(rec);
+}
+
+#endif
+
+/*
+ * All the output to the dump file goes through these functions, so
+ * that it is kept in order with the value changes.
+ */
+static void vcd_printf(const char *fmt, ...)
+{
+      va_list ap;
+
+      va_start(ap, fmt);
+#ifdef VCD_ASYNC_WRITER
+      if (vcd_writer_running) {
+	    char buf[512];
+	    int len = vsnprintf(buf, sizeof(buf), fmt, ap);
+	    assert(len >= 0);
+	    if ((size_t)len < sizeof(buf)) {
+		  vcd_push_text(buf, len);
+	    } else {
+		  char *tmp = malloc(len+1);
+		  va_end(ap);
+		  va_start(ap, fmt);
+		  vsnprintf(tmp, len+1, fmt, ap);
+		  vcd_push_text(tmp, len);
+		  free(tmp);
+	    }
+	    va_end(ap);
+	    return;
+      }
+#endif
+      vfprintf(dump_file, fmt, ap);
+      va_end(ap);
+}
+
+static void vcd_flush(void)
+{
+#ifdef VCD_ASYNC_WRITER
+      vcd_sync();
+#endif
+      fflush(dump_file);
+}
+
+static long vcd_tell(void)
+{
+#ifdef VCD_ASYNC_WRITER
+      vcd_sync();
+#endif
+      return ftell(dump_file);
+}
+
 static void show_this_item(struct vcd_info*info)
 {
       s_vpi_value value;
       PLI_INT32 type = vpi_get(vpiType, info->item);
 
+#ifdef VCD_ASYNC_WRITER
+      if (vcd_writer_running) {
+	    vcd_push_item(info, type);
+	    return;
+      }
+#endif
+
       if (type == vpiRealVar) {
 	    value.format = vpiRealVal;
 	    vpi_get_value(info->item, &value);
-	    fprintf(dump_file, "r%.16g %s\n", value.value.real, info->ident);
+	    vcd_printf("r%.16g %s\n", value.value.real, info->ident);
       } else if (type == vpiNamedEvent) {
-	    fprintf(dump_file, "1%s\n", info->ident);
+	    vcd_printf("1%s\n", info->ident);
       } else if (vpi_get(vpiSize, info->item) == 1) {
-	    value.format = vpiBinStrVal;
-	    vpi_get_value(info->item, &value);
-	    fprintf(dump_file, "%s%s\n", value.value.str, info->ident);
+	    vcd_printf("%s%s\n", vcd_get_bits(info->item), info->ident);
       } else {
-	    value.format = vpiBinStrVal;
-	    vpi_get_value(info->item, &value);
-	    fprintf(dump_file, "b%s %s\n", truncate_bitvec(value.value.str),
-		    info->ident);
+	    vcd_printf("b%s %s\n", truncate_bitvec(vcd_get_bits(info->item)),
+		       info->ident);
       }
 }
 
@@ -131,13 +512,13 @@ static void show_this_item_x(struct vcd_info*info)
 
       if (type == vpiRealVar) {
 	      /* Some tools dump nothing here...? */
-	    fprintf(dump_file, "rNaN %s\n", info->ident);
+	    vcd_printf("rNaN %s\n", info->ident);
       } else if (type == vpiNamedEvent) {
 	    /* Do nothing for named events. */
       } else if (vpi_get(vpiSize, info->item) == 1) {
-	    fprintf(dump_file, "x%s\n", info->ident);
+	    vcd_printf("x%s\n", info->ident);
       } else {
-	    fprintf(dump_file, "bx %s\n", info->ident);
+	    vcd_printf("bx %s\n", info->ident);
       }
 }
 
@@ -183,7 +564,7 @@ static PLI_INT32 variable_cb_2(p_cb_data cause)
       PLI_UINT64 now = timerec_to_time64(cause->time);
 
       if (now != vcd_cur_time) {
-	    fprintf(dump_file, "#%" PLI_UINT64_FMT "\n", now);
+	    vcd_printf("#%" PLI_UINT64_FMT "\n", now);
 	    vcd_cur_time = now;
       }
 
@@ -207,12 +588,12 @@ static PLI_INT32 variable_cb_1(p_cb_data cause)
       if (dump_header_pending()) return 0;
       if (info->scheduled) return 0;
 
-      if ((dump_limit > 0) && (ftell(dump_file) > dump_limit)) {
+      if ((dump_limit > 0) && (vcd_tell() > dump_limit)) {
             dump_is_full = 1;
             vpi_printf("WARNING: Dump file limit (%ld bytes) "
                                "exceeded.\n", dump_limit);
-            fprintf(dump_file, "$comment Dump file limit (%ld bytes) "
-                               "exceeded. $end\n", dump_limit);
+            vcd_printf("$comment Dump file limit (%ld bytes) "
+                       "exceeded. $end\n", dump_limit);
             return 0;
       }
 
@@ -240,13 +621,13 @@ static PLI_INT32 dumpvars_cb(p_cb_data cause)
       dumpvars_time = timerec_to_time64(cause->time);
       vcd_cur_time = dumpvars_time;
 
-      fprintf(dump_file, "$enddefinitions $end\n");
+      vcd_printf("$enddefinitions $end\n");
 
       if (!dump_is_off) {
-	    fprintf(dump_file, "#%" PLI_UINT64_FMT "\n", dumpvars_time);
-	    fprintf(dump_file, "$dumpvars\n");
+	    vcd_printf("#%" PLI_UINT64_FMT "\n", dumpvars_time);
+	    vcd_printf("$dumpvars\n");
 	    vcd_checkpoint();
-	    fprintf(dump_file, "$end\n");
+	    vcd_printf("$end\n");
       }
 
       return 0;
@@ -263,9 +644,12 @@ static PLI_INT32 finish_cb(p_cb_data cause)
       dumpvars_time = timerec_to_time64(cause->time);
 
       if (!dump_is_off && !dump_is_full && dumpvars_time != vcd_cur_time) {
-	    fprintf(dump_file, "#%" PLI_UINT64_FMT "\n", dumpvars_time);
+	    vcd_printf("#%" PLI_UINT64_FMT "\n", dumpvars_time);
       }
 
+#ifdef VCD_ASYNC_WRITER
+      vcd_stop_writer();
+#endif
       fclose(dump_file);
 
       for (cur = vcd_list ;  cur ;  cur = next) {
@@ -332,13 +716,13 @@ static PLI_INT32 sys_dumpoff_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
       now64 = timerec_to_time64(&now);
 
       if (now64 > vcd_cur_time) {
-	    fprintf(dump_file, "#%" PLI_UINT64_FMT "\n", now64);
+	    vcd_printf("#%" PLI_UINT64_FMT "\n", now64);
 	    vcd_cur_time = now64;
       }
 
-      fprintf(dump_file, "$dumpoff\n");
+      vcd_printf("$dumpoff\n");
       vcd_checkpoint_x();
-      fprintf(dump_file, "$end\n");
+      vcd_printf("$end\n");
 
       return 0;
 }
@@ -362,13 +746,13 @@ static PLI_INT32 sys_dumpon_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
       now64 = timerec_to_time64(&now);
 
       if (now64 > vcd_cur_time) {
-	    fprintf(dump_file, "#%" PLI_UINT64_FMT "\n", now64);
+	    vcd_printf("#%" PLI_UINT64_FMT "\n", now64);
 	    vcd_cur_time = now64;
       }
 
-      fprintf(dump_file, "$dumpon\n");
+      vcd_printf("$dumpon\n");
       vcd_checkpoint();
-      fprintf(dump_file, "$end\n");
+      vcd_printf("$end\n");
 
       return 0;
 }
@@ -389,13 +773,13 @@ static PLI_INT32 sys_dumpall_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
       now64 = timerec_to_time64(&now);
 
       if (now64 > vcd_cur_time) {
-	    fprintf(dump_file, "#%" PLI_UINT64_FMT "\n", now64);
+	    vcd_printf("#%" PLI_UINT64_FMT "\n", now64);
 	    vcd_cur_time = now64;
       }
 
-      fprintf(dump_file, "$dumpall\n");
+      vcd_printf("$dumpall\n");
       vcd_checkpoint();
-      fprintf(dump_file, "$end\n");
+      vcd_printf("$end\n");
 
       return 0;
 }
@@ -423,6 +807,10 @@ static void open_dumpfile(vpiHandle callh)
 	    vpi_printf("VCD info: dumpfile %s opened for output.\n",
 	               dump_path);
 
+#ifdef VCD_ASYNC_WRITER
+	    vcd_start_writer();
+#endif
+
 	    time(&walltime);
 
 	    assert(prec >= -15);
@@ -435,15 +823,15 @@ static void open_dumpfile(vpiHandle callh)
 		  prec -= 1;
 	    }
 
-	    fprintf(dump_file, "$date\n");
-	    fprintf(dump_file, "\t%s",asctime(localtime(&walltime)));
-	    fprintf(dump_file, "$end\n");
-	    fprintf(dump_file, "$version\n");
-	    fprintf(dump_file, "\tIcarus Verilog\n");
-	    fprintf(dump_file, "$end\n");
-	    fprintf(dump_file, "$timescale\n");
-	    fprintf(dump_file, "\t%u%s\n", scale, units_names[udx]);
-	    fprintf(dump_file, "$end\n");
+	    vcd_printf("$date\n");
+	    vcd_printf("\t%s",asctime(localtime(&walltime)));
+	    vcd_printf("$end\n");
+	    vcd_printf("$version\n");
+	    vcd_printf("\tIcarus Verilog\n");
+	    vcd_printf("$end\n");
+	    vcd_printf("$timescale\n");
+	    vcd_printf("\t%u%s\n", scale, units_names[udx]);
+	    vcd_printf("$end\n");
       }
 }
 
@@ -485,7 +873,7 @@ static PLI_INT32 sys_dumpfile_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 static PLI_INT32 sys_dumpflush_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 {
       (void)name; /* Parameter is not used. */
-      if (dump_file) fflush(dump_file);
+      if (dump_file) vcd_flush();
 
       return 0;
 }
@@ -666,17 +1054,17 @@ static void scan_item(unsigned depth, vpiHandle item, int skip)
 	    if (item_type == vpiNamedEvent) size = 1;
 	    else size = vpi_get(vpiSize, item);
 
-	    fprintf(dump_file, "$var %s %u %s %s%s",
-		    type, size, ident, prefix, name);
+	    vcd_printf("$var %s %u %s %s%s",
+		       type, size, ident, prefix, name);
 
 	      /* Add a range for vectored values. */
 	    if (size > 1 || vpi_get(vpiLeftRange, item) != 0) {
-		  fprintf(dump_file, " [%i:%i]",
-			  (int)vpi_get(vpiLeftRange, item),
-			  (int)vpi_get(vpiRightRange, item));
+		  vcd_printf(" [%i:%i]",
+			     (int)vpi_get(vpiLeftRange, item),
+			     (int)vpi_get(vpiRightRange, item));
 	    }
 
-	    fprintf(dump_file, " $end\n");
+	    vcd_printf(" $end\n");
 	    break;
 
 	  case vpiModule:
@@ -717,7 +1105,7 @@ static void scan_item(unsigned depth, vpiHandle item, int skip)
 		  }
 
 		  name = vpi_get_str(vpiName, item);
-		  fprintf(dump_file, "$scope %s %s $end\n", type, name);
+		  vcd_printf("$scope %s %s $end\n", type, name);
 
 		  for (i=0; types[i]>0; i++) {
 			vpiHandle hand;
@@ -728,7 +1116,7 @@ static void scan_item(unsigned depth, vpiHandle item, int skip)
 		  }
 
 		    /* Sort any signals that we added above. */
-		  fprintf(dump_file, "$upscope $end\n");
+		  vcd_printf("$upscope $end\n");
 	    }
 	    break;
       }
@@ -762,7 +1150,7 @@ static int draw_scope(vpiHandle item, vpiHandle callh)
             assert(0);
       }
 
-      fprintf(dump_file, "$scope %s %s $end\n", type, name);
+      vcd_printf("$scope %s %s $end\n", type, name);
 
       return depth;
 }
@@ -855,7 +1243,7 @@ static PLI_INT32 sys_dumpvars_calltf(ICARUS_VPI_CONST PLI_BYTE8*name)
 	      /* The scope list must be sorted after we scan an item.  */
 	    vcd_names_sort(&vcd_tab);
 
-	    while (dep--) fprintf(dump_file, "$upscope $end\n");
+	    while (dep--) vcd_printf("$upscope $end\n");
 
 	      /* Add this signal to the variable list so we can verify it
 	       * is not included twice. This must be done after it has
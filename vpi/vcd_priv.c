@@ -130,6 +130,37 @@ void vcd_names_sort(struct vcd_names_list_s*tab)
       }
 }
 
+char *vcd_get_bits(vpiHandle item)
+{
+      static char *bits = 0;
+      static unsigned bits_size = 0;
+      s_vpip_vec4_raw raw;
+      s_vpi_value value;
+      unsigned idx;
+
+      if (! vpip_get_vec4_raw(item, &raw)) {
+	    value.format = vpiBinStrVal;
+	    vpi_get_value(item, &value);
+	    return value.value.str;
+      }
+
+      if (raw.size+1 > bits_size) {
+	    bits_size = raw.size+1;
+	    bits = realloc(bits, bits_size);
+      }
+
+      for (idx = 0 ;  idx < raw.size ;  idx += 1) {
+	    unsigned bit = raw.size - idx - 1;
+	    unsigned long mask = 1UL << (bit % raw.word_bits);
+	    int aval = (raw.aval[bit / raw.word_bits] & mask) != 0;
+	    int bval = (raw.bval[bit / raw.word_bits] & mask) != 0;
+	    bits[idx] = bval ? (aval ? 'x' : 'z') : (aval ? '1' : '0');
+      }
+      bits[raw.size] = 0;
+
+      return bits;
+}
+
 /*
  * Since the compiletf routines are all the same they are located here,
  * so we only need a single copy. Some are generic enough they can use
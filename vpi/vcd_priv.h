@@ -47,6 +47,14 @@ EXTERN void vcd_names_sort(struct vcd_names_list_s*tab);
 
 EXTERN void vcd_names_delete(struct vcd_names_list_s*tab);
 
+/*
+ * Get the value of a vector item as a string of 0/1/x/z characters,
+ * most significant bit first. This reads the value directly where
+ * the run time supports it, and otherwise uses vpiBinStrVal. The
+ * string is only valid until the next call.
+ */
+EXTERN char *vcd_get_bits(vpiHandle item);
+
 /*
  * Keep a map of nexus ident's to help with alias detection.
  */
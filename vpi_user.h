@@ -649,6 +649,45 @@ extern void vpip_mcd_rawwrite(PLI_UINT32 mcd, const char*buf, size_t count);
 extern void vpip_count_drivers(vpiHandle ref, unsigned idx,
                                unsigned counts[4]);
 
+  /* Get direct read-only access to the 4-state value of a vector net
+     or variable. The aval and bval arrays hold the bits in words of
+     word_bits bits, least significant first, using the same encoding
+     as s_vpi_vecval. Bits past the size in the last word are
+     undefined. The arrays are only valid until the simulation runs
+     again, so use them within a callback. The stamp increases every
+     time the value changes. This returns 0 if raw access is not
+     possible for the object (for example if it is forced or is not a
+     4-state vector), and the caller must then use vpi_get_value. */
+typedef struct t_vpip_vec4_raw {
+      PLI_UINT32 size;
+      PLI_UINT32 word_bits;
+      const unsigned long*aval;
+      const unsigned long*bval;
+      PLI_UINT64 stamp;
+} s_vpip_vec4_raw, *p_vpip_vec4_raw;
+
+extern int vpip_get_vec4_raw(vpiHandle ref, p_vpip_vec4_raw raw);
+
+  /* Bulk access to the words of a memory. The words are selected by
+     index as for vpi_handle_by_index, starting at 'index' and
+     stepping by 'incr' (1 or -1) for 'count' words. Each word takes
+     (size+31)/32 entries of the 'vals' array in the vpiVectorVal
+     encoding, where size is the value returned by
+     vpip_array_word_size. Putting a word has the same effect as
+     vpi_put_value with vpiNoDelay, but no word handles are created.
+     vpip_array_word_size returns 0 if bulk access is not possible for
+     the memory (for example a net or real array), and the put and get
+     functions return 0 if bulk access is not possible or any of the
+     words are out of range. The caller must then use the word
+     handles. */
+extern PLI_INT32 vpip_array_word_size(vpiHandle ref);
+extern int vpip_put_array_words(vpiHandle ref, PLI_INT32 index,
+                                PLI_INT32 incr, PLI_UINT32 count,
+                                const s_vpi_vecval*vals);
+extern int vpip_get_array_words(vpiHandle ref, PLI_INT32 index,
+                                PLI_INT32 incr, PLI_UINT32 count,
+                                s_vpi_vecval*vals);
+
 /*
  * Stopgap fix for br916. We need to reject any attempt to pass a thread
  * variable to $strobe or $monitor. To do this, we use some private VPI
@@ -40,9 +40,16 @@ unsigned long count_net_arrays = 0;
 unsigned long count_net_array_words = 0;
 unsigned long count_var_arrays = 0;
 unsigned long count_var_array_words = 0;
+unsigned long count_sparse_arrays = 0;
 unsigned long count_real_arrays = 0;
 unsigned long count_real_array_words = 0;
 
+/*
+ * Static variable arrays with at least this many words use sparse
+ * storage, so that a huge memory only costs what is written.
+ */
+static const unsigned SPARSE_ARRAY_WORDS = 1024*1024;
+
 static symbol_map_s<struct __vpiArray>* array_table =0;
 
 class vvp_fun_arrayport;
@@ -260,9 +267,7 @@ vpiHandle __vpiArray::get_iter_index(struct __vpiArrayIterator*, int idx)
 
       assert(vals4 || vals);
 
-      if (vals_words == 0) make_vals_words();
-
-      return &(vals_words[idx].as_word);
+      return word_handle(idx);
 }
 
 int __vpiArray::vpi_get(int code)
@@ -328,10 +333,7 @@ vpiHandle __vpiArray::vpi_index(int index)
 	    return nets[index];
       }
 
-      if (vals_words == 0)
-	    make_vals_words();
-
-      return &(vals_words[index].as_word);
+      return word_handle(index);
 }
 
 int __vpiArrayWord::as_word_t::vpi_get(int code)
@@ -743,6 +745,81 @@ string __vpiArray::get_word_str(unsigned address)
       return "";
 }
 
+/*
+ * The bulk access methods work directly on the word storage, so they
+ * do not need the per-word handles that vpi_handle_by_index would
+ * create for the whole array. Writes still go through set_word so
+ * that array ports and callbacks see the change.
+ */
+unsigned __vpiArray::bulk_word_size()
+{
+      if (nets != 0 || get_size() == 0)
+	    return 0;
+      if (vals4 != 0)
+	    return vals_width;
+      if (dynamic_cast<vvp_darray_real*>(vals) ||
+	  dynamic_cast<vvp_darray_string*>(vals) ||
+	  dynamic_cast<vvp_darray_object*>(vals))
+	    return 0;
+      return vals_width;
+}
+
+/*
+ * Convert the Verilog index of the first word to the canonical
+ * address, and check that the whole run is within the array.
+ */
+static bool bulk_range(__vpiArray*arr, int index, int incr, unsigned count,
+		       unsigned&address)
+{
+      long first = (long)index - arr->first_addr.get_value();
+      long last = first + (long)incr * ((long)count - 1);
+      if (count == 0 || first < 0 || last < 0)
+	    return false;
+      if (first >= (long)arr->get_size() || last >= (long)arr->get_size())
+	    return false;
+
+      address = first;
+      return true;
+}
+
+bool __vpiArray::put_words(int index, int incr, unsigned count,
+			   const s_vpi_vecval*src)
+{
+      unsigned width = bulk_word_size();
+      unsigned address;
+      if (width == 0 || ! bulk_range(this, index, incr, count, address))
+	    return false;
+
+      unsigned stride = (width + 31) / 32;
+      vvp_vector4_t tmp (width);
+      for (unsigned idx = 0 ;  idx < count ;  idx += 1) {
+	    tmp.set_vecval(src);
+	    set_word(address, 0, tmp);
+	    address += incr;
+	    src += stride;
+      }
+      return true;
+}
+
+bool __vpiArray::get_words(int index, int incr, unsigned count,
+			   s_vpi_vecval*dst)
+{
+      unsigned width = bulk_word_size();
+      unsigned address;
+      if (width == 0 || ! bulk_range(this, index, incr, count, address))
+	    return false;
+
+      unsigned stride = (width + 31) / 32;
+      for (unsigned idx = 0 ;  idx < count ;  idx += 1) {
+	    vvp_vector4_t tmp = get_word(address);
+	    assert(tmp.size() == width);
+	    tmp.get_vecval(dst);
+	    address += incr;
+	    dst += stride;
+      }
+      return true;
+}
+
 vpiHandle vpip_make_array(char*label, const char*name,
 				 int first_addr, int last_addr,
 				 bool signed_flag)
@@ -777,7 +854,6 @@ vpiHandle vpip_make_array(char*label, const char*name,
       obj->vals4 = 0;
       obj->vals  = 0;
       obj->vals_width = 0;
-      obj->vals_words = 0;
 
 	// Initialize (clear) the read-ports list.
       obj->ports_ = 0;
@@ -858,6 +934,10 @@ void compile_var_array(char*label, char*name, int last, int first,
       if (vpip_peek_current_scope()->is_automatic()) {
             arr->vals4 = new vvp_vector4array_aa(arr->vals_width,
 						 arr->get_size());
+      } else if (arr->get_size() >= SPARSE_ARRAY_WORDS) {
+            arr->vals4 = new vvp_vector4array_sparse(arr->vals_width,
+						     arr->get_size());
+	    count_sparse_arrays += 1;
       } else {
             arr->vals4 = new vvp_vector4array_sa(arr->vals_width,
 						 arr->get_size());
@@ -1511,7 +1591,6 @@ void compile_array_alias(char*label, char*name, char*src)
       obj->vals4 = mem->vals4;
       obj->vals  = mem->vals;
       obj->vals_width = mem->vals_width;
-      obj->vals_words = mem->vals_words;
 
       obj->ports_ = 0;
       obj->vpi_callbacks = 0;
@@ -1616,7 +1695,6 @@ void compile_array_cleanup(void)
 void memory_delete(vpiHandle item)
 {
       struct __vpiArray*arr = (struct __vpiArray*) item;
-      if (arr->vals_words) delete [] (arr->vals_words-1);
 
 //      if (arr->vals4) {}
 // Delete the individual words?
@@ -20,6 +20,7 @@
  */
 
 #include "array_common.h"
+#include "statistics.h"
 
 vpiHandle __vpiArrayBase::vpi_array_base_iterate(int code)
 {
@@ -37,20 +38,72 @@ vpiHandle __vpiArrayBase::vpi_array_base_iterate(int code)
     return 0;
 }
 
-void __vpiArrayBase::make_vals_words()
+__vpiArrayBase::~__vpiArrayBase()
 {
-    assert(vals_words == 0);
-    vals_words = new struct __vpiArrayWord[get_size() + 1];
+      if (word_table_ == 0) return;
+      for (unsigned idx = 0 ; idx <= word_mask_ ; idx += 1)
+	    delete word_table_[idx];
+      delete[]word_table_;
+}
 
-    // Make word[-1] point to the parent.
-    vals_words->parent = this;
-    // Now point to word-0
-    vals_words += 1;
+/*
+ * The word handles are kept in an open addressed hash table with
+ * linear probing, indexed by the word address. The table doubles
+ * when it gets half full, so a VPI application that touches a few
+ * words of a large memory only pays for those words.
+ */
+static inline unsigned word_hash(unsigned idx)
+{
+      return idx * 2654435761U;
+}
 
-    struct __vpiArrayWord*words = vals_words;
-    for (unsigned idx = 0 ; idx < get_size() ; idx += 1) {
-            words[idx].word0 = words;
-    }
+void __vpiArrayBase::grow_word_table_()
+{
+      struct __vpiArrayWord**old_table = word_table_;
+      unsigned old_size = word_table_? word_mask_+1 : 0;
+      unsigned new_size = old_size? 2*old_size : 16;
+
+      word_table_ = new struct __vpiArrayWord*[new_size];
+      word_mask_ = new_size - 1;
+      for (unsigned idx = 0 ; idx < new_size ; idx += 1)
+	    word_table_[idx] = 0;
+
+      for (unsigned idx = 0 ; idx < old_size ; idx += 1) {
+	    struct __vpiArrayWord*cur = old_table[idx];
+	    if (cur == 0) continue;
+	    unsigned pos = word_hash(cur->index) & word_mask_;
+	    while (word_table_[pos])
+		  pos = (pos + 1) & word_mask_;
+	    word_table_[pos] = cur;
+      }
+      delete[]old_table;
+}
+
+vpiHandle __vpiArrayBase::word_handle(unsigned idx)
+{
+      if (word_table_) {
+	    unsigned pos = word_hash(idx) & word_mask_;
+	    while (struct __vpiArrayWord*cur = word_table_[pos]) {
+		  if (cur->index == idx)
+			return &cur->as_word;
+		  pos = (pos + 1) & word_mask_;
+	    }
+      }
+
+      if (word_table_ == 0 || 2*(word_count_+1) > word_mask_+1)
+	    grow_word_table_();
+
+      unsigned pos = word_hash(idx) & word_mask_;
+      while (word_table_[pos])
+	    pos = (pos + 1) & word_mask_;
+
+      struct __vpiArrayWord*word = new struct __vpiArrayWord;
+      word->parent = this;
+      word->index = idx;
+      word_table_[pos] = word;
+      word_count_ += 1;
+      count_array_word_handles += 1;
+      return &word->as_word;
 }
 
 vpiHandle __vpiArrayIterator::vpi_index(int)
@@ -48,19 +48,15 @@ struct __vpiArrayIndex : public __vpiHandle {
 };
 
 /*
- * The vpiArrayWord is magic. It is used as the handle to return when
- * vpi code tries to index or scan an array of variable words. The
- * array word handle contains no actual data. It is just a hook for
- * the vpi methods and to point to the parent.
+ * The vpiArrayWord is used as the handle to return when vpi code
+ * tries to index or scan an array of variable words. The array word
+ * handle contains no actual data. It is just a hook for the vpi
+ * methods, and holds the parent and the index of the word in the
+ * parent.
  *
- * How the point to the parent works is tricky. The vpiArrayWord
- * objects for an array are themselves allocated as an array. All the
- * ArrayWord objects in the array have a word0 that points to the base
- * of the array. Thus, the position into the array (and the index into
- * the memory) is calculated by subtracting word0 from the ArrayWord
- * pointer.
- *
- * To then get to the parent, use word0[-1].parent.
+ * The word handles are made on demand by __vpiArrayBase::word_handle,
+ * which keeps them in a hash table indexed by the word address, so a
+ * word always gets the same handle.
  *
  * The vpiArrayWord is also used as a handle for the index (vpiIndex)
  * for the word. To make that work, return the pointer to the as_index
@@ -83,13 +79,11 @@ struct __vpiArrayWord {
 	    void vpi_get_value(p_vpi_value val);
       } as_index;
 
-      union {
-	    struct __vpiArrayBase*parent;
-	    struct __vpiArrayWord*word0;
-      };
+      struct __vpiArrayBase*parent;
+      unsigned index;
 
-      inline unsigned get_index() const { return this - word0; }
-      inline struct __vpiArrayBase*get_parent() const { return (word0 - 1)->parent; }
+      inline unsigned get_index() const { return index; }
+      inline struct __vpiArrayBase*get_parent() const { return parent; }
 };
 
 struct __vpiArrayWord*array_var_word_from_handle(vpiHandle ref);
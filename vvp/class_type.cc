@@ -22,6 +22,7 @@
 # include  "vpi_priv.h"
 # include  "config.h"
 # include  <map>
+# include  <cstring>
 #ifdef CHECK_WITH_VALGRIND
 # include  "vvp_cleanup.h"
 #endif
@@ -40,6 +41,9 @@ class class_property_t {
       virtual ~class_property_t() =0;
 	// How much space does an instance of this property require?
       virtual size_t instance_size() const =0;
+	// True if the constructed property is plain data that can be
+	// copied from another freshly constructed instance.
+      virtual bool plain_data() const { return false; }
 
       void set_offset(size_t off) { offset_ = off; }
 
@@ -128,6 +132,7 @@ template <class T> class property_atom : public class_property_t {
       ~property_atom() { }
 
       size_t instance_size() const { return sizeof(T); }
+      bool plain_data() const { return true; }
 
     public:
       void construct(char*buf) const
@@ -197,6 +202,7 @@ template <class T> class property_real : public class_property_t {
       ~property_real() { }
 
       size_t instance_size() const { return sizeof(T); }
+      bool plain_data() const { return true; }
 
     public:
       void construct(char*buf) const
@@ -396,16 +402,26 @@ void property_object::copy(char*dst, char*src)
 
 /* **** */
 
+static vector<class_type*> class_type_list;
+
 class_type::class_type(const string&nam, size_t nprop)
 : class_name_(nam), properties_(nprop)
 {
       instance_size_ = 0;
+      image_ = 0;
+      slot_size_ = 0;
+      free_list_ = 0;
+      live_count_ = 0;
+      peak_count_ = 0;
 }
 
 class_type::~class_type()
 {
       for (size_t idx = 0 ; idx < properties_.size() ; idx += 1)
 	    delete properties_[idx].type;
+      delete[]image_;
+      for (size_t idx = 0 ; idx < chunks_.size() ; idx += 1)
+	    delete[]chunks_[idx];
 }
 
 void class_type::set_property(size_t idx, const string&name, const string&type, uint64_t array_size)
@@ -475,14 +491,54 @@ void class_type::finish_setup(void)
 		  accum += cur->first;
 	    }
       }
+
+	// Each slot in a chunk holds an instance, or the free list
+	// link while the slot is not in use. Keep the slots aligned
+	// for the largest property types.
+      const size_t align = sizeof(double) > sizeof(char*)? sizeof(double) : sizeof(char*);
+      slot_size_ = instance_size_ < sizeof(char*)? sizeof(char*) : instance_size_;
+      slot_size_ = (slot_size_ + align - 1) / align * align;
+
+	// Construct the plain data properties into the image, and
+	// list the rest to be constructed in each new instance.
+      image_ = new char [slot_size_];
+      memset(image_, 0, slot_size_);
+      for (size_t idx = 0 ; idx < properties_.size() ; idx += 1) {
+	    class_property_t*ptype = properties_[idx].type;
+	    if (ptype->plain_data())
+		  ptype->construct(image_);
+	    else
+		  construct_list_.push_back(ptype);
+      }
+
+      class_type_list.push_back(this);
 }
 
 class_type::inst_t class_type::instance_new() const
 {
-      char*buf = new char [instance_size_];
+      if (free_list_ == 0) {
+	      // Make each new chunk twice as big as the last, so that
+	      // classes with many instances need few chunks.
+	    size_t count = 16 << (chunks_.size() < 10? chunks_.size() : 10);
+	    char*chunk = new char [count*slot_size_];
+	    chunks_.push_back(chunk);
+	    for (size_t idx = count ; idx > 0 ; idx -= 1) {
+		  char*slot = chunk + (idx-1)*slot_size_;
+		  *reinterpret_cast<char**> (slot) = free_list_;
+		  free_list_ = slot;
+	    }
+      }
 
-      for (size_t idx = 0 ; idx < properties_.size() ; idx += 1)
-	    properties_[idx].type->construct(buf);
+      char*buf = free_list_;
+      free_list_ = *reinterpret_cast<char**> (buf);
+
+      memcpy(buf, image_, instance_size_);
+      for (size_t idx = 0 ; idx < construct_list_.size() ; idx += 1)
+	    construct_list_[idx]->construct(buf);
+
+      live_count_ += 1;
+      if (live_count_ > peak_count_)
+	    peak_count_ = live_count_;
 
       return reinterpret_cast<inst_t> (buf);
 }
@@ -491,10 +547,22 @@ void class_type::instance_delete(class_type::inst_t obj) const
 {
       char*buf = reinterpret_cast<char*> (obj);
 
-      for (size_t idx = 0 ; idx < properties_.size() ; idx += 1)
-	    properties_[idx].type->destruct(buf);
+      for (size_t idx = 0 ; idx < construct_list_.size() ; idx += 1)
+	    construct_list_[idx]->destruct(buf);
 
-      delete[]buf;
+      *reinterpret_cast<char**> (buf) = free_list_;
+      free_list_ = buf;
+      live_count_ -= 1;
+}
+
+void print_class_statistics(void)
+{
+      for (size_t idx = 0 ; idx < class_type_list.size() ; idx += 1) {
+	    const class_type*cur = class_type_list[idx];
+	    vpi_mcd_printf(1, "    %8zu %s objects live (peak=%zu)\n",
+			   cur->live_count(), cur->class_name().c_str(),
+			   cur->peak_count());
+      }
 }
 
 void class_type::set_vec4(class_type::inst_t obj, size_t pid,
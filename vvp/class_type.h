@@ -60,6 +60,11 @@ class class_type : public __vpiHandle {
       inst_t instance_new() const;
       void instance_delete(inst_t) const;
 
+	// Number of instances that exist now, and the most that
+	// existed at any one time.
+      inline size_t live_count(void) const { return live_count_; }
+      inline size_t peak_count(void) const { return peak_count_; }
+
       void set_vec4(inst_t inst, size_t pid, const vvp_vector4_t&val) const;
       void get_vec4(inst_t inst, size_t pid, vvp_vector4_t&val) const;
       void set_real(inst_t inst, size_t pid, double val) const;
@@ -83,6 +88,25 @@ class class_type : public __vpiHandle {
       };
       std::vector<prop_t> properties_;
       size_t instance_size_;
+
+	// A new instance starts as a copy of the image_, which holds
+	// the initial values of the plain data properties. Only the
+	// properties in construct_list_ then need to be constructed.
+      char*image_;
+      std::vector<class_property_t*> construct_list_;
+
+	// Instances are carved out of chunks, and deleted instances
+	// are kept on the free_list_ to be reused.
+      size_t slot_size_;
+      mutable char*free_list_;
+      mutable std::vector<char*> chunks_;
+      mutable size_t live_count_;
+      mutable size_t peak_count_;
 };
 
+/*
+ * Print the live and peak instance counts of all the classes.
+ */
+extern void print_class_statistics(void);
+
 #endif /* IVL_class_type_H */
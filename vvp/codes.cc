@@ -96,6 +96,103 @@ vvp_code_t codespace_null(void)
       return first_chunk + 0;
 }
 
+/*
+ * Test if the instruction at idx in the chunk is the start of a
+ * sequence that can be fused, and if so replace its opcode with the
+ * fused opcode. The count is the number of instructions in the chunk
+ * that can be examined, so the sequence may not run off the end of
+ * the chunk.
+ */
+static bool fuse_instruction(vvp_code_t chunk, unsigned idx, unsigned count)
+{
+      vvp_code_t cp = chunk + idx;
+      unsigned avail = count - idx;
+
+      if (cp->opcode == &of_LOAD_VEC4) {
+	    if (avail >= 3
+		&& cp[1].opcode == &of_CMPIE
+		&& cp[2].opcode == &of_JMP0XZ) {
+		  cp->opcode = &of_LOAD_CMPIE_JMP0XZ;
+		  return true;
+	    }
+	    if (avail >= 4
+		&& cp[1].opcode == &of_PUSHI_VEC4
+		&& cp[2].opcode == &of_CMPE
+		&& cp[3].opcode == &of_JMP0XZ) {
+		  cp->opcode = &of_LOAD_PUSHI_CMPE_JMP0XZ;
+		  return true;
+	    }
+	    if (avail >= 3
+		&& cp[1].opcode == &of_ADDI
+		&& cp[2].opcode == &of_STORE_VEC4) {
+		  cp->opcode = &of_LOAD_ADDI_STORE_VEC4;
+		  return true;
+	    }
+	    return false;
+      }
+
+      if (cp->opcode == &of_JMP && cp->cptr && cp->cptr->opcode == &of_WAIT) {
+	    cp->opcode = &of_JMP_WAIT;
+	    return true;
+      }
+
+      return false;
+}
+
+unsigned long codespace_fuse(void)
+{
+      unsigned long fused = 0;
+
+      for (vvp_code_t chunk = first_chunk ; chunk ; ) {
+	    unsigned count = code_chunk_size-1;
+	    if (chunk == current_chunk)
+		  count = current_within_chunk;
+
+	    for (unsigned idx = 0 ; idx < count ; idx += 1) {
+		  if (fuse_instruction(chunk, idx, count))
+			fused += 1;
+	    }
+
+	    if (chunk == current_chunk)
+		  break;
+	    chunk = chunk[code_chunk_size-1].cptr;
+      }
+
+      return fused;
+}
+
+void codespace_predecode(void)
+{
+      for (vvp_code_t chunk = first_chunk ; chunk ; ) {
+	    unsigned count = code_chunk_size;
+	    if (chunk == current_chunk)
+		  count = current_within_chunk;
+
+	    for (unsigned idx = 0 ; idx < count ; idx += 1)
+		  vthread_predecode(chunk+idx);
+
+	    if (chunk == current_chunk)
+		  break;
+	    chunk = chunk[code_chunk_size-1].cptr;
+      }
+}
+
+void codespace_walk(void (*fun)(vvp_code_t code, void*data), void*data)
+{
+      for (vvp_code_t chunk = first_chunk ; chunk ; ) {
+	    unsigned count = code_chunk_size - 1;
+	    if (chunk == current_chunk)
+		  count = current_within_chunk;
+
+	    for (unsigned idx = 0 ; idx < count ; idx += 1)
+		  fun(chunk+idx, data);
+
+	    if (chunk == current_chunk)
+		  break;
+	    chunk = chunk[code_chunk_size-1].cptr;
+      }
+}
+
 #ifdef CHECK_WITH_VALGRIND
 void codespace_delete(void)
 {
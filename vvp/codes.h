@@ -184,8 +184,10 @@ extern bool of_POP_VEC4(vthread_t thr, vvp_code_t code);
 extern bool of_POW(vthread_t thr, vvp_code_t code);
 extern bool of_POW_S(vthread_t thr, vvp_code_t code);
 extern bool of_POW_WR(vthread_t thr, vvp_code_t code);
+extern bool of_QPOP_B_OBJ(vthread_t thr, vvp_code_t code);
 extern bool of_QPOP_B_STR(vthread_t thr, vvp_code_t code);
 extern bool of_QPOP_B_V(vthread_t thr, vvp_code_t code);
+extern bool of_QPOP_F_OBJ(vthread_t thr, vvp_code_t code);
 extern bool of_QPOP_F_STR(vthread_t thr, vvp_code_t code);
 extern bool of_QPOP_F_V(vthread_t thr, vvp_code_t code);
 extern bool of_PROP_OBJ(vthread_t thr, vvp_code_t code);
@@ -219,12 +221,16 @@ extern bool of_SPLIT_VEC4(vthread_t thr, vvp_code_t code);
 extern bool of_STORE_DAR_R(vthread_t thr, vvp_code_t code);
 extern bool of_STORE_DAR_STR(vthread_t thr, vvp_code_t code);
 extern bool of_STORE_DAR_VEC4(vthread_t thr, vvp_code_t code);
+extern bool of_STORE_QB_OBJ(vthread_t thr, vvp_code_t code);
 extern bool of_STORE_QB_R(vthread_t thr, vvp_code_t code);
 extern bool of_STORE_QB_STR(vthread_t thr, vvp_code_t code);
 extern bool of_STORE_QB_V(vthread_t thr, vvp_code_t code);
+extern bool of_STORE_QB_VEC2(vthread_t thr, vvp_code_t code);
+extern bool of_STORE_QF_OBJ(vthread_t thr, vvp_code_t code);
 extern bool of_STORE_QF_R(vthread_t thr, vvp_code_t code);
 extern bool of_STORE_QF_STR(vthread_t thr, vvp_code_t code);
 extern bool of_STORE_QF_V(vthread_t thr, vvp_code_t code);
+extern bool of_STORE_QF_VEC2(vthread_t thr, vvp_code_t code);
 extern bool of_STORE_OBJ(vthread_t thr, vvp_code_t code);
 extern bool of_STORE_OBJA(vthread_t thr, vvp_code_t code);
 extern bool of_STORE_PROP_OBJ(vthread_t thr, vvp_code_t code);
@@ -262,6 +268,16 @@ extern bool of_REAP_UFUNC(vthread_t thr, vvp_code_t code);
 
 extern bool of_CHUNK_LINK(vthread_t thr, vvp_code_t code);
 
+/*
+ * These are fused instructions that codespace_fuse() substitutes for
+ * the first instruction of common sequences. They take the operands
+ * of the rest of the sequence from the instructions that follow.
+ */
+extern bool of_JMP_WAIT(vthread_t thr, vvp_code_t code);
+extern bool of_LOAD_ADDI_STORE_VEC4(vthread_t thr, vvp_code_t code);
+extern bool of_LOAD_CMPIE_JMP0XZ(vthread_t thr, vvp_code_t code);
+extern bool of_LOAD_PUSHI_CMPE_JMP0XZ(vthread_t thr, vvp_code_t code);
+
 /*
  * This is the format of a machine code instruction.
  */
@@ -284,6 +300,11 @@ struct vvp_code_s {
 	    vvp_code_t   cptr2;
 	    class ufunc_core*ufunc_core_ptr;
       };
+
+	/* This is filled in by codespace_predecode() and selects how
+	   the threaded engine in vthread_run() executes the
+	   instruction. Zero means call the opcode function. */
+      unsigned char dispatch;
 };
 
 /*
@@ -304,4 +325,29 @@ extern vvp_code_t codespace_allocate(void);
 extern vvp_code_t codespace_next(void);
 extern vvp_code_t codespace_null(void);
 
+/*
+ * Walk all the instructions in the code space looking for common
+ * instruction sequences, and replace the opcode of the first
+ * instruction in each with a fused opcode that executes the whole
+ * sequence. The rest of the instructions are left in place, so jumps
+ * into the middle of a sequence still work. This is done after
+ * compile_cleanup() has resolved all the labels, and returns the
+ * number of sequences that were fused.
+ */
+extern unsigned long codespace_fuse(void);
+
+/*
+ * Walk all the instructions in the code space and fill in their
+ * dispatch field for the threaded execution engine. This is done
+ * after compile_cleanup() has resolved all the labels.
+ */
+extern void codespace_predecode(void);
+
+/*
+ * Call the function for every instruction in the code space, in the
+ * order that the instructions were compiled.
+ */
+extern void codespace_walk(void (*fun)(vvp_code_t code, void*data),
+			   void*data);
+
 #endif /* IVL_codes_H */
@@ -244,8 +244,10 @@ static const struct opcode_table_s opcode_table[] = {
       { "%pushi/vec4",of_PUSHI_VEC4,3,{OA_BIT1,   OA_BIT2,   OA_NUMBER} },
       { "%pushv/str", of_PUSHV_STR, 0,{OA_NONE,   OA_NONE,   OA_NONE} },
       { "%putc/str/vec4",of_PUTC_STR_VEC4,2,{OA_FUNC_PTR,OA_BIT1,OA_NONE} },
+      { "%qpop/b/obj",of_QPOP_B_OBJ,1,{OA_FUNC_PTR,OA_NONE,  OA_NONE} },
       { "%qpop/b/str",of_QPOP_B_STR,1,{OA_FUNC_PTR,OA_NONE,  OA_NONE} },
       { "%qpop/b/v",  of_QPOP_B_V,  1,{OA_FUNC_PTR,OA_NONE,  OA_BIT2} },
+      { "%qpop/f/obj",of_QPOP_F_OBJ,1,{OA_FUNC_PTR,OA_NONE,  OA_NONE} },
       { "%qpop/f/str",of_QPOP_F_STR,1,{OA_FUNC_PTR,OA_NONE,  OA_NONE} },
       { "%qpop/f/v",  of_QPOP_F_V,  1,{OA_FUNC_PTR,OA_NONE,  OA_BIT2} },
       { "%release/net",of_RELEASE_NET,3,{OA_FUNC_PTR,OA_BIT1,OA_BIT2} },
@@ -275,12 +277,16 @@ static const struct opcode_table_s opcode_table[] = {
       { "%store/prop/r",  of_STORE_PROP_R,  1, {OA_NUMBER,  OA_NONE, OA_NONE} },
       { "%store/prop/str",of_STORE_PROP_STR,1, {OA_NUMBER,  OA_NONE, OA_NONE} },
       { "%store/prop/v",  of_STORE_PROP_V,  2, {OA_NUMBER,  OA_BIT1, OA_NONE} },
+      { "%store/qb/obj", of_STORE_QB_OBJ,  1, {OA_FUNC_PTR, OA_NONE, OA_NONE} },
       { "%store/qb/r",   of_STORE_QB_R,    1, {OA_FUNC_PTR, OA_NONE, OA_NONE} },
       { "%store/qb/str", of_STORE_QB_STR,  1, {OA_FUNC_PTR, OA_NONE, OA_NONE} },
       { "%store/qb/v",   of_STORE_QB_V,    2, {OA_FUNC_PTR, OA_BIT1, OA_NONE} },
+      { "%store/qb/vec2",of_STORE_QB_VEC2, 2, {OA_FUNC_PTR, OA_BIT1, OA_NONE} },
+      { "%store/qf/obj", of_STORE_QF_OBJ,  1, {OA_FUNC_PTR, OA_NONE, OA_NONE} },
       { "%store/qf/r",   of_STORE_QF_R,    1, {OA_FUNC_PTR, OA_NONE, OA_NONE} },
       { "%store/qf/str", of_STORE_QF_STR,  1, {OA_FUNC_PTR, OA_NONE, OA_NONE} },
       { "%store/qf/v",   of_STORE_QF_V,    2, {OA_FUNC_PTR, OA_BIT1, OA_NONE} },
+      { "%store/qf/vec2",of_STORE_QF_VEC2, 2, {OA_FUNC_PTR, OA_BIT1, OA_NONE} },
       { "%store/real",    of_STORE_REAL,    1, {OA_FUNC_PTR,OA_NONE, OA_NONE} },
       { "%store/reala",   of_STORE_REALA,   2, {OA_ARR_PTR, OA_BIT1, OA_NONE} },
       { "%store/str",     of_STORE_STR,     1, {OA_FUNC_PTR,OA_NONE, OA_NONE} },
@@ -823,6 +829,12 @@ void compile_cleanup(void)
       }
 
       vpi_mode_flag = VPI_MODE_NONE;
+
+	/* All the code labels are resolved, so the instructions can
+	   now be fused and prepared for the threaded execution
+	   engine. */
+      count_opcodes_fused = codespace_fuse();
+      codespace_predecode();
 }
 
 void compile_vpi_symbol(const char*label, vpiHandle obj)
@@ -0,0 +1,462 @@
+/*
+ * Copyright (c) 2026 agent (agent@local)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+# include  "version_base.h"
+# include  "version_tag.h"
+# include  "config.h"
+# include  "image.h"
+# include  "parse_misc.h"
+# include  "compile.h"
+# include  "parse.h"
+# include  "vpi_user.h"
+# include  <cstdio>
+# include  <cstdlib>
+# include  <cstring>
+# include  <sys/types.h>
+# include  <sys/stat.h>
+# include  <fcntl.h>
+# include  <unistd.h>
+#if !defined(__MINGW32__)
+# include  <sys/mman.h>
+#endif
+# include  "ivl_alloc.h"
+
+#ifndef O_BINARY
+# define O_BINARY 0
+#endif
+
+/*
+ * The image file starts with this header. The rest of the file is the
+ * token stream, which is a sequence of records that each start with a
+ * variable length number. An even number is a token (shifted left by
+ * one) followed by the value of the token, if it has one. An odd
+ * number advances the line number for error messages. The stream ends
+ * with the end of file token, 0.
+ *
+ * The numbers are stored 7 bits per byte, low bits first, with the
+ * high bit set in all but the last byte. Text is stored as its length
+ * followed by the characters, without the trailing nul. The header is
+ * in the byte order of the machine, so images are not portable, but
+ * the byte_order field rejects images from a different machine.
+ *
+ * The design file is identified by its size, its modification time to
+ * the nanosecond and an FNV-1a hash of its contents. A build may well
+ * rewrite a .vvp file at the same size within a second, and only the
+ * hash catches that on file systems with coarse time stamps.
+ */
+static const char image_magic[8] = { 'v','v','p','i','m','a','g','e' };
+static const uint32_t IMAGE_VERSION = 2;
+
+struct image_header_s {
+      char magic[8];
+      uint32_t version;
+      uint32_t byte_order;
+      uint64_t design_size;
+      int64_t design_mtime;
+      uint64_t design_hash;
+      uint32_t design_mtime_nsec;
+      uint32_t pad;
+      uint64_t stream_size;
+	// Token numbers are assigned by bison in the order they are
+	// declared in parse.y. A few of them are kept here so that an
+	// image is rejected if the grammar of this vvp is different.
+      uint32_t tokens[8];
+      char vvp_version[64];
+};
+
+static const char*image_path = 0;
+
+void image_set_path(const char*path)
+{
+      image_path = path;
+}
+
+static uint32_t image_mtime_nsec(const struct stat&st)
+{
+#if defined(__APPLE__)
+      return st.st_mtimespec.tv_nsec;
+#elif defined(__MINGW32__)
+      (void)st;
+      return 0;
+#else
+      return st.st_mtim.tv_nsec;
+#endif
+}
+
+/*
+ * Hash the contents of the design file. This reads the whole file,
+ * but that is much cheaper than scanning it. Return false if the file
+ * cannot be read.
+ */
+static bool image_design_hash(const char*design_path, uint64_t&hash)
+{
+      int fd = open(design_path, O_RDONLY|O_BINARY);
+      if (fd < 0)
+	    return false;
+
+      static unsigned char buf[64*1024];
+      hash = 14695981039346656037ULL;
+      int rc;
+      while ((rc = read(fd, buf, sizeof buf)) > 0) {
+	    for (int idx = 0 ; idx < rc ; idx += 1) {
+		  hash ^= buf[idx];
+		  hash *= 1099511628211ULL;
+	    }
+      }
+      close(fd);
+      return rc == 0;
+}
+
+static void image_fill_header(struct image_header_s&hdr,
+			      const struct stat&design_st,
+			      uint64_t design_hash)
+{
+      memset(&hdr, 0, sizeof hdr);
+      memcpy(hdr.magic, image_magic, sizeof hdr.magic);
+      hdr.version = IMAGE_VERSION;
+      hdr.byte_order = 0x01020304;
+      hdr.design_size = design_st.st_size;
+      hdr.design_mtime = design_st.st_mtime;
+      hdr.design_hash = design_hash;
+      hdr.design_mtime_nsec = image_mtime_nsec(design_st);
+      hdr.tokens[0] = T_INSTR;
+      hdr.tokens[1] = T_LABEL;
+      hdr.tokens[2] = T_NUMBER;
+      hdr.tokens[3] = T_STRING;
+      hdr.tokens[4] = T_SYMBOL;
+      hdr.tokens[5] = T_VECTOR;
+      hdr.tokens[6] = K_ivl_version;
+      hdr.tokens[7] = K_vpi_func;
+      snprintf(hdr.vvp_version, sizeof hdr.vvp_version, "%s (%s)",
+	       VERSION, VERSION_TAG);
+}
+
+/*
+ * Reading the image. The whole file is mapped, and the parser pulls
+ * tokens out of it through yylex(). Text values are copied out of the
+ * map, because the parser takes ownership of them.
+ */
+static const unsigned char*image_map = 0;
+static size_t image_map_size = 0;
+static const unsigned char*image_ptr = 0;
+static const unsigned char*image_end = 0;
+
+static void image_unmap(void)
+{
+#if defined(__MINGW32__)
+      free((void*)image_map);
+#else
+      munmap((void*)image_map, image_map_size);
+#endif
+      image_map = 0;
+      image_map_size = 0;
+}
+
+bool image_load(const char*design_path)
+{
+      if (image_path == 0)
+	    return false;
+
+      struct stat design_st, image_st;
+      if (stat(design_path, &design_st) != 0)
+	    return false;
+
+      int fd = open(image_path, O_RDONLY|O_BINARY);
+      if (fd < 0)
+	    return false;
+
+      if (fstat(fd, &image_st) != 0
+	  || (size_t)image_st.st_size < sizeof(struct image_header_s)) {
+	    close(fd);
+	    return false;
+      }
+
+      image_map_size = image_st.st_size;
+#if defined(__MINGW32__)
+      unsigned char*buf = (unsigned char*)malloc(image_map_size);
+      size_t got = 0;
+      while (got < image_map_size) {
+	    int rc = read(fd, buf+got, image_map_size-got);
+	    if (rc <= 0) break;
+	    got += rc;
+      }
+      image_map = buf;
+      if (got != image_map_size) {
+	    image_unmap();
+	    close(fd);
+	    return false;
+      }
+#else
+      void*map = mmap(0, image_map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (map == MAP_FAILED) {
+	    image_map_size = 0;
+	    close(fd);
+	    return false;
+      }
+      image_map = (const unsigned char*)map;
+#endif
+      close(fd);
+
+      uint64_t design_hash = 0;
+      struct image_header_s want, have;
+      memcpy(&have, image_map, sizeof have);
+      bool ok = have.design_size == (uint64_t)design_st.st_size
+	    && image_design_hash(design_path, design_hash);
+      image_fill_header(want, design_st, design_hash);
+      want.stream_size = image_map_size - sizeof have;
+      if (!ok || memcmp(&want, &have, sizeof want) != 0) {
+	    if (verbose_flag)
+		  vpi_mcd_printf(1, " ... Compiled image %s is out of date\n",
+				 image_path);
+	    image_unmap();
+	    return false;
+      }
+
+      image_ptr = image_map + sizeof have;
+      image_end = image_map + image_map_size;
+      if (verbose_flag)
+	    vpi_mcd_printf(1, " ... Loading compiled image %s\n", image_path);
+      return true;
+}
+
+void image_load_end(void)
+{
+      image_unmap();
+      image_ptr = 0;
+      image_end = 0;
+}
+
+static uint64_t image_get_number(void)
+{
+      uint64_t val = 0;
+      unsigned shift = 0;
+      while (image_ptr < image_end) {
+	    unsigned char byte = *image_ptr++;
+	    val |= (uint64_t)(byte & 0x7f) << shift;
+	    if ((byte & 0x80) == 0)
+		  return val;
+	    shift += 7;
+      }
+      return 0;
+}
+
+static char* image_get_text(bool use_new)
+{
+      size_t len = image_get_number();
+      if (len > (size_t)(image_end - image_ptr))
+	    len = image_end - image_ptr;
+
+      char*text = use_new? new char[len+1] : (char*)malloc(len+1);
+      memcpy(text, image_ptr, len);
+      text[len] = 0;
+      image_ptr += len;
+      return text;
+}
+
+static int image_get_token(void)
+{
+      for (;;) {
+	    if (image_ptr >= image_end)
+		  return 0;
+
+	    uint64_t code = image_get_number();
+	    if (code & 1) {
+		  yyline += code >> 1;
+		  continue;
+	    }
+
+	    int tok = code >> 1;
+	    switch (tok) {
+		case T_INSTR:
+		case T_LABEL:
+		case T_SYMBOL:
+		  yylval.text = image_get_text(false);
+		  break;
+		case T_STRING:
+		  yylval.text = image_get_text(true);
+		  break;
+		case T_NUMBER:
+		  yylval.numb = image_get_number();
+		  break;
+		case T_VECTOR:
+		  yylval.vect.idx = image_get_number();
+		  yylval.vect.text = image_get_text(false);
+		  break;
+		default:
+		  break;
+	    }
+	    return tok;
+      }
+}
+
+/*
+ * Writing the image. The tokens are written to a temporary file next
+ * to the image, which is renamed over the image when the design has
+ * been parsed, so that an interrupted run never leaves a broken image.
+ */
+static FILE*image_out = 0;
+static char*image_tmp_path = 0;
+static struct stat image_design_st;
+static uint64_t image_design_sum = 0;
+static unsigned image_line = 0;
+static uint64_t image_out_size = 0;
+
+static unsigned char image_buf[64*1024];
+static size_t image_buf_fill = 0;
+
+static void image_flush(void)
+{
+      fwrite(image_buf, 1, image_buf_fill, image_out);
+      image_out_size += image_buf_fill;
+      image_buf_fill = 0;
+}
+
+static inline void image_put_byte(unsigned char byte)
+{
+      if (image_buf_fill == sizeof image_buf)
+	    image_flush();
+      image_buf[image_buf_fill++] = byte;
+}
+
+static void image_put_number(uint64_t val)
+{
+      while (val >= 0x80) {
+	    image_put_byte((val & 0x7f) | 0x80);
+	    val >>= 7;
+      }
+      image_put_byte(val);
+}
+
+static void image_put_text(const char*text)
+{
+      size_t len = strlen(text);
+      image_put_number(len);
+      for (size_t idx = 0 ; idx < len ; idx += 1)
+	    image_put_byte(text[idx]);
+}
+
+static void image_put_token(int tok)
+{
+      if (yyline != image_line) {
+	    image_put_number(((uint64_t)(yyline - image_line) << 1) | 1);
+	    image_line = yyline;
+      }
+
+      image_put_number((uint64_t)tok << 1);
+      switch (tok) {
+	  case T_INSTR:
+	  case T_LABEL:
+	  case T_SYMBOL:
+	  case T_STRING:
+	    image_put_text(yylval.text);
+	    break;
+	  case T_NUMBER:
+	    image_put_number(yylval.numb);
+	    break;
+	  case T_VECTOR:
+	    image_put_number(yylval.vect.idx);
+	    image_put_text(yylval.vect.text);
+	    break;
+	  default:
+	    break;
+      }
+}
+
+void image_save_begin(const char*design_path)
+{
+      if (image_path == 0)
+	    return;
+      if (stat(design_path, &image_design_st) != 0)
+	    return;
+      if (!image_design_hash(design_path, image_design_sum))
+	    return;
+
+      size_t len = strlen(image_path) + 32;
+      image_tmp_path = (char*)malloc(len);
+      snprintf(image_tmp_path, len, "%s.%d", image_path, (int)getpid());
+      image_out = fopen(image_tmp_path, "wb");
+      if (image_out == 0) {
+	    fprintf(stderr, "%s: Unable to write compiled image.\n",
+		    image_tmp_path);
+	    free(image_tmp_path);
+	    image_tmp_path = 0;
+	    return;
+      }
+
+	// The real header is written when the stream is complete.
+      struct image_header_s hdr;
+      memset(&hdr, 0, sizeof hdr);
+      fwrite(&hdr, sizeof hdr, 1, image_out);
+      image_line = yyline;
+      image_out_size = 0;
+}
+
+void image_save_end(bool ok)
+{
+      if (image_out == 0)
+	    return;
+
+      image_flush();
+      if (ok) {
+	    struct image_header_s hdr;
+	    image_fill_header(hdr, image_design_st, image_design_sum);
+	    hdr.stream_size = image_out_size;
+	    fseek(image_out, 0, SEEK_SET);
+	    fwrite(&hdr, sizeof hdr, 1, image_out);
+      }
+
+      if (ferror(image_out))
+	    ok = false;
+      if (fclose(image_out) != 0)
+	    ok = false;
+      image_out = 0;
+
+      if (ok) {
+#if defined(__MINGW32__)
+	    remove(image_path);
+#endif
+	    ok = rename(image_tmp_path, image_path) == 0;
+      }
+
+      if (ok) {
+	    if (verbose_flag)
+		  vpi_mcd_printf(1, " ... Saved compiled image %s\n",
+				 image_path);
+      } else {
+	    remove(image_tmp_path);
+      }
+
+      free(image_tmp_path);
+      image_tmp_path = 0;
+}
+
+/*
+ * The parser calls this to get its tokens, from the image if one is
+ * loaded, or else from the text lexor.
+ */
+int yylex(void)
+{
+      if (image_map)
+	    return image_get_token();
+
+      int tok = yylex_text();
+      if (image_out)
+	    image_put_token(tok);
+      return tok;
+}
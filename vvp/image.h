@@ -0,0 +1,50 @@
+#ifndef IVL_image_H
+#define IVL_image_H
+/*
+ * Copyright (c) 2026 agent (agent@local)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * A compiled image holds the token stream of a design file in a
+ * binary form, so that later runs can feed the parser straight from
+ * the mapped image instead of scanning the text. The vvp -c flag
+ * names the image file with image_set_path().
+ *
+ * compile_design() first tries image_load(). This maps the image and
+ * checks that it was made by this build of vvp from the same design
+ * file (size, modification time and a hash of the contents). If the
+ * check fails, the design file is scanned as usual, and
+ * image_save_begin() and image_save_end() record the tokens into a new
+ * image. The image is only written if the design compiled without
+ * errors.
+ *
+ * The image only replaces the lexor. The parser, the symbol tables and
+ * the linking in compile_cleanup() still run on every load. An image
+ * of the linked state, loaded with pointer relocation, would need a
+ * serializer for every functor, VPI object and thread code class, and
+ * is not done.
+ */
+extern void image_set_path(const char*path);
+
+extern bool image_load(const char*design_path);
+extern void image_load_end(void);
+
+extern void image_save_begin(const char*design_path);
+extern void image_save_end(bool ok);
+
+#endif /* IVL_image_H */
@@ -21,7 +21,8 @@
 # include  "compile.h"
 # include  "symbols.h"
 # include  "schedule.h"
-# include  <list>
+# include  <vector>
+# include  <algorithm>
 
 # include  <iostream>
 
@@ -33,6 +34,14 @@ class vvp_island_tran : public vvp_island {
       void run_island();
       void count_drivers(vvp_island_port*port, unsigned bit_idx,
                          unsigned counts[3]);
+
+    private:
+      void collect_ports_(vector<vvp_island_port*>&ports,
+			  vvp_island_port*port);
+
+	// Keep the vector that run_island() uses to collect ports
+	// so that its storage is reused from run to run.
+      vector<vvp_island_port*> run_ports_;
 };
 
 enum tran_state_t {
@@ -47,10 +56,10 @@ struct vvp_island_branch_tran : public vvp_island_branch {
                              unsigned width__, unsigned part__,
                              unsigned offset__, bool resistive__);
       bool run_test_enabled();
-      void run_resolution();
-      void run_output();
 
       vvp_net_t*en;
+	// The next branch that is enabled by the same port.
+      vvp_island_branch*next_enable;
       unsigned width, part, offset;
       bool active_high, resistive;
       tran_state_t state;
@@ -62,49 +71,143 @@ vvp_island_branch_tran::vvp_island_branch_tran(vvp_net_t*en__,
                                                unsigned part__,
                                                unsigned offset__,
                                                bool resistive__)
-: en(en__), width(width__), part(part__), offset(offset__),
+: en(en__), next_enable(0), width(width__), part(part__), offset(offset__),
   active_high(active_high__), resistive(resistive__)
 {
       state = en__ ? tran_disabled : tran_enabled;
 }
 
+/*
+ * A tran island only ever contains tran branches, so there is no need
+ * to pay for a dynamic_cast.
+ */
 static inline vvp_island_branch_tran* BRANCH_TRAN(vvp_island_branch*tmp)
 {
-      vvp_island_branch_tran*res = dynamic_cast<vvp_island_branch_tran*>(tmp);
-      assert(res);
-      return res;
+      return static_cast<vvp_island_branch_tran*>(tmp);
+}
+
+static inline vvp_net_t* node_net(vvp_branch_ptr_t cur)
+{
+      return cur.port() ? cur.ptr()->b : cur.ptr()->a;
+}
+
+static inline vvp_island_port* node_port(vvp_branch_ptr_t cur)
+{
+      return static_cast<vvp_island_port*>(node_net(cur)->fun);
+}
+
+static bool compare_port_order(const vvp_island_port*a,
+			       const vvp_island_port*b)
+{
+      return a->order < b->order;
+}
+
+static void push_value_through_node(const vvp_vector8_t&val,
+				    vvp_branch_ptr_t node);
+
+/*
+ * Add to the ports list the port and all the ports that are connected
+ * to it through branches that are not disabled. The mark flag keeps
+ * ports from being collected twice, so a port that is already marked
+ * has already had its connected ports collected.
+ */
+void vvp_island_tran::collect_ports_(vector<vvp_island_port*>&ports,
+				     vvp_island_port*port)
+{
+      if (port->mark || port->node.nil())
+	    return;
+
+      size_t scan = ports.size();
+      port->mark = true;
+      ports.push_back(port);
+
+      while (scan < ports.size()) {
+	    vvp_branch_ptr_t node = ports[scan++]->node;
+	    vvp_branch_ptr_t idx = node;
+	    do {
+		  vvp_island_branch_tran*branch = BRANCH_TRAN(idx.ptr());
+		  if (branch->state != tran_disabled) {
+			vvp_branch_ptr_t other (branch, idx.port()^1);
+			vvp_island_port*dst = node_port(other);
+			if (! dst->mark) {
+			      dst->mark = true;
+			      ports.push_back(dst);
+			}
+		  }
+	    } while ((idx = next(idx)) != node);
+      }
 }
 
 /*
  * The run_island() method is called by the scheduler to run the
- * entire island. We run the island by calling run_resolution() for
- * all the branches in the island.
-*/
+ * island. Only the parts of the island that are connected to a port
+ * that changed, or to a branch whose enable changed, are resolved
+ * again. Everything else keeps the value it already sent out.
+ *
+ * The collected ports are resolved and output in the order that a
+ * scan of the branch list first reaches them, which is the order that
+ * a full run of the island would visit them in.
+ */
 void vvp_island_tran::run_island()
 {
-	// Test to see if any of the branches are enabled. This loop
-	// tests the enabled inputs for all the branches and caches
-	// the results in the state for each branch.
-      bool runnable = false;
-      for (vvp_island_branch*cur = branches_ ; cur ; cur = cur->next_branch) {
-	    vvp_island_branch_tran*tmp = dynamic_cast<vvp_island_branch_tran*>(cur);
-	    assert(tmp);
-	    runnable |= tmp->run_test_enabled();
+      vvp_island_port*changed = changed_;
+      changed_ = 0;
+
+      vector<vvp_island_port*> ports;
+      ports.swap(run_ports_);
+
+      while (changed) {
+	    vvp_island_port*port = changed;
+	    changed = port->next_changed;
+	    port->next_changed = 0;
+	    port->changed = false;
+
+	    collect_ports_(ports, port);
+
+	      // Retest the branches that this port enables. If the
+	      // state of a branch changes, then the parts of the
+	      // island on either side of it need to be run again.
+	    for (vvp_island_branch*cur = port->enables ; cur
+		       ; cur = BRANCH_TRAN(cur)->next_enable) {
+		  vvp_island_branch_tran*tmp = BRANCH_TRAN(cur);
+		  tran_state_t old_state = tmp->state;
+		  tmp->run_test_enabled();
+		  if (tmp->state == old_state)
+			continue;
+
+		  collect_ports_(ports, static_cast<vvp_island_port*>(tmp->a->fun));
+		  collect_ports_(ports, static_cast<vvp_island_port*>(tmp->b->fun));
+	    }
       }
 
-	// Now resolve all the branches in the island.
-      for (vvp_island_branch*cur = branches_ ; cur ; cur = cur->next_branch) {
-	    vvp_island_branch_tran*tmp = dynamic_cast<vvp_island_branch_tran*>(cur);
-	    assert(tmp);
-	    tmp->run_resolution();
+      sort(ports.begin(), ports.end(), compare_port_order);
+
+	// Resolve the collected ports. Pushing the value of a port
+	// through its branches visits all the ports connected to
+	// it, so most ports will already have a value by the time
+	// the loop gets to them.
+      for (size_t idx = 0 ; idx < ports.size() ; idx += 1) {
+	    vvp_island_port*port = ports[idx];
+	    port->mark = false;
+	    if (port->value.size() != 0)
+		  continue;
+
+	    port->value = island_get_value(node_net(port->node));
+	    if (port->value.size() != 0)
+		  push_value_through_node(port->value, port->node);
       }
 
 	// Now output the resolved values.
-      for (vvp_island_branch*cur = branches_ ; cur ; cur = cur->next_branch) {
-	    vvp_island_branch_tran*tmp = dynamic_cast<vvp_island_branch_tran*>(cur);
-	    assert(tmp);
-	    tmp->run_output();
+      for (size_t idx = 0 ; idx < ports.size() ; idx += 1) {
+	    vvp_island_port*port = ports[idx];
+	    if (port->value.size() != 0) {
+		  island_send_value(node_net(port->node), port->value);
+		  port->value = vvp_vector8_t::nil;
+	    }
       }
+
+      ports.clear();
+      ports.swap(run_ports_);
 }
 
 static void count_drivers_(vvp_branch_ptr_t cur, bool other_side_visited,
@@ -162,31 +265,17 @@ static void count_drivers_(vvp_branch_ptr_t cur, bool other_side_visited,
 void vvp_island_tran::count_drivers(vvp_island_port*port, unsigned bit_idx,
                                     unsigned counts[3])
 {
-        // First we need to find a branch that is attached to the specified
-        // port. Unfortunately there's no quick way to do this.
-      vvp_island_branch*branch = branches_;
-      unsigned side = 0;
-      while (branch) {
-            if (branch->a->fun == port) {
-                  side = 0;
-                  break;
-            }
-            if (branch->b->fun == port) {
-                  side = 1;
-                  break;
-            }
-            branch = branch->next_branch;
-      }
-      assert(branch);
+        // Start from the branch endpoint that is attached to the
+        // specified port.
+      assert(! port->node.nil());
 
         // Now count the drivers, pushing through the network as necessary.
-      vvp_branch_ptr_t endpoint(branch, side);
-      count_drivers_(endpoint, false, bit_idx, counts);
+      count_drivers_(port->node, false, bit_idx, counts);
 }
 
 bool vvp_island_branch_tran::run_test_enabled()
 {
-      vvp_island_port*ep = en? dynamic_cast<vvp_island_port*> (en->fun) : 0;
+      vvp_island_port*ep = en? static_cast<vvp_island_port*> (en->fun) : 0;
 
 	// If there is no ep port (no "enabled" input) then this is a
 	// tran branch. Assume it is always enabled.
@@ -265,9 +354,6 @@ inline vvp_vector8_t resolve_ambiguous(const vvp_vector8_t&a,
       return out;
 }
 
-static void push_value_through_branches(const vvp_vector8_t&val,
-					list<vvp_branch_ptr_t>&connections);
-
 static void push_value_through_branch(const vvp_vector8_t&val,
                                       vvp_branch_ptr_t cur)
 {
@@ -281,7 +367,7 @@ static void push_value_through_branch(const vvp_vector8_t&val,
       unsigned dst_ab = src_ab^1;
 
       vvp_net_t*dst_net = dst_ab? branch->b : branch->a;
-      vvp_island_port*dst_port = dynamic_cast<vvp_island_port*>(dst_net->fun);
+      vvp_island_port*dst_port = static_cast<vvp_island_port*>(dst_net->fun);
 
       vvp_vector8_t old_val = dst_port->value;
 
@@ -316,83 +402,23 @@ static void push_value_through_branch(const vvp_vector8_t&val,
         // If the resolved value for the port has changed, push the new
         // value back into the network.
       if (! dst_port->value.eeq(old_val)) {
-            list<vvp_branch_ptr_t> connections;
-
 	    vvp_branch_ptr_t dst_side(branch, dst_ab);
-	    island_collect_node(connections, dst_side);
-
-	    push_value_through_branches(dst_port->value, connections);
-      }
-}
-
-static void push_value_through_branches(const vvp_vector8_t&val,
-					list<vvp_branch_ptr_t>&connections)
-{
-      for (list<vvp_branch_ptr_t>::iterator idx = connections.begin()
-		 ; idx != connections.end() ; ++ idx ) {
-
-            push_value_through_branch(val, *idx);
+	    push_value_through_node(dst_port->value, dst_side);
       }
 }
 
 /*
- * This method resolves the value for a branch recursively. It uses
- * recursive descent to span the graph of branches, pushing values
- * through the network until a stable state is reached.
+ * Push the value through all the branches that are attached to the
+ * node. This uses recursive descent to span the graph of branches,
+ * pushing values through the network until a stable state is reached.
  */
-void vvp_island_branch_tran::run_resolution()
+static void push_value_through_node(const vvp_vector8_t&val,
+				    vvp_branch_ptr_t node)
 {
-      list<vvp_branch_ptr_t> connections;
-      vvp_island_port*port;
-
-	// If the A side port hasn't already been visited, then push
-        // its input value through all the branches connected to it.
-      port = dynamic_cast<vvp_island_port*>(a->fun);
-      if (port->value.size() == 0) {
-	    vvp_branch_ptr_t a_side(this, 0);
-	    island_collect_node(connections, a_side);
-
-	    port->value = island_get_value(a);
-            if (port->value.size() != 0)
-	          push_value_through_branches(port->value, connections);
-
-            connections.clear();
-      }
-
-	// Do the same for the B side port. Note that if the branch
-        // is enabled, the B side port will have already been visited
-        // when we resolved the A side port.
-      port = dynamic_cast<vvp_island_port*>(b->fun);
-      if (port->value.size() == 0) {
-	    vvp_branch_ptr_t b_side(this, 1);
-	    island_collect_node(connections, b_side);
-
-	    port->value = island_get_value(b);
-	    if (port->value.size() != 0)
-	          push_value_through_branches(port->value, connections);
-
-            connections.clear();
-      }
-}
-
-void vvp_island_branch_tran::run_output()
-{
-      vvp_island_port*port;
-
-	// If the A side port hasn't already been updated, send the
-        // resolved value to the output.
-      port = dynamic_cast<vvp_island_port*>(a->fun);
-      if (port->value.size() != 0) {
-	    island_send_value(a, port->value);
-	    port->value = vvp_vector8_t::nil;
-      }
-
-	// Do the same for the B side port.
-      port = dynamic_cast<vvp_island_port*>(b->fun);
-      if (port->value.size() != 0) {
-	    island_send_value(b, port->value);
-	    port->value = vvp_vector8_t::nil;
-      }
+      vvp_branch_ptr_t idx = node;
+      do {
+	    push_value_through_branch(val, idx);
+      } while ((idx = next(idx)) != node);
 }
 
 void compile_island_tran(char*label)
@@ -423,6 +449,14 @@ void compile_island_tranif(int sense, char*island, char*pa, char*pb, char*pe,
 
       use_island->add_branch(br, pa, pb);
 
+	// Let the enable port know about the branch so that the
+	// island can retest it when the port changes.
+      if (en) {
+	    vvp_island_port*port = static_cast<vvp_island_port*>(en->fun);
+	    br->next_enable = port->enables;
+	    port->enables = br;
+      }
+
       free(pa);
       free(pb);
 }
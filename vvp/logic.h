@@ -37,6 +37,10 @@ class vvp_fun_boolean_ : public vvp_net_fun_t, protected vvp_gen_event_s {
       void recv_vec4_pv(vvp_net_ptr_t p, const vvp_vector4_t&bit,
 			unsigned base, unsigned wid, unsigned vwid,
                         vvp_context_t);
+      bool parallel_safe() const { return true; }
+
+    protected:
+      vvp_net_t* parallel_net() { return net_; }
 
     protected:
       vvp_vector4_t input_[4];
@@ -71,9 +75,11 @@ class vvp_fun_buf: public vvp_net_fun_t, private vvp_gen_event_s {
       void recv_vec4_pv(vvp_net_ptr_t p, const vvp_vector4_t&bit,
 			unsigned base, unsigned wid, unsigned vwid,
                         vvp_context_t);
+      bool parallel_safe() const { return true; }
 
     private:
       void run_run();
+      vvp_net_t* parallel_net() { return net_; }
 
     private:
       vvp_vector4_t input_;
@@ -98,6 +104,7 @@ class vvp_fun_bufz: public vvp_net_fun_t {
 	//void recv_vec8(vvp_net_ptr_t port, const vvp_vector8_t&bit);
       void recv_real(vvp_net_ptr_t p, double bit,
                      vvp_context_t);
+      bool parallel_safe() const { return true; }
 
     private:
 };
@@ -137,9 +144,11 @@ class vvp_fun_muxz : public vvp_net_fun_t, private vvp_gen_event_s {
       void recv_vec4_pv(vvp_net_ptr_t p, const vvp_vector4_t&bit,
 			unsigned base, unsigned wid, unsigned vwid,
                         vvp_context_t);
+      bool parallel_safe() const { return true; }
 
     private:
       void run_run();
+      vvp_net_t* parallel_net() { return net_; }
 
     private:
       vvp_vector4_t a_;
@@ -159,9 +168,11 @@ class vvp_fun_muxr : public vvp_net_fun_t, private vvp_gen_event_s {
                      vvp_context_t);
       void recv_real(vvp_net_ptr_t p, double bit,
                      vvp_context_t);
+      bool parallel_safe() const { return true; }
 
     private:
       void run_run();
+      vvp_net_t* parallel_net() { return net_; }
 
     private:
       double a_;
@@ -181,9 +192,11 @@ class vvp_fun_not: public vvp_net_fun_t, private vvp_gen_event_s {
       void recv_vec4_pv(vvp_net_ptr_t p, const vvp_vector4_t&bit,
 			unsigned base, unsigned wid, unsigned vwid,
                         vvp_context_t);
+      bool parallel_safe() const { return true; }
 
     private:
       void run_run();
+      vvp_net_t* parallel_net() { return net_; }
 
     private:
       vvp_vector4_t input_;
@@ -24,9 +24,13 @@
 # include  "compile.h"
 # include  "schedule.h"
 # include  "vpi_priv.h"
+# include  "array_common.h"
 # include  "statistics.h"
 # include  "vvp_cleanup.h"
 # include  "vvp_object.h"
+# include  "class_type.h"
+# include  "profile.h"
+# include  "image.h"
 # include  <cstdio>
 # include  <cstdlib>
 # include  <cstring>
@@ -278,26 +282,59 @@ int main(int argc, char*argv[])
         /* For non-interactive runs we do not want to run the interactive
          * debugger, so make $stop just execute a $finish. */
       stop_is_finish = false;
-      while ((opt = getopt(argc, argv, "+hil:M:m:nNsvV")) != EOF) switch (opt) {
+      while ((opt = getopt(argc, argv, "+c:e:hij:L:l:M:m:nNq:svV")) != EOF) switch (opt) {
          case 'h':
            fprintf(stderr,
                    "Usage: vvp [options] input-file [+plusargs...]\n"
                    "Options:\n"
+                   " -c file        Compiled image of the input file, made if missing.\n"
+                   " -e engine      Execution engine: call (default) or threaded.\n"
                    " -h             Print this help message.\n"
-                   " -i             Interactive mode (unbuffered stdio).\n"
+                   " -i             Interactive mode (unbuffered stdio).\n");
+#ifdef USE_NETLIST_THREADS
+           fprintf(stderr,
+                   " -j threads     Threads that evaluate the netlist (default 1).\n");
+#endif
+           fprintf(stderr,
+                   " -L layout      Net memory layout: split (default) or compact.\n"
                    " -l file        Logfile, '-' for <stderr>\n"
                    " -M path        VPI module directory\n"
 		   " -M -           Clear VPI module path\n"
                    " -m module      Load vpi module.\n"
 		   " -n             Non-interactive ($stop = $finish).\n"
                    " -N             Same as -n, but exit code is 1 instead of 0\n"
+                   " -q queue       Event queue type: list (default) or wheel.\n"
 		   " -s             $stop right away.\n"
                    " -v             Verbose progress messages.\n"
                    " -V             Print the version information.\n" );
            exit(0);
+	  case 'c':
+	    image_set_path(optarg);
+	    break;
+	  case 'e':
+	    if (! vthread_set_engine(optarg)) {
+		  fprintf(stderr, "%s: Unknown or unsupported execution "
+			  "engine \"%s\"\n", argv[0], optarg);
+		  flag_errors += 1;
+	    }
+	    break;
 	  case 'i':
 	    setvbuf(stdout, 0, _IONBF, 0);
 	    break;
+	  case 'j':
+	    if (! schedule_set_workers(optarg)) {
+		  fprintf(stderr, "%s: Invalid or unsupported number of "
+			  "threads \"%s\"\n", argv[0], optarg);
+		  flag_errors += 1;
+	    }
+	    break;
+	  case 'L':
+	    if (! vvp_net_set_layout(optarg)) {
+		  fprintf(stderr, "%s: Unknown or unsupported net layout "
+			  "\"%s\"\n", argv[0], optarg);
+		  flag_errors += 1;
+	    }
+	    break;
 	  case 'l':
 	    logfile_name = optarg;
 	    break;
@@ -318,6 +355,13 @@ int main(int argc, char*argv[])
             stop_is_finish = true;
             stop_is_finish_exit_code = 1;
             break;
+	  case 'q':
+	    if (! schedule_set_queue(optarg)) {
+		  fprintf(stderr, "%s: Unknown event queue type \"%s\"\n",
+			  argv[0], optarg);
+		  flag_errors += 1;
+	    }
+	    break;
 	  case 's':
 	    schedule_stop(0);
 	    break;
@@ -372,6 +416,14 @@ int main(int argc, char*argv[])
 
       design_path = argv[optind];
 
+	/* The +vvp-profile=<file> extended argument turns on the
+	   sampling profiler. */
+      const char*profile_path = 0;
+      for (int idx = optind+1 ;  idx < argc ;  idx += 1) {
+	    if (strncmp(argv[idx], "+vvp-profile=", 13) == 0)
+		  profile_path = argv[idx]+13;
+      }
+
 	/* This is needed to get the MCD I/O routines ready for
 	   anything. It is done early because it is plausible that the
 	   compile might affect it, and it is cheap to do. */
@@ -430,6 +482,11 @@ int main(int argc, char*argv[])
 	    return compile_errors;
       }
 
+	/* The -j mode evaluates independent regions of the netlist
+	   on worker threads, so it needs the partition. */
+      if (verbose_flag || schedule_workers() > 1)
+	    vvp_net_partition();
+
       if (verbose_flag) {
 	    vpi_mcd_printf(1, " ... %8lu functors (net_fun pool=%zu bytes)\n",
 			   count_functors, vvp_net_fun_t::heap_total());
@@ -441,15 +498,28 @@ int main(int argc, char*argv[])
 			   count_filters, vvp_net_fil_t::heap_total());
 	    vpi_mcd_printf(1, " ... %8lu opcodes (%zu bytes)\n",
 	                   count_opcodes, size_opcodes);
+	    vpi_mcd_printf(1, "           %8lu fused sequences\n",
+	                   count_opcodes_fused);
 	    vpi_mcd_printf(1, " ... %8lu nets\n",     count_vpi_nets);
 	    vpi_mcd_printf(1, " ... %8lu vvp_nets (%zu bytes)\n",
 			   count_vvp_nets, size_vvp_nets);
+	    if (vvp_net_compact_heap)
+		  vpi_mcd_printf(1, "           (compact net pool=%zu bytes)\n",
+				 vvp_net_compact_heap->heap_total());
+	    vpi_mcd_printf(1, "           %8lu regions (largest %lu vvp_nets)\n",
+			   count_net_regions, count_net_region_max);
+	    if (schedule_workers() > 1)
+		  vpi_mcd_printf(1, "           %8lu parallel regions\n",
+				 count_net_regions_parallel);
 	    vpi_mcd_printf(1, " ... %8lu arrays (%lu words)\n",
 			   count_net_arrays, count_net_array_words);
 	    vpi_mcd_printf(1, " ... %8lu memories\n",
 			   count_var_arrays+count_real_arrays);
 	    vpi_mcd_printf(1, "           %8lu logic (%lu words)\n",
 			   count_var_arrays, count_var_array_words);
+	    if (count_sparse_arrays > 0)
+		  vpi_mcd_printf(1, "           (%lu sparse)\n",
+				 count_sparse_arrays);
 	    vpi_mcd_printf(1, "           %8lu real (%lu words)\n",
 			   count_real_arrays, count_real_array_words);
 	    vpi_mcd_printf(1, " ... %8lu scopes\n",   count_vpi_scopes);
@@ -462,8 +532,14 @@ int main(int argc, char*argv[])
       }
 
 
+      if (profile_path && ! profile_start(profile_path))
+	    profile_path = 0;
+
       schedule_simulate();
 
+      if (profile_path)
+	    profile_stop();
+
       if (verbose_flag) {
 	    my_getrusage(cycles+2);
 	    print_rusage(cycles+2, cycles+1);
@@ -471,6 +547,9 @@ int main(int argc, char*argv[])
 	    vpi_mcd_printf(1, "Event counts:\n");
 	    vpi_mcd_printf(1, "    %8lu time steps (pool=%lu)\n",
 			   count_time_events, count_time_pool());
+	    if (schedule_queue_is_wheel())
+		  vpi_mcd_printf(1, "             ...wheel overflow=%lu\n",
+				 count_time_overflow);
 	    vpi_mcd_printf(1, "    %8lu thread schedule events\n",
 		    count_thread_events);
 	    vpi_mcd_printf(1, "    %8lu assign events\n",
@@ -487,6 +566,28 @@ int main(int argc, char*argv[])
 			   count_assign_arword_pool());
 	    vpi_mcd_printf(1, "    %8lu other events (pool=%lu)\n",
 			   count_gen_events, count_gen_pool());
+	    if (schedule_workers() > 1)
+		  vpi_mcd_printf(1, "    %8lu netlist events in %lu parallel "
+				 "batches\n", count_parallel_events,
+				 count_parallel_batches);
+	    vpi_mcd_printf(1, "    %8lu vec4 stack pushes without allocation\n",
+			   count_vec4_stack_reuse);
+	    vpi_mcd_printf(1, "    %8lu threads created (%lu reused)\n",
+			   count_thread_alloc+count_thread_reuse,
+			   count_thread_reuse);
+	    unsigned long var_words = count_var_array_words
+		  + count_real_array_words;
+	    if (var_words > count_array_word_handles)
+		  vpi_mcd_printf(1, "    %8lu array word handles of %lu words "
+				 "(%zu bytes saved)\n",
+				 count_array_word_handles, var_words,
+				 (var_words-count_array_word_handles)
+				 * sizeof(struct __vpiArrayWord));
+	    if (count_sparse_arrays > 0)
+		  vpi_mcd_printf(1, "    %8lu sparse memory pages (%u words each)\n",
+				 count_sparse_array_pages,
+				 (unsigned)vvp_vector4array_sparse::PAGE_WORDS);
+	    print_class_statistics();
       }
 
       final_cleanup();
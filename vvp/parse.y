@@ -22,6 +22,7 @@
 # include  "parse_misc.h"
 # include  "compile.h"
 # include  "delay.h"
+# include  "image.h"
 # include  <list>
 # include  <cstdio>
 # include  <cstdlib>
@@ -1249,13 +1250,22 @@ int compile_design(const char*path)
 {
       yypath = path;
       yyline = 1;
+
+      if (image_load(path)) {
+	    int rc = yyparse();
+	    image_load_end();
+	    return rc;
+      }
+
       yyin = fopen(path, "r");
       if (yyin == 0) {
 	    fprintf(stderr, "%s: Unable to open input file.\n", path);
 	    return -1;
       }
 
+      image_save_begin(path);
       int rc = yyparse();
       fclose(yyin);
+      image_save_end(rc == 0);
       return rc;
 }
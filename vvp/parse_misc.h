@@ -39,9 +39,12 @@ extern void verify_version(char *ivl_ver, char* commit);
 extern void set_delay_selection(const char* sel);
 
 /*
- * various functions shared by the lexor and the parser.
+ * various functions shared by the lexor and the parser. The parser
+ * calls yylex(), which takes the tokens from a compiled image (see
+ * image.h) or from the text lexor, yylex_text().
  */
 extern int yylex(void);
+extern int yylex_text(void);
 extern void yyerror(const char*msg);
 
 extern void destroy_lexor();
@@ -55,9 +55,11 @@ class vvp_fun_part_sa  : public vvp_fun_part, public vvp_gen_event_s {
       void recv_vec4_pv(vvp_net_ptr_t port, const vvp_vector4_t&bit,
 			unsigned, unsigned, unsigned,
                         vvp_context_t);
+      bool parallel_safe() const { return true; }
 
     private:
       void run_run();
+      vvp_net_t* parallel_net() { return net_; }
 
     private:
       vvp_vector4_t val_;
@@ -114,6 +116,7 @@ class vvp_fun_part_pv  : public vvp_net_fun_t {
                         vvp_context_t);
 
       void recv_vec8(vvp_net_ptr_t port, const vvp_vector8_t&bit);
+      bool parallel_safe() const { return true; }
 
     private:
       unsigned base_;
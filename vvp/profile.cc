@@ -0,0 +1,327 @@
+/*
+ * Copyright (c) 2026 agent (agent@local)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+# include  "config.h"
+# include  "profile.h"
+# include  "codes.h"
+# include  "compile.h"
+# include  "vthread.h"
+# include  "vpi_priv.h"
+# include  <cstdio>
+# include  <cstdlib>
+# include  <cstring>
+# include  <string>
+# include  <vector>
+# include  <map>
+# include  <set>
+# include  <algorithm>
+#if !defined(__MINGW32__)
+# include  <csignal>
+# include  <sys/time.h>
+#endif
+
+using namespace std;
+
+#if !defined(__MINGW32__)
+
+/*
+ * The signal handler records samples into a fixed buffer. When the
+ * buffer fills, every other sample is discarded and from then on only
+ * every other timer tick is recorded, so all the samples in the
+ * buffer keep the same weight. The handler does no allocation.
+ */
+static const unsigned PROFILE_INTERVAL_USEC = 1000;
+static const size_t PROFILE_MAX_SAMPLES = 256*1024;
+
+struct profile_sample_s {
+      __vpiScope*scope;
+      vvp_code_t pc;
+};
+
+static const char*profile_path = 0;
+static struct profile_sample_s*profile_samples = 0;
+static volatile size_t profile_count = 0;
+static volatile unsigned long profile_ticks = 0;
+static volatile unsigned long profile_stride = 1;
+
+static void profile_tick(int)
+{
+      profile_ticks += 1;
+      if (profile_ticks % profile_stride != 0)
+	    return;
+
+      if (profile_count == PROFILE_MAX_SAMPLES) {
+	    for (size_t idx = 0 ; idx < PROFILE_MAX_SAMPLES/2 ; idx += 1)
+		  profile_samples[idx] = profile_samples[2*idx+1];
+	    profile_count = PROFILE_MAX_SAMPLES/2;
+	    profile_stride *= 2;
+      }
+
+      struct profile_sample_s&cur = profile_samples[profile_count];
+      if (! vthread_profile_point(cur.scope, cur.pc)) {
+	    cur.scope = 0;
+	    cur.pc = 0;
+      }
+      profile_count += 1;
+}
+
+bool profile_start(const char*path)
+{
+      profile_path = path;
+      profile_samples = new struct profile_sample_s[PROFILE_MAX_SAMPLES];
+
+      struct sigaction act;
+      memset(&act, 0, sizeof act);
+      act.sa_handler = &profile_tick;
+      act.sa_flags = SA_RESTART;
+      sigemptyset(&act.sa_mask);
+      if (sigaction(SIGPROF, &act, 0) != 0) {
+	    perror("sigaction");
+	    return false;
+      }
+
+      struct itimerval tim;
+      tim.it_interval.tv_sec = 0;
+      tim.it_interval.tv_usec = PROFILE_INTERVAL_USEC;
+      tim.it_value = tim.it_interval;
+      if (setitimer(ITIMER_PROF, &tim, 0) != 0) {
+	    perror("setitimer");
+	    return false;
+      }
+
+      return true;
+}
+
+/*
+ * Map the sampled program counters to the most recent %file_line
+ * instruction before them in the code space.
+ */
+struct profile_lines_s {
+      map<vvp_code_t,vpiHandle>*lines;
+      vpiHandle cur;
+};
+
+static void profile_find_line(vvp_code_t code, void*data)
+{
+      struct profile_lines_s*info = (struct profile_lines_s*)data;
+      if (code->opcode == &of_FILE_LINE)
+	    info->cur = code->handle;
+
+      map<vvp_code_t,vpiHandle>::iterator pos = info->lines->find(code);
+      if (pos != info->lines->end())
+	    pos->second = info->cur;
+}
+
+static string scope_full_name(__vpiScope*scope)
+{
+      if (scope == 0)
+	    return "(netlist)";
+      return scope->vpi_get_str(vpiFullName);
+}
+
+static string line_name(vpiHandle line)
+{
+      char buf[32];
+      snprintf(buf, sizeof buf, ":%d", vpi_get(vpiLineNo, line));
+      return string(vpi_get_str(vpiFile, line)) + buf;
+}
+
+template <class T> static void sort_by_count(const map<T,unsigned long>&src,
+					     vector<pair<unsigned long,T> >&dst)
+{
+      for (typename map<T,unsigned long>::const_iterator cur = src.begin()
+		 ; cur != src.end() ; ++ cur)
+	    dst.push_back(make_pair(cur->second, cur->first));
+      sort(dst.rbegin(), dst.rend());
+}
+
+struct profile_tree_s {
+      map<__vpiScope*,unsigned long> self;
+      map<__vpiScope*,unsigned long> total;
+      map<__vpiScope*,set<__vpiScope*> > children;
+      unsigned long count;
+};
+
+static void print_tree(FILE*fd, const profile_tree_s&tree,
+		       __vpiScope*scope, unsigned indent)
+{
+      map<__vpiScope*,unsigned long>::const_iterator self = tree.self.find(scope);
+      map<__vpiScope*,unsigned long>::const_iterator total = tree.total.find(scope);
+      unsigned long self_cnt = self==tree.self.end()? 0 : self->second;
+
+      const char*name = scope? scope->scope_name() : "(netlist)";
+      fprintf(fd, "  %6.2f%% %6.2f%%  %*s%s\n",
+	      100.0 * total->second / tree.count,
+	      100.0 * self_cnt / tree.count, indent, "", name);
+
+      map<__vpiScope*,set<__vpiScope*> >::const_iterator kids
+	    = tree.children.find(scope);
+      if (kids == tree.children.end())
+	    return;
+
+      map<__vpiScope*,unsigned long> sub;
+      for (set<__vpiScope*>::const_iterator cur = kids->second.begin()
+		 ; cur != kids->second.end() ; ++ cur)
+	    sub[*cur] = tree.total.find(*cur)->second;
+
+      vector<pair<unsigned long,__vpiScope*> > order;
+      sort_by_count(sub, order);
+      for (size_t idx = 0 ; idx < order.size() ; idx += 1)
+	    print_tree(fd, tree, order[idx].second, indent+2);
+}
+
+void profile_stop(void)
+{
+      if (profile_path == 0)
+	    return;
+
+      struct itimerval tim;
+      memset(&tim, 0, sizeof tim);
+      setitimer(ITIMER_PROF, &tim, 0);
+      signal(SIGPROF, SIG_IGN);
+
+      size_t count = profile_count;
+      const char*path = profile_path;
+      profile_path = 0;
+
+      map<pair<__vpiScope*,vvp_code_t>,unsigned long> points;
+      map<vvp_code_t,vpiHandle> lines;
+      for (size_t idx = 0 ; idx < count ; idx += 1) {
+	    struct profile_sample_s&cur = profile_samples[idx];
+	    points[make_pair(cur.scope, cur.pc)] += 1;
+	    if (cur.pc) lines[cur.pc] = 0;
+      }
+      delete[]profile_samples;
+      profile_samples = 0;
+
+      if (code_is_instrumented) {
+	    struct profile_lines_s info;
+	    info.lines = &lines;
+	    info.cur = 0;
+	    codespace_walk(&profile_find_line, &info);
+      }
+
+      profile_tree_s tree;
+      tree.count = count? count : 1;
+      map<string,unsigned long> by_line;
+      map<string,unsigned long> folded;
+
+      for (map<pair<__vpiScope*,vvp_code_t>,unsigned long>::iterator cur
+		 = points.begin() ; cur != points.end() ; ++ cur) {
+	    __vpiScope*scope = cur->first.first;
+	    vpiHandle line = cur->first.second? lines[cur->first.second] : 0;
+	    unsigned long cnt = cur->second;
+
+	    tree.self[scope] += cnt;
+	    tree.total[scope] += cnt;
+	    string stack = scope? scope->scope_name() : "(netlist)";
+	    if (scope) {
+		  for (__vpiScope*up = scope->scope ; up ; up = up->scope) {
+			tree.total[up] += cnt;
+			stack = string(up->scope_name()) + ";" + stack;
+		  }
+		  __vpiScope*child = scope;
+		  for (__vpiScope*up = scope->scope ; up ; up = up->scope) {
+			tree.children[up].insert(child);
+			child = up;
+		  }
+		  tree.children[0].insert(child);
+	    } else {
+		  tree.children[0].insert(0);
+	    }
+
+	    if (line) {
+		  string name = line_name(line);
+		  by_line[name] += cnt;
+		  stack += ";" + name;
+	    }
+	    folded[stack] += cnt;
+      }
+
+      FILE*fd = fopen(path, "w");
+      if (fd == 0) {
+	    perror(path);
+	    return;
+      }
+
+      fprintf(fd, "vvp profile: %zu samples, %lu ticks of %u usec\n",
+	      count, (unsigned long)profile_ticks, PROFILE_INTERVAL_USEC);
+
+      fprintf(fd, "\nFlat profile by scope:\n");
+      fprintf(fd, "    self%%  samples  scope\n");
+      vector<pair<unsigned long,__vpiScope*> > flat;
+      sort_by_count(tree.self, flat);
+      for (size_t idx = 0 ; idx < flat.size() ; idx += 1)
+	    fprintf(fd, "  %6.2f%% %8lu  %s\n",
+		    100.0 * flat[idx].first / tree.count, flat[idx].first,
+		    scope_full_name(flat[idx].second).c_str());
+
+      if (! by_line.empty()) {
+	    fprintf(fd, "\nFlat profile by source line:\n");
+	    fprintf(fd, "    self%%  samples  line\n");
+	    vector<pair<unsigned long,string> > flat_line;
+	    sort_by_count(by_line, flat_line);
+	    for (size_t idx = 0 ; idx < flat_line.size() ; idx += 1)
+		  fprintf(fd, "  %6.2f%% %8lu  %s\n",
+			  100.0 * flat_line[idx].first / tree.count,
+			  flat_line[idx].first, flat_line[idx].second.c_str());
+      }
+
+      fprintf(fd, "\nHierarchical profile:\n");
+      fprintf(fd, "   total%%   self%%  scope\n");
+      map<__vpiScope*,set<__vpiScope*> >::iterator roots = tree.children.find(0);
+      if (roots != tree.children.end()) {
+	    set<__vpiScope*> top = roots->second;
+	    tree.children.erase(roots);
+	    map<__vpiScope*,unsigned long> sub;
+	    for (set<__vpiScope*>::iterator cur = top.begin()
+		       ; cur != top.end() ; ++ cur)
+		  sub[*cur] = tree.total[*cur];
+	    vector<pair<unsigned long,__vpiScope*> > order;
+	    sort_by_count(sub, order);
+	    for (size_t idx = 0 ; idx < order.size() ; idx += 1)
+		  print_tree(fd, tree, order[idx].second, 0);
+      }
+      fclose(fd);
+
+      string folded_path = string(path) + ".folded";
+      fd = fopen(folded_path.c_str(), "w");
+      if (fd == 0) {
+	    perror(folded_path.c_str());
+	    return;
+      }
+      for (map<string,unsigned long>::iterator cur = folded.begin()
+		 ; cur != folded.end() ; ++ cur)
+	    fprintf(fd, "%s %lu\n", cur->first.c_str(), cur->second);
+      fclose(fd);
+}
+
+#else // defined(__MINGW32__)
+
+bool profile_start(const char*)
+{
+      fprintf(stderr, "vvp: profiling is not supported on this platform.\n");
+      return false;
+}
+
+void profile_stop(void)
+{
+}
+
+#endif
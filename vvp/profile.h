@@ -0,0 +1,38 @@
+#ifndef IVL_profile_H
+#define IVL_profile_H
+/*
+ * Copyright (c) 2026 agent (agent@local)
+ *
+ *    This source code is free software; you can redistribute it
+ *    and/or modify it in source code form under the terms of the GNU
+ *    General Public License as published by the Free Software
+ *    Foundation; either version 2 of the License, or (at your option)
+ *    any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * The sampling profiler is enabled by the +vvp-profile=<file>
+ * extended argument. While the simulation runs, a CPU time timer
+ * samples the scope and program counter of the running thread. Time
+ * spent while no thread is running is charged to the netlist. When
+ * the simulation ends, profile_stop() writes a flat and hierarchical
+ * report to the file, and folded stacks for flame graph tools to the
+ * same file name with ".folded" appended.
+ *
+ * Source lines are only known if the design was compiled with file
+ * and line information (-pfileline=1), otherwise the samples are
+ * attributed to scopes only.
+ */
+extern bool profile_start(const char*path);
+extern void profile_stop(void);
+
+#endif /* IVL_profile_H */
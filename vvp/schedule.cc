@@ -29,7 +29,13 @@
 # include  <csignal>
 # include  <cstdlib>
 # include  <cassert>
+# include  <cstring>
 # include  <iostream>
+# include  <map>
+# include  <vector>
+#ifdef USE_NETLIST_THREADS
+# include  <pthread.h>
+#endif
 #ifdef CHECK_WITH_VALGRIND
 # include  "vvp_cleanup.h"
 # include  "ivl_alloc.h"
@@ -38,8 +44,36 @@
 unsigned long count_assign_events = 0;
 unsigned long count_gen_events = 0;
 unsigned long count_thread_events = 0;
+  // Count the batches of events run by the -j mode, and their events
+unsigned long count_parallel_batches = 0;
+unsigned long count_parallel_events = 0;
   // Count the time events (A time cell created)
 unsigned long count_time_events = 0;
+  // Count the time cells that did not fit in the timing wheel
+unsigned long count_time_overflow = 0;
+
+#ifdef USE_NETLIST_THREADS
+/*
+ * This is true while worker threads of the -j mode are running a
+ * batch of events. The event queue belongs to the main thread, so the
+ * events that the workers schedule are captured and added to the
+ * queue after the batch. The event pools are not thread safe either,
+ * so while a batch runs they are only used under a lock.
+ */
+static bool sched_batch_running = false;
+static pthread_mutex_t sched_alloc_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+struct sched_alloc_lock_s {
+      sched_alloc_lock_s() : locked(sched_batch_running)
+      { if (locked) pthread_mutex_lock(&sched_alloc_mutex); }
+      ~sched_alloc_lock_s()
+      { if (locked) pthread_mutex_unlock(&sched_alloc_mutex); }
+      bool locked;
+};
+# define SCHED_ALLOC_LOCK sched_alloc_lock_s alloc_lock
+#else
+# define SCHED_ALLOC_LOCK do { } while (0)
+#endif
 
 
 
@@ -61,6 +95,13 @@ struct event_s {
 	// Write something about the event to stderr
       virtual void single_step_display(void);
 
+	// An event that only sends a value into the netlist returns
+	// the net that it sends to here, and run_net() does the work
+	// of run_run() without the statistics. The -j mode runs such
+	// events on a worker thread if the region of the net allows.
+      virtual vvp_net_t* parallel_net(void) { return 0; }
+      virtual void run_net(void) { assert(0); }
+
 	// Fallback new/delete
       static void*operator new (size_t size) { return ::new char[size]; }
       static void operator delete(void*ptr)  { ::delete[]( (char*)ptr ); }
@@ -84,6 +125,9 @@ struct event_time_s {
 	    next = NULL;
       }
       vvp_time64_t delay;
+	// Absolute time of this time step. This is only used when the
+	// time steps are kept in the timing wheel.
+      vvp_time64_t when;
 
       struct event_s*start;
       struct event_s*active;
@@ -140,11 +184,13 @@ static slab_t<sizeof(vthread_event_s),VTHR_CHUNK_COUNT> vthread_event_heap;
 inline void* vthread_event_s::operator new(size_t size)
 {
       assert(size == sizeof(vthread_event_s));
+      SCHED_ALLOC_LOCK;
       return vthread_event_heap.alloc_slab();
 }
 
 void vthread_event_s::operator delete(void*dptr)
 {
+      SCHED_ALLOC_LOCK;
       vthread_event_heap.free_slab(dptr);
 }
 
@@ -183,6 +229,8 @@ struct assign_vector4_event_s  : public event_s {
       unsigned vwid;
       void run_run(void);
       void single_step_display(void);
+      vvp_net_t* parallel_net(void) { return ptr.ptr(); }
+      void run_net(void);
 
       static void* operator new(size_t);
       static void operator delete(void*);
@@ -191,6 +239,11 @@ struct assign_vector4_event_s  : public event_s {
 void assign_vector4_event_s::run_run(void)
 {
       count_assign_events += 1;
+      assign_vector4_event_s::run_net();
+}
+
+void assign_vector4_event_s::run_net(void)
+{
       if (vwid > 0)
 	    vvp_send_vec4_pv(ptr, val, base, val.size(), vwid, 0);
       else
@@ -209,11 +262,13 @@ static slab_t<sizeof(assign_vector4_event_s),ASSIGN4_CHUNK_COUNT> assign4_heap;
 inline void* assign_vector4_event_s::operator new(size_t size)
 {
       assert(size == sizeof(assign_vector4_event_s));
+      SCHED_ALLOC_LOCK;
       return assign4_heap.alloc_slab();
 }
 
 void assign_vector4_event_s::operator delete(void*dptr)
 {
+      SCHED_ALLOC_LOCK;
       assign4_heap.free_slab(dptr);
 }
 
@@ -224,6 +279,8 @@ struct assign_vector8_event_s  : public event_s {
       vvp_vector8_t val;
       void run_run(void);
       void single_step_display(void);
+      vvp_net_t* parallel_net(void) { return ptr.ptr(); }
+      void run_net(void);
 
       static void* operator new(size_t);
       static void operator delete(void*);
@@ -232,6 +289,11 @@ struct assign_vector8_event_s  : public event_s {
 void assign_vector8_event_s::run_run(void)
 {
       count_assign_events += 1;
+      assign_vector8_event_s::run_net();
+}
+
+void assign_vector8_event_s::run_net(void)
+{
       vvp_send_vec8(ptr, val);
 }
 
@@ -246,11 +308,13 @@ static slab_t<sizeof(assign_vector8_event_s),ASSIGN8_CHUNK_COUNT> assign8_heap;
 inline void* assign_vector8_event_s::operator new(size_t size)
 {
       assert(size == sizeof(assign_vector8_event_s));
+      SCHED_ALLOC_LOCK;
       return assign8_heap.alloc_slab();
 }
 
 void assign_vector8_event_s::operator delete(void*dptr)
 {
+      SCHED_ALLOC_LOCK;
       assign8_heap.free_slab(dptr);
 }
 
@@ -283,11 +347,13 @@ static slab_t<sizeof(assign_real_event_s),ASSIGNR_CHUNK_COUNT> assignr_heap;
 inline void* assign_real_event_s::operator new (size_t size)
 {
       assert(size == sizeof(assign_real_event_s));
+      SCHED_ALLOC_LOCK;
       return assignr_heap.alloc_slab();
 }
 
 void assign_real_event_s::operator delete(void*dptr)
 {
+      SCHED_ALLOC_LOCK;
       assignr_heap.free_slab(dptr);
 }
 
@@ -316,11 +382,13 @@ static slab_t<sizeof(assign_array_word_s),ARRAY_W_CHUNK_COUNT> array_w_heap;
 inline void* assign_array_word_s::operator new (size_t size)
 {
       assert(size == sizeof(assign_array_word_s));
+      SCHED_ALLOC_LOCK;
       return array_w_heap.alloc_slab();
 }
 
 void assign_array_word_s::operator delete(void*ptr)
 {
+      SCHED_ALLOC_LOCK;
       array_w_heap.free_slab(ptr);
 }
 
@@ -388,11 +456,13 @@ static slab_t<sizeof(force_vector4_event_s),FORCE4_CHUNK_COUNT> force4_heap;
 inline void* force_vector4_event_s::operator new(size_t size)
 {
       assert(size == sizeof(force_vector4_event_s));
+      SCHED_ALLOC_LOCK;
       return force4_heap.alloc_slab();
 }
 
 void force_vector4_event_s::operator delete(void*dptr)
 {
+      SCHED_ALLOC_LOCK;
       force4_heap.free_slab(dptr);
 }
 
@@ -420,6 +490,8 @@ struct propagate_vector4_event_s : public event_s {
 	/* Action */
       void run_run(void);
       void single_step_display(void);
+      vvp_net_t* parallel_net(void) { return net; }
+      void run_net(void) { run_run(); }
 };
 
 void propagate_vector4_event_s::run_run(void)
@@ -477,11 +549,13 @@ static slab_t<sizeof(assign_array_r_word_s),ARRAY_R_W_CHUNK_COUNT> array_r_w_hea
 inline void* assign_array_r_word_s::operator new(size_t size)
 {
       assert(size == sizeof(assign_array_r_word_s));
+      SCHED_ALLOC_LOCK;
       return array_r_w_heap.alloc_slab();
 }
 
 void assign_array_r_word_s::operator delete(void*ptr)
 {
+      SCHED_ALLOC_LOCK;
       array_r_w_heap.free_slab(ptr);
 }
 
@@ -492,6 +566,8 @@ struct generic_event_s : public event_s {
       bool delete_obj_when_done;
       void run_run(void);
       void single_step_display(void);
+      vvp_net_t* parallel_net(void);
+      void run_net(void) { obj->run_run(); }
 
       static void* operator new(size_t);
       static void operator delete(void*);
@@ -512,17 +588,26 @@ void generic_event_s::single_step_display(void)
       obj->single_step_display();
 }
 
+vvp_net_t* generic_event_s::parallel_net(void)
+{
+      if (obj == 0 || delete_obj_when_done)
+	    return 0;
+      return obj->parallel_net();
+}
+
 static const size_t GENERIC_CHUNK_COUNT = 131072 / sizeof(struct generic_event_s);
 static slab_t<sizeof(generic_event_s),GENERIC_CHUNK_COUNT> generic_event_heap;
 
 inline void* generic_event_s::operator new(size_t size)
 {
       assert(size == sizeof(generic_event_s));
+      SCHED_ALLOC_LOCK;
       return generic_event_heap.alloc_slab();
 }
 
 void generic_event_s::operator delete(void*ptr)
 {
+      SCHED_ALLOC_LOCK;
       generic_event_heap.free_slab(ptr);
 }
 
@@ -555,9 +640,243 @@ unsigned long count_time_pool(void) { return event_time_heap.pool; }
  * This is the head of the list of pending events. This includes all
  * the events that have not been executed yet, and reaches into the
  * future.
+ *
+ * The head is always the earliest pending time step, and its delay
+ * is relative to the current simulation time. How the rest of the
+ * time steps are kept depends on the selected queue type. In the
+ * "list" mode the time steps are chained through the next pointer,
+ * each with a delay relative to the previous time step. In the
+ * "wheel" mode the next pointer is not used, and the remaining time
+ * steps are instead kept in the timing wheel below.
  */
 static struct event_time_s* sched_list = 0;
 
+static vvp_time64_t schedule_time;
+
+static bool sched_use_wheel = false;
+
+bool schedule_set_queue(const char*name)
+{
+      if (strcmp(name, "list") == 0) {
+	    sched_use_wheel = false;
+	    return true;
+      }
+      if (strcmp(name, "wheel") == 0) {
+	    sched_use_wheel = true;
+	    return true;
+      }
+      return false;
+}
+
+bool schedule_queue_is_wheel(void)
+{
+      return sched_use_wheel;
+}
+
+/*
+ * The timing wheel is an array of slots, one per simulation tick,
+ * covering the times from wheel_base to wheel_base+WHEEL_SIZE-1. Each
+ * time in that window maps to a unique slot, so finding the
+ * event_time_s for a time is a single array index. A bitmap of the
+ * occupied slots makes finding the next pending time step a short
+ * scan of words instead of a scan of slots.
+ *
+ * Time steps outside the window are kept in the overflow map, which
+ * is ordered by absolute time. When the window advances, the
+ * overflow entries that now fall within the window are moved into
+ * the wheel, so that any given time is only ever in one place.
+ *
+ * This is a single level wheel, not a hierarchical one. The delays of
+ * clocks, gates and most # statements are well within the 4096 ticks
+ * of the window, so they never reach the overflow. The overflow map
+ * takes the place of both the higher levels and the far future heap.
+ * It costs O(log n) per insert, but only for the time steps beyond
+ * the window, and it hands them back to the wheel in time order as
+ * the window advances. A design that keeps most of its events further
+ * ahead than that would be better served by more levels. The
+ * "wheel overflow" count of vvp -v shows how many time steps went to
+ * the map.
+ */
+static const unsigned WHEEL_BITS = 12;
+static const vvp_time64_t WHEEL_SIZE = 1 << WHEEL_BITS;
+static const vvp_time64_t WHEEL_MASK = WHEEL_SIZE - 1;
+static const unsigned WHEEL_WORDS = WHEEL_SIZE / 64;
+
+static struct event_time_s* wheel_slot[WHEEL_SIZE];
+static uint64_t wheel_map[WHEEL_WORDS];
+static unsigned long wheel_count = 0;
+static vvp_time64_t wheel_base = 0;
+
+typedef std::map<vvp_time64_t,struct event_time_s*> wheel_overflow_t;
+static wheel_overflow_t wheel_overflow;
+
+static inline bool wheel_in_window_(vvp_time64_t when)
+{
+      return when >= wheel_base && (when - wheel_base) < WHEEL_SIZE;
+}
+
+static inline unsigned wheel_first_bit_(uint64_t bits)
+{
+#if defined(__GNUC__)
+      return __builtin_ctzll(bits);
+#else
+      unsigned idx = 0;
+      while ((bits & 1) == 0) {
+	    bits >>= 1;
+	    idx += 1;
+      }
+      return idx;
+#endif
+}
+
+static void wheel_insert_(struct event_time_s*ctim)
+{
+      if (wheel_in_window_(ctim->when)) {
+	    unsigned slot = ctim->when & WHEEL_MASK;
+	    assert(wheel_slot[slot] == 0);
+	    wheel_slot[slot] = ctim;
+	    wheel_map[slot/64] |= (uint64_t)1 << (slot%64);
+	    wheel_count += 1;
+      } else {
+	    count_time_overflow += 1;
+	    wheel_overflow[ctim->when] = ctim;
+      }
+}
+
+static struct event_time_s* wheel_find_(vvp_time64_t when)
+{
+      if (wheel_in_window_(when)) {
+	    struct event_time_s*ctim = wheel_slot[when & WHEEL_MASK];
+	    assert(ctim == 0 || ctim->when == when);
+	    return ctim;
+      }
+
+      wheel_overflow_t::iterator cur = wheel_overflow.find(when);
+      if (cur == wheel_overflow.end())
+	    return 0;
+      return cur->second;
+}
+
+/*
+ * Remove and return the earliest time step in the wheel or the
+ * overflow map, or nil if there are none.
+ */
+static struct event_time_s* wheel_pop_(void)
+{
+      struct event_time_s*ctim = 0;
+      unsigned slot = 0;
+
+      if (wheel_count > 0) {
+	      /* All the times in the wheel are within the window, so
+		 scanning the slots from the base wraps around the array
+		 in time order. The last pass picks up the bits of the
+		 starting word that are below the starting slot. */
+	    unsigned start = wheel_base & WHEEL_MASK;
+	    for (unsigned idx = 0 ; idx <= WHEEL_WORDS ; idx += 1) {
+		  unsigned word = (start/64 + idx) % WHEEL_WORDS;
+		  uint64_t bits = wheel_map[word];
+		  if (idx == 0)
+			bits &= ~(uint64_t)0 << (start%64);
+		  else if (idx == WHEEL_WORDS)
+			bits &= ~(~(uint64_t)0 << (start%64));
+		  if (bits == 0)
+			continue;
+
+		  slot = word*64 + wheel_first_bit_(bits);
+		  ctim = wheel_slot[slot];
+		  break;
+	    }
+	    assert(ctim);
+      }
+
+	/* The overflow map may hold times before the window as well
+	   as after it, so the earliest overflow entry may be ahead of
+	   the earliest wheel entry. */
+      if (!wheel_overflow.empty()
+	  && (ctim == 0 || wheel_overflow.begin()->first < ctim->when)) {
+	    ctim = wheel_overflow.begin()->second;
+	    wheel_overflow.erase(wheel_overflow.begin());
+
+      } else if (ctim) {
+	    wheel_slot[slot] = 0;
+	    wheel_map[slot/64] &= ~((uint64_t)1 << (slot%64));
+	    wheel_count -= 1;
+
+      } else {
+	    return 0;
+      }
+
+	/* Advance the window to the time step being removed, and
+	   pull into the wheel any overflow entries that now fit. */
+      if (ctim->when > wheel_base) {
+	    wheel_base = ctim->when;
+	    wheel_overflow_t::iterator cur = wheel_overflow.lower_bound(wheel_base);
+	    while (cur != wheel_overflow.end() && wheel_in_window_(cur->first)) {
+		  struct event_time_s*tmp = cur->second;
+		  wheel_overflow.erase(cur++);
+		  wheel_insert_(tmp);
+	    }
+      }
+
+      return ctim;
+}
+
+/*
+ * Get the time step that is delay away from the current simulation
+ * time, creating it if needed. This is the "wheel" version of the
+ * list walk in schedule_event_().
+ */
+static struct event_time_s* wheel_time_step_(vvp_time64_t delay)
+{
+      struct event_time_s*ctim = sched_list;
+
+      if (ctim && ctim->delay == delay)
+	    return ctim;
+
+      if (ctim == 0 || ctim->delay > delay) {
+	      /* The new time step is earlier than anything else, so
+		 it becomes the head. The old head (if any) goes into
+		 the wheel with the rest of the time steps. */
+	    struct event_time_s*tmp = new struct event_time_s;
+	    tmp->delay = delay;
+	    tmp->when = schedule_time + delay;
+	    if (ctim) wheel_insert_(ctim);
+	    sched_list = tmp;
+	    return tmp;
+      }
+
+      vvp_time64_t when = schedule_time + delay;
+      ctim = wheel_find_(when);
+      if (ctim == 0) {
+	    ctim = new struct event_time_s;
+	    ctim->delay = 0;
+	    ctim->when = when;
+	    wheel_insert_(ctim);
+      }
+
+      return ctim;
+}
+
+/*
+ * The current time step (the head) is finished. Release it and make
+ * the next time step the head.
+ */
+static void schedule_next_time_step_(struct event_time_s*ctim)
+{
+      if (! sched_use_wheel) {
+	    sched_list = ctim->next;
+	    delete ctim;
+	    return;
+      }
+
+      delete ctim;
+      sched_list = wheel_pop_();
+      if (sched_list) {
+	    assert(sched_list->when >= schedule_time);
+	    sched_list->delay = sched_list->when - schedule_time;
+      }
+}
+
 /*
  * This is a list of initialization events. The setup puts
  * initializations in this list so that they happen before the
@@ -679,13 +998,28 @@ static void schedule_final_event(struct event_s*cur)
 typedef enum event_queue_e { SEQ_START, SEQ_ACTIVE, SEQ_INACTIVE, SEQ_NBASSIGN,
 			     SEQ_RWSYNC, SEQ_ROSYNC, DEL_THREAD } event_queue_t;
 
+#ifdef USE_NETLIST_THREADS
+static void schedule_capture_(struct event_s*cur, vvp_gen_event_t obj,
+			      vvp_time64_t delay, event_queue_t select_queue,
+			      bool push_flag);
+#endif
+
 static void schedule_event_(struct event_s*cur, vvp_time64_t delay,
 			    event_queue_t select_queue)
 {
+#ifdef USE_NETLIST_THREADS
+      if (sched_batch_running) {
+	    schedule_capture_(cur, 0, delay, select_queue, false);
+	    return;
+      }
+#endif
       cur->next = cur;
       struct event_time_s*ctim = sched_list;
 
-      if (sched_list == 0) {
+      if (sched_use_wheel) {
+	    ctim = wheel_time_step_(delay);
+
+      } else if (sched_list == 0) {
 	      /* Is the event_time list completely empty? Create the
 		 first event_time object. */
 	    ctim = new struct event_time_s;
@@ -784,6 +1118,12 @@ static void schedule_event_(struct event_s*cur, vvp_time64_t delay,
 
 static void schedule_event_push_(struct event_s*cur)
 {
+#ifdef USE_NETLIST_THREADS
+      if (sched_batch_running) {
+	    schedule_capture_(cur, 0, 0, SEQ_ACTIVE, true);
+	    return;
+      }
+#endif
       if ((sched_list == 0) || (sched_list->delay > 0)) {
 	    schedule_event_(cur, 0, SEQ_ACTIVE);
 	    return;
@@ -1009,6 +1349,13 @@ static bool sim_started;
 
 void schedule_functor(vvp_gen_event_t obj)
 {
+#ifdef USE_NETLIST_THREADS
+      if (sched_batch_running) {
+	    schedule_capture_(0, obj, 0, SEQ_ACTIVE, false);
+	    return;
+      }
+#endif
+
       struct generic_event_s*cur = new generic_event_s;
 
       cur->obj = obj;
@@ -1029,7 +1376,6 @@ void schedule_at_start_of_simtime(vvp_gen_event_t obj, vvp_time64_t delay)
       schedule_event_(cur, delay, SEQ_START);
 }
 
-static vvp_time64_t schedule_time;
 vvp_time64_t schedule_simtime(void)
 { return schedule_time; }
 
@@ -1042,6 +1388,275 @@ static bool sim_at_rosync = false;
 bool schedule_at_rosync(void)
 { return sim_at_rosync; }
 
+/*
+ * The -j mode. The worker threads of the pool take turns with the
+ * main thread: the main thread takes a batch of events off the front
+ * of the active queue, the workers (and the main thread) run them,
+ * and the main thread adds the events they scheduled to the queue
+ * before it carries on. The events of one region run in queue order
+ * on a single thread, and the captured events are scheduled in the
+ * order of the events that scheduled them, so the queue ends up just
+ * as it would with one thread.
+ *
+ * This is experimental, and is only built if vvp is configured with
+ * --enable-netlist-threads.
+ */
+static unsigned sched_workers = 1;
+
+bool schedule_set_workers(const char*text)
+{
+      char*end;
+      unsigned long val = strtoul(text, &end, 10);
+      if (end == text || *end != 0 || val < 1 || val > 256)
+	    return false;
+#ifndef USE_NETLIST_THREADS
+      if (val > 1)
+	    return false;
+#endif
+      sched_workers = val;
+      return true;
+}
+
+unsigned schedule_workers(void)
+{
+      return sched_workers;
+}
+
+#ifdef USE_NETLIST_THREADS
+struct sched_batch_item_s {
+      struct event_s*cur;
+      unsigned region;
+      unsigned worker;
+	// The functors that the event scheduled, as a range of the
+	// capture list of the worker that ran it.
+      size_t first;
+      size_t count;
+};
+
+/*
+ * An event that a worker scheduled during a batch. This is either a
+ * functor for schedule_functor() or an event for the queue.
+ */
+struct sched_capture_s {
+      struct event_s*cur;
+      vvp_gen_event_t obj;
+      vvp_time64_t delay;
+      event_queue_t select_queue;
+      bool push_flag;
+};
+
+struct sched_worker_s {
+      pthread_t thread;
+	// The batch items this worker runs, in queue order.
+      std::vector<size_t> items;
+      std::vector<sched_capture_s> capture;
+};
+
+static std::vector<sched_batch_item_s> sched_batch;
+static struct sched_worker_s*sched_worker_tab = 0;
+static pthread_key_t sched_worker_key;
+
+static pthread_mutex_t sched_batch_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sched_batch_start_sig = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t sched_batch_done_sig = PTHREAD_COND_INITIALIZER;
+static unsigned long sched_batch_number = 0;
+static unsigned sched_batch_busy = 0;
+static bool sched_batch_quit = false;
+
+static void schedule_capture_(struct event_s*cur, vvp_gen_event_t obj,
+			      vvp_time64_t delay, event_queue_t select_queue,
+			      bool push_flag)
+{
+      struct sched_worker_s*wrk = (struct sched_worker_s*)
+	    pthread_getspecific(sched_worker_key);
+      struct sched_capture_s item;
+      item.cur = cur;
+      item.obj = obj;
+      item.delay = delay;
+      item.select_queue = select_queue;
+      item.push_flag = push_flag;
+      wrk->capture.push_back(item);
+}
+
+static void schedule_run_items_(struct sched_worker_s*wrk)
+{
+      for (size_t idx = 0 ; idx < wrk->items.size() ; idx += 1) {
+	    struct sched_batch_item_s&item = sched_batch[wrk->items[idx]];
+	    item.first = wrk->capture.size();
+	    item.cur->run_net();
+	    item.count = wrk->capture.size() - item.first;
+      }
+}
+
+extern "C" void* schedule_worker_thread(void*arg)
+{
+      struct sched_worker_s*wrk = (struct sched_worker_s*)arg;
+      pthread_setspecific(sched_worker_key, wrk);
+
+      unsigned long seen = 0;
+      pthread_mutex_lock(&sched_batch_mutex);
+      for (;;) {
+	    while (sched_batch_number == seen && !sched_batch_quit)
+		  pthread_cond_wait(&sched_batch_start_sig, &sched_batch_mutex);
+	    if (sched_batch_quit)
+		  break;
+	    seen = sched_batch_number;
+	    pthread_mutex_unlock(&sched_batch_mutex);
+
+	    schedule_run_items_(wrk);
+
+	    pthread_mutex_lock(&sched_batch_mutex);
+	    sched_batch_busy -= 1;
+	    if (sched_batch_busy == 0)
+		  pthread_cond_signal(&sched_batch_done_sig);
+      }
+      pthread_mutex_unlock(&sched_batch_mutex);
+      return 0;
+}
+
+/*
+ * Start the worker threads. Worker 0 is the main thread. The workers
+ * block all signals, so that signals (and the samples of the
+ * profiler) are always taken by the main thread.
+ */
+static void schedule_start_workers_(void)
+{
+      pthread_key_create(&sched_worker_key, 0);
+      sched_worker_tab = new struct sched_worker_s[sched_workers];
+      pthread_setspecific(sched_worker_key, &sched_worker_tab[0]);
+
+      sigset_t all, old;
+      sigfillset(&all);
+      pthread_sigmask(SIG_SETMASK, &all, &old);
+      for (unsigned idx = 1 ; idx < sched_workers ; idx += 1) {
+	    int rc = pthread_create(&sched_worker_tab[idx].thread, 0,
+				    &schedule_worker_thread,
+				    &sched_worker_tab[idx]);
+	    if (rc != 0) {
+		  cerr << "vvp: Unable to start worker thread: "
+		       << strerror(rc) << endl;
+		  sched_workers = idx;
+		  break;
+	    }
+      }
+      pthread_sigmask(SIG_SETMASK, &old, 0);
+}
+
+static void schedule_stop_workers_(void)
+{
+      pthread_mutex_lock(&sched_batch_mutex);
+      sched_batch_quit = true;
+      pthread_cond_broadcast(&sched_batch_start_sig);
+      pthread_mutex_unlock(&sched_batch_mutex);
+
+      for (unsigned idx = 1 ; idx < sched_workers ; idx += 1)
+	    pthread_join(sched_worker_tab[idx].thread, 0);
+
+      delete[]sched_worker_tab;
+      sched_worker_tab = 0;
+      pthread_key_delete(sched_worker_key);
+}
+
+/*
+ * Take the run of events at the front of the active queue that the
+ * workers can evaluate, and run them. Return false if the first event
+ * is not such an event, so that the caller runs it as usual.
+ */
+static bool schedule_run_batch_(struct event_time_s*ctim)
+{
+      sched_batch.clear();
+      bool many_regions = false;
+      while (ctim->active) {
+	    struct event_s*cur = ctim->active->next;
+	    vvp_net_t*net = cur->parallel_net();
+	    unsigned region = net? vvp_net_region(net) : 0;
+	    if (region == 0)
+		  break;
+
+	    if (cur->next == cur) {
+		  ctim->active = 0;
+	    } else {
+		  ctim->active->next = cur->next;
+	    }
+
+	    struct sched_batch_item_s item;
+	    item.cur = cur;
+	    item.region = region;
+	    item.worker = 0;
+	    item.first = 0;
+	    item.count = 0;
+	    if (! sched_batch.empty() && sched_batch[0].region != region)
+		  many_regions = true;
+	    sched_batch.push_back(item);
+      }
+
+      if (sched_batch.empty())
+	    return false;
+
+      count_parallel_events += sched_batch.size();
+
+	// A single region is not worth waking the workers for.
+      if (! many_regions) {
+	    for (size_t idx = 0 ; idx < sched_batch.size() ; idx += 1) {
+		  sched_batch[idx].cur->run_net();
+		  delete sched_batch[idx].cur;
+	    }
+	    return true;
+      }
+
+	// Deal the events out to the workers by region, so that the
+	// events of a region run in queue order on one thread.
+      for (size_t idx = 0 ; idx < sched_batch.size() ; idx += 1) {
+	    struct sched_batch_item_s&item = sched_batch[idx];
+	    item.worker = item.region % sched_workers;
+	    sched_worker_tab[item.worker].items.push_back(idx);
+      }
+
+      count_parallel_batches += 1;
+
+      sched_batch_running = true;
+      pthread_mutex_lock(&sched_batch_mutex);
+      sched_batch_busy = sched_workers - 1;
+      sched_batch_number += 1;
+      pthread_cond_broadcast(&sched_batch_start_sig);
+      pthread_mutex_unlock(&sched_batch_mutex);
+
+      schedule_run_items_(&sched_worker_tab[0]);
+
+      pthread_mutex_lock(&sched_batch_mutex);
+      while (sched_batch_busy > 0)
+	    pthread_cond_wait(&sched_batch_done_sig, &sched_batch_mutex);
+      pthread_mutex_unlock(&sched_batch_mutex);
+      sched_batch_running = false;
+
+	// Schedule the captured events in the order of the events
+	// that scheduled them. The netlist functors only schedule
+	// functors and plain events, which land where they would have
+	// landed with one thread. A pushed event goes to the front of
+	// the queue as usual, but only runs after the whole batch.
+      for (size_t idx = 0 ; idx < sched_batch.size() ; idx += 1) {
+	    struct sched_batch_item_s&item = sched_batch[idx];
+	    struct sched_worker_s&wrk = sched_worker_tab[item.worker];
+	    for (size_t cdx = 0 ; cdx < item.count ; cdx += 1) {
+		  struct sched_capture_s&cap = wrk.capture[item.first+cdx];
+		  if (cap.obj)
+			schedule_functor(cap.obj);
+		  else if (cap.push_flag)
+			schedule_event_push_(cap.cur);
+		  else
+			schedule_event_(cap.cur, cap.delay, cap.select_queue);
+	    }
+	    delete item.cur;
+      }
+
+      for (unsigned idx = 0 ; idx < sched_workers ; idx += 1) {
+	    sched_worker_tab[idx].items.clear();
+	    sched_worker_tab[idx].capture.clear();
+      }
+      return true;
+}
+#endif
+
 /*
  * The scheduler uses this function to drain the rosync events of the
  * current time. The ctim object is still in the event queue, because
@@ -1135,6 +1750,11 @@ void schedule_simulate(void)
       // process events and when done run the final blocks.
       run_finals = schedule_runnable;
 
+#ifdef USE_NETLIST_THREADS
+      if (sched_workers > 1)
+	    schedule_start_workers_();
+#endif
+
       if (schedule_runnable) while (sched_list) {
 
 	    if (schedule_stopped_flag) {
@@ -1197,14 +1817,21 @@ void schedule_simulate(void)
 				   deletes threads as needed. */
 			      if (ctim->active == 0) {
 				    run_rosync(ctim);
-				    sched_list = ctim->next;
-				    delete ctim;
+				    schedule_next_time_step_(ctim);
 				    continue;
 			      }
 			}
 		  }
 	    }
 
+#ifdef USE_NETLIST_THREADS
+	      /* In the -j mode, let the workers evaluate the netlist
+		 events at the front of the list. */
+	    if (sched_workers > 1 && !schedule_single_step_flag
+		&& schedule_run_batch_(ctim))
+		  continue;
+#endif
+
 	      /* Pull the first item off the list. If this is the last
 		 cell in the list, then clear the list. Execute that
 		 event type, and delete it. */
@@ -1226,6 +1853,11 @@ void schedule_simulate(void)
 	    delete (cur);
       }
 
+#ifdef USE_NETLIST_THREADS
+      if (sched_workers > 1)
+	    schedule_stop_workers_();
+#endif
+
 	// Execute final events.
       schedule_runnable = run_finals;
       while (schedule_runnable && schedule_final_list) {
@@ -157,8 +157,38 @@ struct vvp_gen_event_s
       virtual ~vvp_gen_event_s() =0;
       virtual void run_run() =0;
       virtual void single_step_display(void);
+
+	// A functor that schedules itself with schedule_functor()
+	// returns its net here, so that the -j mode can run the event
+	// on a worker thread if the region of the net allows it.
+      virtual vvp_net_t* parallel_net() { return 0; }
 };
 
+/*
+ * Select how the scheduler keeps the pending time steps. The "list"
+ * queue is a sorted list of time steps with relative delays, and the
+ * "wheel" queue is a timing wheel with an overflow map for times far
+ * in the future. Both keep the same stratified event queue within a
+ * time step. This must be called before any events are scheduled,
+ * and returns false if the name is not recognized.
+ */
+extern bool schedule_set_queue(const char*name);
+extern bool schedule_queue_is_wheel(void);
+
+/*
+ * Set the number of threads that evaluate the netlist. With more than
+ * one, the scheduler takes each run of active events that only send
+ * values into the netlist, and evaluates the events of independent
+ * regions (see vvp_net_partition) on a pool of worker threads. The
+ * events that the workers schedule are added to the queue in the
+ * order the events would have run on one thread, so the results are
+ * the same. This returns false if the text is not a valid number, or
+ * if it is more than 1 and vvp was not configured with
+ * --enable-netlist-threads.
+ */
+extern bool schedule_set_workers(const char*text);
+extern unsigned schedule_workers(void);
+
 /*
  * This runs the simulator. It runs until all the functors run out or
  * the simulation is otherwise finished.
@@ -207,6 +237,8 @@ extern unsigned long count_assign_events;
 extern unsigned long count_gen_events;
 extern unsigned long count_prop_events;
 extern unsigned long count_thread_events;
+extern unsigned long count_parallel_batches;
+extern unsigned long count_parallel_events;
 extern unsigned long count_event_pool;
 
 #endif /* IVL_schedule_H */
@@ -24,6 +24,11 @@
  */
 unsigned long count_opcodes = 0;
 
+/*
+ * This is a count of the instruction sequences that were fused.
+ */
+unsigned long count_opcodes_fused = 0;
+
 unsigned long count_functors = 0;
 unsigned long count_functors_logic = 0;
 unsigned long count_functors_bufif = 0;
@@ -37,3 +42,26 @@ unsigned long count_vpi_scopes = 0;
 
 size_t size_opcodes = 0;
 
+/*
+ * This is a count of the thread vec4 stack pushes that kept the word
+ * array of a previously used stack slot, instead of allocating one.
+ */
+unsigned long count_vec4_stack_reuse = 0;
+
+/*
+ * These count the threads that vthread_new allocated and the threads
+ * that it took from the free list of the scope instead.
+ */
+unsigned long count_thread_alloc = 0;
+unsigned long count_thread_reuse = 0;
+
+/*
+ * This is a count of the pages that sparse memories have allocated.
+ */
+unsigned long count_sparse_array_pages = 0;
+
+/*
+ * This is a count of the VPI word handles that were made on demand
+ * for variable arrays.
+ */
+unsigned long count_array_word_handles = 0;
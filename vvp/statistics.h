@@ -27,6 +27,7 @@
 #endif
 
 extern unsigned long count_opcodes;
+extern unsigned long count_opcodes_fused;
 extern unsigned long count_functors;
 extern unsigned long count_functors_logic;
 extern unsigned long count_functors_bufif;
@@ -34,6 +35,9 @@ extern unsigned long count_functors_resolv;
 extern unsigned long count_functors_sig;
 extern unsigned long count_filters;
 extern unsigned long count_vvp_nets;
+extern unsigned long count_net_regions;
+extern unsigned long count_net_region_max;
+extern unsigned long count_net_regions_parallel;
 extern unsigned long count_vpi_nets;
 extern unsigned long count_vpi_scopes;
 
@@ -41,11 +45,15 @@ extern unsigned long count_net_arrays;
 extern unsigned long count_net_array_words;
 extern unsigned long count_var_arrays;
 extern unsigned long count_var_array_words;
+extern unsigned long count_sparse_arrays;
+extern unsigned long count_sparse_array_pages;
+extern unsigned long count_array_word_handles;
 extern unsigned long count_real_arrays;
 extern unsigned long count_real_array_words;
 
 
 extern unsigned long count_time_events;
+extern unsigned long count_time_overflow;
 extern unsigned long count_time_pool(void);
 
 extern unsigned long count_assign_events;
@@ -55,6 +63,10 @@ extern unsigned long count_assign_real_pool(void);
 extern unsigned long count_assign_aword_pool(void);
 extern unsigned long count_assign_arword_pool(void);
 
+extern unsigned long count_vec4_stack_reuse;
+extern unsigned long count_thread_alloc;
+extern unsigned long count_thread_reuse;
+
 extern unsigned long count_gen_events;
 extern unsigned long count_gen_pool(void);
 
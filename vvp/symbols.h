@@ -70,16 +70,31 @@ class symbol_table_s {
 
     private:
       symbol_table_s(const symbol_table_s&) { assert(0); };
-      struct tree_node_*root;
+      struct table_entry_*table;
+      unsigned table_mask;
+      unsigned table_count;
       struct key_strings*str_chunk;
       unsigned str_used;
 
-      symbol_value_t find_value_(struct tree_node_*cur,
-				 const char*key, symbol_value_t val,
-				 bool force_flag);
+      struct table_entry_*find_entry_(const char*key);
+      void grow_table_(void);
       char*key_strdup_(const char*str);
 };
 
+/*
+ * Hash a nul terminated name with FNV-1a. The symbol tables use this,
+ * and so does the name index of the VPI scopes.
+ */
+inline unsigned symbol_hash(const char*key)
+{
+      unsigned hash = 2166136261U;
+      for ( ; *key ; key += 1) {
+	    hash ^= (unsigned char)*key;
+	    hash *= 16777619U;
+      }
+      return hash;
+}
+
 /*
  * Create a new symbol table or release an existing one. A new symbol
  * table has no keys and no values. As a symbol table is built up, it
@@ -667,12 +667,14 @@ void vvp_vpi_callback::attach_as_word(vvp_array_t arr, unsigned long addr)
       tmp->word = addr;
       tmp->next = array_words_;
       array_words_ = tmp;
+      vvp_net_region_serial(this);
 }
 
 void vvp_vpi_callback::add_vpi_callback(value_callback*cb)
 {
       cb->next = vpi_callbacks_;
       vpi_callbacks_ = cb;
+      vvp_net_region_serial(this);
 }
 
 #ifdef CHECK_WITH_VALGRIND
@@ -211,9 +211,7 @@ void __vpiDarrayVar::put_word_value(struct __vpiArrayWord*word, p_vpi_value vp,
 
 vpiHandle __vpiDarrayVar::get_iter_index(struct __vpiArrayIterator*, int idx)
 {
-      if (vals_words == 0) make_vals_words();
-
-      return &(vals_words[idx].as_word);
+      return word_handle(idx);
 }
 
 int __vpiDarrayVar::vpi_get(int code)
@@ -270,10 +268,7 @@ vpiHandle __vpiDarrayVar::vpi_index(int index)
       if (index < 0)
 	    return 0;
 
-      if (vals_words == 0)
-	    make_vals_words();
-
-      return &(vals_words[index].as_word);
+      return word_handle(index);
 }
 
 void __vpiDarrayVar::vpi_get_value(p_vpi_value val)
@@ -350,7 +345,6 @@ vpiHandle vpip_make_queue_var(const char*name, vvp_net_t*net)
 void darray_delete(vpiHandle item)
 {
       __vpiDarrayVar*obj = dynamic_cast<__vpiDarrayVar*>(item);
-      if (obj->vals_words) delete [] (obj->vals_words-1);
       delete obj;
 }
 
@@ -19,6 +19,7 @@
 
 # include  "version_base.h"
 # include  "vpi_priv.h"
+# include  "vvp_net_sig.h"
 # include  "schedule.h"
 #ifdef CHECK_WITH_VALGRIND
 # include  "vvp_cleanup.h"
@@ -1277,52 +1278,75 @@ vpiHandle vpi_handle_by_index(vpiHandle ref, PLI_INT32 idx)
       return ref->vpi_index(idx);
 }
 
+/*
+ * Look for a word of a memory or net array by a name like "mem[3]".
+ * Find the array by its base name, and then the word by its index.
+ */
+static vpiHandle find_array_word(const char *name, __vpiScope*ref)
+{
+      size_t len = strlen(name);
+      const char*open = strchr(name, '[');
+      if (open == 0 || open == name || name[len-1] != ']')
+	    return 0;
+
+      string base (name, open-name);
+      vpiHandle array = vpip_find_by_name(ref, base.c_str(), vpiScope);
+      if (array == 0)
+	    return 0;
+      int type = vpi_get(vpiType, array);
+      if (type != vpiMemory && type != vpiNetArray)
+	    return 0;
+
+      char*end;
+      long index = strtol(open+1, &end, 10);
+      if (end != name+len-1 || end == open+1)
+	    return 0;
+
+	/* The word names are made from the index, so the word found
+	   by index should have the name. If not, then give up on the
+	   shortcut and scan the words of the array for the name. */
+      vpiHandle word_h = vpi_handle_by_index(array, (PLI_INT32)index);
+      if (word_h && !strcmp(name, vpi_get_str(vpiName, word_h)))
+	    return word_h;
+
+      vpiHandle word_i = vpi_iterate(vpiMemoryWord, array);
+      while (word_i && (word_h = vpi_scan(word_i))) {
+	    if (!strcmp(name, vpi_get_str(vpiName, word_h))) {
+		  vpi_free_object(word_i);
+		  return word_h;
+	    }
+      }
+
+      return 0;
+}
+
 static vpiHandle find_name(const char *name, vpiHandle handle)
 {
-      vpiHandle rtn = 0;
       __vpiScope*ref = dynamic_cast<__vpiScope*>(handle);
 
       /* check module names */
       if (!strcmp(name, vpi_get_str(vpiName, handle)))
-	    rtn = handle;
-
-      /* brute force search for the name in all objects in this scope */
-      for (unsigned i = 0 ;  i < ref->intern.size() ;  i += 1) {
-	      /* The standard says that since a port does not have a full
-	       * name it cannot be found by name. Because of this we need
-	       * to skip ports here so the correct handle can be located. */
-	    if (vpi_get(vpiType, ref->intern[i]) == vpiPort) continue;
-	    char *nm = vpi_get_str(vpiName, ref->intern[i]);
-	    if (!strcmp(name, nm)) {
-		  rtn = ref->intern[i];
-		  break;
-	    } else if (vpi_get(vpiType, ref->intern[i]) == vpiMemory ||
-	               vpi_get(vpiType, ref->intern[i]) == vpiNetArray) {
-		  /* We need to iterate on the words */
-		  vpiHandle word_i, word_h;
-		  word_i = vpi_iterate(vpiMemoryWord, ref->intern[i]);
-		  while (word_i && (word_h = vpi_scan(word_i))) {
-			nm = vpi_get_str(vpiName, word_h);
-			if (!strcmp(name, nm)) {
-			      rtn = word_h;
-			      vpi_free_object(word_i);
-			      break;
-			}
-		  }
-	    }
-	    /* found it yet? */
-	    if (rtn) break;
-      }
+	    return handle;
+
+      /* Look up the name in the index of the objects in this
+	 scope. The index does not include ports, because the
+	 standard says that since a port does not have a full name
+	 it cannot be found by name. */
+      vpiHandle rtn = vpip_find_by_name(ref, name, vpiScope);
+      if (rtn)
+	    return rtn;
 
-      return rtn;
+      return find_array_word(name, ref);
 }
 
 static vpiHandle find_scope(const char *name, vpiHandle handle, int depth)
 {
-
-      vpiHandle iter = handle==0
-	    ? vpi_iterate(vpiModule, NULL)
-	    : vpi_iterate(vpiInternalScope, handle);
+      __vpiScope*ref = 0;
+      if (handle) {
+	    ref = dynamic_cast<__vpiScope*>(handle);
+	    if (ref == 0)
+		  return 0;
+      }
 
       vector<char> name_buf (strlen(name)+1);
       strcpy(&name_buf[0], name);
@@ -1332,26 +1356,14 @@ static vpiHandle find_scope(const char *name, vpiHandle handle, int depth)
 	    *nm_rest++ = 0;
       }
 
-      vpiHandle rtn = 0;
-      vpiHandle hand;
-      while (iter && (hand = vpi_scan(iter))) {
-	    char *nm = vpi_get_str(vpiName, hand);
-
-	    if (strcmp(nm_first,nm)==0) {
-		  if (nm_rest)
-			rtn=find_scope(nm_rest, hand, depth+1);
-		  else
-			rtn = hand;
-	    }
-
-	    /* found it yet ? */
-	    if (rtn) {
-		  vpi_free_object(iter);
-		  break;
-	    }
-      }
+	/* All the root scopes are modules as far as the vpiModule
+	   iterator is concerned, so only filter the sub-scopes. */
+      vpiHandle hand = vpip_find_by_name(ref, nm_first,
+					 handle? vpiInternalScope : vpiScope);
+      if (hand && nm_rest)
+	    return find_scope(nm_rest, hand, depth+1);
 
-      return rtn;
+      return hand;
 }
 
 vpiHandle vpi_handle_by_name(const char *name, vpiHandle scope)
@@ -1634,3 +1646,57 @@ extern "C" void vpip_count_drivers(vpiHandle ref, unsigned idx,
       assert(rfp);
       rfp->node->count_drivers(idx, counts);
 }
+
+/*
+ * This routine gives dumpers direct access to the value of a vector
+ * signal, so that they do not need to have the value formatted into
+ * a string for every change.
+ */
+extern "C" int vpip_get_vec4_raw(vpiHandle ref, p_vpip_vec4_raw raw)
+{
+      struct __vpiSignal*rfp = dynamic_cast<__vpiSignal*>(ref);
+      if (rfp == 0 || rfp->node == 0) return 0;
+
+      vvp_wire_vec4*wire = dynamic_cast<vvp_wire_vec4*>(rfp->node->fil);
+      if (wire == 0) return 0;
+
+      const vvp_vector4_t*val = wire->raw_value();
+      if (val == 0) return 0;
+
+      raw->size = val->size();
+      raw->word_bits = 8*sizeof(unsigned long);
+      raw->aval = val->abits_words();
+      raw->bval = val->bbits_words();
+      raw->stamp = wire->change_stamp();
+      return 1;
+}
+
+/*
+ * These routines give $readmem and $writemem direct access to the
+ * words of a memory, so that loading a large memory does not need a
+ * handle and a vpi_put_value call for every word.
+ */
+extern "C" PLI_INT32 vpip_array_word_size(vpiHandle ref)
+{
+      struct __vpiArray*arr = dynamic_cast<__vpiArray*>(ref);
+      if (arr == 0) return 0;
+      return arr->bulk_word_size();
+}
+
+extern "C" int vpip_put_array_words(vpiHandle ref, PLI_INT32 index,
+                                    PLI_INT32 incr, PLI_UINT32 count,
+                                    const s_vpi_vecval*vals)
+{
+      struct __vpiArray*arr = dynamic_cast<__vpiArray*>(ref);
+      if (arr == 0) return 0;
+      return arr->put_words(index, incr, count, vals)? 1 : 0;
+}
+
+extern "C" int vpip_get_array_words(vpiHandle ref, PLI_INT32 index,
+                                    PLI_INT32 incr, PLI_UINT32 count,
+                                    s_vpi_vecval*vals)
+{
+      struct __vpiArray*arr = dynamic_cast<__vpiArray*>(ref);
+      if (arr == 0) return 0;
+      return arr->get_words(index, incr, count, vals)? 1 : 0;
+}
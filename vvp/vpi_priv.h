@@ -263,6 +263,8 @@ class __vpiScope : public __vpiHandle {
       struct __vpiScopedRealtime scoped_realtime;
 	/* Keep an array of internal scope items. */
       std::vector<class __vpiHandle*> intern;
+	/* Hash index of the intern items by name, made on demand. */
+      class vpip_name_index_s*name_index;
 	/* Set of types */
       std::map<std::string,class_type*> classes;
         /* Keep an array of items to be automatically allocated */
@@ -272,8 +274,18 @@ class __vpiScope : public __vpiHandle {
       vvp_context_t live_contexts;
         /* Keep a list of freed contexts. */
       vvp_context_t free_contexts;
-	/* Keep a list of threads in the scope. */
-      std::set<vthread_t> threads;
+        /* New contexts are carved out of larger blocks. */
+      void**context_blocks;
+      void**context_arena;
+      unsigned context_arena_left;
+      unsigned context_block_size;
+	/* Keep a list of threads in the scope. The threads are linked
+	   through their scope_next/scope_pprev members so that they can
+	   be removed from the list in constant time. */
+      vthread_t threads;
+	/* Keep a short list of retired threads for reuse. */
+      vthread_t free_threads;
+      unsigned free_thread_count;
       signed int time_units :8;
       signed int time_precision :8;
 
@@ -580,8 +592,8 @@ class __vpiStringVar : public __vpiBaseVar {
 extern vpiHandle vpip_make_string_var(const char*name, vvp_net_t*net);
 
 struct __vpiArrayBase {
-      __vpiArrayBase() : vals_words(NULL) {}
-      virtual ~__vpiArrayBase() {}
+      __vpiArrayBase() : word_table_(0), word_mask_(0), word_count_(0) {}
+      virtual ~__vpiArrayBase();
 
       virtual unsigned get_size(void) const = 0;
       virtual vpiHandle get_left_range() = 0;
@@ -600,9 +612,16 @@ struct __vpiArrayBase {
     // code in the following function
       vpiHandle vpi_array_base_iterate(int code);
 
-      virtual void make_vals_words();
+	// Get the handle for the variable word at the canonical
+	// index. The handle is made the first time it is needed.
+      vpiHandle word_handle(unsigned idx);
 
-      struct __vpiArrayWord*vals_words;
+    private:
+      void grow_word_table_();
+
+      struct __vpiArrayWord**word_table_;
+      unsigned word_mask_;
+      unsigned word_count_;
 };
 
 /*
@@ -660,6 +679,15 @@ struct __vpiArray : public __vpiArrayBase, public __vpiHandle {
       void get_word_obj(unsigned address, vvp_object_t&val);
       std::string get_word_str(unsigned address);
 
+	// Bulk access to a run of vector words, used by the
+	// vpip_*_array_words extensions. The values are in the
+	// vpiVectorVal encoding, (bulk_word_size()+31)/32 entries per
+	// word. bulk_word_size() returns 0 if the array words are not
+	// vectors held by the array itself.
+      unsigned bulk_word_size();
+      bool put_words(int index, int incr, unsigned count, const s_vpi_vecval*vals);
+      bool get_words(int index, int incr, unsigned count, s_vpi_vecval*vals);
+
       void alias_word(unsigned long addr, vpiHandle word, int msb, int lsb);
       void attach_word(unsigned addr, vpiHandle word);
       void word_change(unsigned long addr);
@@ -997,6 +1025,14 @@ extern char *generic_get_str(int code, vpiHandle ref, const char *name, const ch
 /* A routine to find the enclosing module. */
 extern vpiHandle vpip_module(__vpiScope*scope);
 
+/*
+ * Find the first item in the scope (or the first root scope if the
+ * scope is nil) with the given vpiName. The code selects the items
+ * the same way vpi_iterate does, and vpiScope selects all the
+ * items. Ports are never found, because they have no full name.
+ */
+extern vpiHandle vpip_find_by_name(__vpiScope*scope, const char*name, int code);
+
 extern int vpip_delay_selection;
 
 #endif /* IVL_vpi_priv_H */
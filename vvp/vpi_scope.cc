@@ -34,6 +34,10 @@
 using namespace std;
 
 static vector<vpiHandle> vpip_root_table;
+static class vpip_name_index_s*root_name_index = 0;
+#ifdef CHECK_WITH_VALGRIND
+static void name_index_delete(class vpip_name_index_s*index);
+#endif
 
 vpiHandle vpip_make_root_iterator(void)
 {
@@ -133,6 +137,8 @@ static void delete_sub_scopes(__vpiScope *scope)
 	    }
       }
       scope->intern.clear();
+      name_index_delete(scope->name_index);
+      scope->name_index = 0;
 
 	/* Save any class definitions to clean up later. */
       map<std::string, class_type*>::iterator citer;
@@ -155,6 +161,8 @@ void root_table_delete(void)
 	    delete scope;
       }
       vpip_root_table.clear();
+      name_index_delete(root_name_index);
+      root_name_index = 0;
 
 	/* Clean up all the class definitions. */
       for (unsigned idx = 0; idx < class_list_count; idx += 1) {
@@ -327,8 +335,117 @@ static vpiHandle module_iter(int code, vpiHandle obj)
 }
 
 
+/*
+ * The name index is an open addressed hash table of positions in a
+ * vector of items (the intern list of a scope, or the root table),
+ * keyed by the vpiName of the item. Items that share a name stay in
+ * the order of the vector along a probe run, so the first match is
+ * the same item that a scan of the vector would find. Items added to
+ * the vector after the index was made are indexed on the next
+ * lookup, and the table is remade in vector order when it grows.
+ */
+class vpip_name_index_s {
+
+    public:
+      explicit vpip_name_index_s(const vector<vpiHandle>&items);
+
+      vpiHandle find(const char*name, int code);
+
+    private:
+      void add_(unsigned pos);
+      void grow_(void);
+
+      const vector<vpiHandle>&items_;
+      unsigned indexed_;
+      unsigned count_;
+	// Each entry is a position in items_ plus one, or 0 if empty.
+      vector<unsigned> table_;
+      vector<unsigned> hash_;
+};
+
+vpip_name_index_s::vpip_name_index_s(const vector<vpiHandle>&items)
+: items_(items), indexed_(0), count_(0), table_(16, 0), hash_(16, 0)
+{
+}
+
+void vpip_name_index_s::add_(unsigned pos)
+{
+      vpiHandle item = items_[pos];
+      if (item->get_type_code() == vpiPort)
+	    return;
+
+      const char*nm = item->vpi_get_str(vpiName);
+      if (nm == 0)
+	    return;
+
+      unsigned mask = table_.size() - 1;
+      unsigned hash = symbol_hash(nm);
+      unsigned idx = hash & mask;
+      while (table_[idx])
+	    idx = (idx + 1) & mask;
+
+      table_[idx] = pos + 1;
+      hash_[idx] = hash;
+      count_ += 1;
+}
+
+void vpip_name_index_s::grow_(void)
+{
+      unsigned size = 2*table_.size();
+      table_.assign(size, 0);
+      hash_.assign(size, 0);
+      count_ = 0;
+      for (unsigned pos = 0 ;  pos < indexed_ ;  pos += 1)
+	    add_(pos);
+}
+
+vpiHandle vpip_name_index_s::find(const char*name, int code)
+{
+      while (indexed_ < items_.size()) {
+	    if (2*(count_+1) > table_.size())
+		  grow_();
+	    add_(indexed_);
+	    indexed_ += 1;
+      }
+
+      unsigned mask = table_.size() - 1;
+      unsigned hash = symbol_hash(name);
+      for (unsigned idx = hash & mask ; table_[idx] ; idx = (idx + 1) & mask) {
+	    if (hash_[idx] != hash)
+		  continue;
+	    vpiHandle item = items_[table_[idx]-1];
+	    if (! compare_types(code, item->get_type_code()))
+		  continue;
+	    if (strcmp(item->vpi_get_str(vpiName), name) == 0)
+		  return item;
+      }
+
+      return 0;
+}
+
+#ifdef CHECK_WITH_VALGRIND
+static void name_index_delete(vpip_name_index_s*index)
+{
+      delete index;
+}
+#endif
+
+vpiHandle vpip_find_by_name(__vpiScope*scope, const char*name, int code)
+{
+      if (scope == 0) {
+	    if (root_name_index == 0)
+		  root_name_index = new vpip_name_index_s(vpip_root_table);
+	    return root_name_index->find(name, code);
+      }
+
+      if (scope->name_index == 0)
+	    scope->name_index = new vpip_name_index_s(scope->intern);
+      return scope->name_index->find(name, code);
+}
+
 __vpiScope::__vpiScope(const char*nam, const char*tnam, bool auto_flag)
-: is_automatic_(auto_flag)
+: name_index(0), threads(0), free_threads(0), free_thread_count(0),
+  is_automatic_(auto_flag)
 {
       name_ = vpip_name_string(nam);
       tname_ = vpip_name_string(tnam? tnam : "");
@@ -544,6 +661,10 @@ compile_scope_decl(char*label, char*type, char*name, char*tname,
       scope->nitem = 0;
       scope->live_contexts = 0;
       scope->free_contexts = 0;
+      scope->context_blocks = 0;
+      scope->context_arena = 0;
+      scope->context_arena_left = 0;
+      scope->context_block_size = 0;
 
       if (is_cell) scope->is_cell = true;
       else scope->is_cell = false;
@@ -641,8 +762,8 @@ unsigned vpip_add_item_to_context(automatic_hooks_s*item,
 
       scope->item[idx] = item;
 
-        /* Offset the context index by 2 to leave space for the list links. */
-      return 2 + idx;
+        /* Offset the context index to leave space for the list links. */
+      return VVP_CONTEXT_LINKS + idx;
 }
 
 
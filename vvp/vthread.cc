@@ -28,6 +28,7 @@
 # include  "vvp_cobject.h"
 # include  "vvp_darray.h"
 # include  "class_type.h"
+# include  "statistics.h"
 #ifdef CHECK_WITH_VALGRIND
 # include  "vvp_cleanup.h"
 #endif
@@ -94,6 +95,19 @@ using namespace std;
  * to reap the child immediately.
  */
 
+/*
+ * Assigning a vector of new_wid bits to a vector of old_wid bits
+ * reuses the word array of the target if both are wider than a word
+ * and need the same number of words. The vec4 stack statistics count
+ * the pushes that saved an allocation this way.
+ */
+static inline bool vec4_storage_kept(unsigned old_wid, unsigned new_wid)
+{
+      const unsigned bpw = 8*sizeof(unsigned long);
+      return old_wid > bpw && new_wid > bpw
+	    && (old_wid+bpw-1)/bpw == (new_wid+bpw-1)/bpw;
+}
+
 struct vthread_s {
       vthread_s();
 
@@ -118,45 +132,73 @@ struct vthread_s {
       vector<unsigned> args_str;
       vector<unsigned> args_vec4;
 
+	/* The vec4 stack does not destroy the vectors that are popped
+	   from it. The slots above the top of the stack (up to the high
+	   water mark) keep their vvp_vector4_t objects, so that later
+	   pushes assign into them and reuse their word arrays instead
+	   of allocating new ones. stack_vec4_size_ is the actual depth
+	   of the stack. */
     private:
       vector<vvp_vector4_t>stack_vec4_;
+      unsigned stack_vec4_size_;
     public:
       inline vvp_vector4_t pop_vec4(void)
       {
-	    assert(! stack_vec4_.empty());
-	    vvp_vector4_t val = stack_vec4_.back();
-	    stack_vec4_.pop_back();
-	    return val;
+	    assert(stack_vec4_size_ > 0);
+	    stack_vec4_size_ -= 1;
+	    return stack_vec4_[stack_vec4_size_];
+      }
+	// Pop the top of the stack and return a reference to the
+	// popped value. The reference is only good until the next
+	// push, but this saves a copy of the value.
+      inline const vvp_vector4_t& pop_vec4_ref(void)
+      {
+	    assert(stack_vec4_size_ > 0);
+	    stack_vec4_size_ -= 1;
+	    return stack_vec4_[stack_vec4_size_];
+      }
+	// Push a slot onto the stack and return a reference to it. The
+	// caller must assign the complete value of the slot.
+      inline vvp_vector4_t& push_vec4_slot(void)
+      {
+	    if (stack_vec4_size_ == stack_vec4_.size())
+		  stack_vec4_.push_back(vvp_vector4_t());
+	    stack_vec4_size_ += 1;
+	    return stack_vec4_[stack_vec4_size_-1];
       }
       inline void push_vec4(const vvp_vector4_t&val)
       {
-	    stack_vec4_.push_back(val);
+	    if (stack_vec4_size_ < stack_vec4_.size()) {
+		  vvp_vector4_t&slot = stack_vec4_[stack_vec4_size_];
+		  if (vec4_storage_kept(slot.size(), val.size()))
+			count_vec4_stack_reuse += 1;
+		  slot = val;
+	    } else {
+		  stack_vec4_.push_back(val);
+	    }
+	    stack_vec4_size_ += 1;
       }
       inline const vvp_vector4_t& peek_vec4(unsigned depth)
       {
-	    unsigned size = stack_vec4_.size();
-	    assert(depth < size);
-	    unsigned use_index = size-1-depth;
+	    assert(depth < stack_vec4_size_);
+	    unsigned use_index = stack_vec4_size_-1-depth;
 	    return stack_vec4_[use_index];
       }
       inline vvp_vector4_t& peek_vec4(void)
       {
-	    unsigned use_index = stack_vec4_.size();
-	    assert(use_index >= 1);
-	    return stack_vec4_[use_index-1];
+	    assert(stack_vec4_size_ >= 1);
+	    return stack_vec4_[stack_vec4_size_-1];
       }
       inline void poke_vec4(unsigned depth, const vvp_vector4_t&val)
       {
-	    assert(depth < stack_vec4_.size());
-	    unsigned use_index = stack_vec4_.size()-1-depth;
+	    assert(depth < stack_vec4_size_);
+	    unsigned use_index = stack_vec4_size_-1-depth;
 	    stack_vec4_[use_index] = val;
       }
       inline void pop_vec4(unsigned cnt)
       {
-	    while (cnt > 0) {
-		  stack_vec4_.pop_back();
-		  cnt -= 1;
-	    }
+	    assert(cnt <= stack_vec4_size_);
+	    stack_vec4_size_ -= cnt;
       }
 
 
@@ -289,6 +331,10 @@ struct vthread_s {
       struct vthread_s*parent;
 	/* This points to the containing scope. */
       __vpiScope*parent_scope;
+	/* These link the thread into the thread list of its scope,
+	   or the free list of the scope if the thread is retired. */
+      struct vthread_s*scope_next;
+      struct vthread_s**scope_pprev;
 	/* This is used for keeping wait queues. */
       struct vthread_s*wait_next;
 	/* These are used to access automatically allocated items. */
@@ -300,12 +346,12 @@ struct vthread_s {
       inline void cleanup()
       {
 	    if (i_was_disabled) {
-		  stack_vec4_.clear();
+		  stack_vec4_size_ = 0;
 		  stack_real_.clear();
 		  stack_str_.clear();
 		  pop_object(stack_obj_size_);
 	    }
-	    assert(stack_vec4_.empty());
+	    assert(stack_vec4_size_ == 0);
 	    assert(stack_real_.empty());
 	    assert(stack_str_.empty());
 	    assert(stack_obj_size_ == 0);
@@ -314,7 +360,10 @@ struct vthread_s {
 
 inline vthread_s::vthread_s()
 {
+      stack_vec4_size_ = 0;
       stack_obj_size_ = 0;
+      scope_next = 0;
+      scope_pprev = 0;
 }
 
 void vthread_s::debug_dump(ostream&fd, const char*label)
@@ -327,8 +376,8 @@ void vthread_s::debug_dump(ostream&fd, const char*label)
 	    fd << flags[idx];
       fd << endl;
       fd << "**** vec4 stack..." << endl;
-      for (size_t idx = stack_vec4_.size() ; idx > 0 ; idx -= 1)
-	    fd << "    " << (stack_vec4_.size()-idx) << ": " << stack_vec4_[idx-1] << endl;
+      for (size_t idx = stack_vec4_size_ ; idx > 0 ; idx -= 1)
+	    fd << "    " << (stack_vec4_size_-idx) << ": " << stack_vec4_[idx-1] << endl;
       fd << "**** str stack (" << stack_str_.size() << ")..." << endl;
       fd << "**** obj stack (" << stack_obj_size_ << ")..." << endl;
       fd << "**** args_vec4 array (" << args_vec4.size() << ")..." << endl;
@@ -347,6 +396,17 @@ __vpiScope* vthread_scope(struct vthread_s*thr)
 
 struct vthread_s*running_thread = 0;
 
+bool vthread_profile_point(__vpiScope*&scope, vvp_code_t&pc)
+{
+      vthread_t thr = running_thread;
+      if (thr == 0)
+	    return false;
+
+      scope = thr->parent_scope;
+      pc = thr->pc;
+      return true;
+}
+
 
 void vthread_push_vec4(struct vthread_s*thr, const vvp_vector4_t&val)
 {
@@ -396,6 +456,30 @@ const vvp_vector4_t& vthread_get_vec4_stack(struct vthread_s*thr, unsigned depth
 /*
  * Some thread management functions
  */
+/*
+ * Get the queue object (if any) of the variable referenced by "net",
+ * and assign a newly created queue object to it.
+ */
+static vvp_queue*peek_queue_object(vvp_net_t*net)
+{
+      vvp_fun_signal_object*obj = dynamic_cast<vvp_fun_signal_object*> (net->fun);
+      assert(obj);
+
+      vvp_queue*dqueue = obj->get_object().peek<vvp_queue>();
+      if (dqueue == 0)
+	    assert(obj->get_object().test_nil());
+
+      return dqueue;
+}
+
+static vvp_queue*set_queue_object(vthread_t thr, vvp_net_t*net, vvp_queue*dqueue)
+{
+      vvp_object_t val (dqueue);
+      vvp_net_ptr_t ptr (net, 0);
+      vvp_send_object(ptr, val, thr->wt_context);
+      return dqueue;
+}
+
 /*
  * This is a function to get a vvp_queue handle from the variable
  * referenced by "net". If the queue is nil, then allocated it and
@@ -405,17 +489,23 @@ const vvp_vector4_t& vthread_get_vec4_stack(struct vthread_s*thr, unsigned depth
  */
 template <class VVP_QUEUE> static vvp_queue*get_queue_object(vthread_t thr, vvp_net_t*net)
 {
-      vvp_fun_signal_object*obj = dynamic_cast<vvp_fun_signal_object*> (net->fun);
-      assert(obj);
+      vvp_queue*dqueue = peek_queue_object(net);
+      if (dqueue == 0)
+	    dqueue = set_queue_object(thr, net, new VVP_QUEUE);
 
-      vvp_queue*dqueue = obj->get_object().peek<vvp_queue>();
-      if (dqueue == 0) {
-	    assert(obj->get_object().test_nil());
-	    dqueue = new VVP_QUEUE;
-	    vvp_object_t val (dqueue);
-	    vvp_net_ptr_t ptr (net, 0);
-	    vvp_send_object(ptr, val, thr->wt_context);
-      }
+      return dqueue;
+}
+
+/*
+ * The 2-state queues pack their items, so need the item width when
+ * they are created. The %store/qb/vec2 and %store/qf/vec2 instructions
+ * carry that width.
+ */
+static vvp_queue*get_queue_vec2(vthread_t thr, vvp_net_t*net, unsigned wid)
+{
+      vvp_queue*dqueue = peek_queue_object(net);
+      if (dqueue == 0)
+	    dqueue = set_queue_object(thr, net, new vvp_queue_vec2(wid));
 
       return dqueue;
 }
@@ -438,23 +528,37 @@ template vvp_vector4_t coerce_to_width(const vvp_vector4_t&that,
                                        unsigned width);
 
 
-static void multiply_array_imm(unsigned long*res, unsigned long*val,
-			       unsigned words, unsigned long imm)
+/*
+ * New contexts are taken from blocks that hold several contexts, so
+ * that deep recursion does not call malloc for each level. The first
+ * word of each block links the blocks of the scope together. The
+ * blocks start small and double in size, since most automatic scopes
+ * never have more than a few live contexts.
+ */
+static const unsigned CONTEXT_BLOCK_MIN = 4;
+static const unsigned CONTEXT_BLOCK_MAX = 256;
+
+static vvp_context_t vthread_carve_context(__vpiScope*scope)
 {
-      for (unsigned idx = 0 ; idx < words ; idx += 1)
-	    res[idx] = 0;
+      size_t words = vvp_context_size(scope->nitem) / sizeof(void*);
 
-      for (unsigned mul_idx = 0 ; mul_idx < words ; mul_idx += 1) {
-	    unsigned long sum;
-	    unsigned long tmp = multiply_with_carry(val[mul_idx], imm, sum);
+      if (scope->context_arena_left == 0) {
+	    unsigned count = scope->context_block_size * 2;
+	    if (count < CONTEXT_BLOCK_MIN) count = CONTEXT_BLOCK_MIN;
+	    if (count > CONTEXT_BLOCK_MAX) count = CONTEXT_BLOCK_MAX;
+	    scope->context_block_size = count;
 
-	    unsigned long carry = 0;
-	    res[mul_idx] = add_with_carry(res[mul_idx], tmp, carry);
-	    for (unsigned add_idx = mul_idx+1 ; add_idx < words ; add_idx += 1) {
-		  res[add_idx] = add_with_carry(res[add_idx], sum, carry);
-		  sum = 0;
-	    }
+	    void**block = (void**)malloc((1 + count*words) * sizeof(void*));
+	    block[0] = scope->context_blocks;
+	    scope->context_blocks = block;
+	    scope->context_arena = block + 1;
+	    scope->context_arena_left = count;
       }
+
+      vvp_context_t context = scope->context_arena;
+      scope->context_arena += words;
+      scope->context_arena_left -= 1;
+      return context;
 }
 
 /*
@@ -473,13 +577,16 @@ static vvp_context_t vthread_alloc_context(__vpiScope*scope)
                   scope->item[idx]->reset_instance(context);
             }
       } else {
-            context = vvp_allocate_context(scope->nitem);
+            context = vthread_carve_context(scope);
             for (unsigned idx = 0 ; idx < scope->nitem ; idx += 1) {
                   scope->item[idx]->alloc_instance(context);
             }
       }
 
       vvp_set_next_context(context, scope->live_contexts);
+      vvp_set_prev_context(context, 0);
+      if (scope->live_contexts)
+	    vvp_set_prev_context(scope->live_contexts, context);
       scope->live_contexts = context;
 
       return context;
@@ -495,16 +602,16 @@ static void vthread_free_context(vvp_context_t context, __vpiScope*scope)
       assert(scope->is_automatic());
       assert(context);
 
-      if (context == scope->live_contexts) {
-            scope->live_contexts = vvp_get_next_context(context);
+      vvp_context_t prev = vvp_get_prev_context(context);
+      vvp_context_t next = vvp_get_next_context(context);
+      if (prev) {
+	    vvp_set_next_context(prev, next);
       } else {
-            vvp_context_t tmp = scope->live_contexts;
-            while (context != vvp_get_next_context(tmp)) {
-                  assert(tmp);
-                  tmp = vvp_get_next_context(tmp);
-            }
-            vvp_set_next_context(tmp, vvp_get_next_context(context));
+	    assert(context == scope->live_contexts);
+	    scope->live_contexts = next;
       }
+      if (next)
+	    vvp_set_prev_context(next, prev);
 
       vvp_set_next_context(context, scope->free_contexts);
       scope->free_contexts = context;
@@ -520,19 +627,64 @@ void contexts_delete(struct __vpiScope*scope)
 	    for (unsigned idx = 0; idx < scope->nitem; idx += 1) {
 		  scope->item[idx]->free_instance(context);
 	    }
-	    free(context);
 	    context = scope->free_contexts;
       }
+      while (void**block = scope->context_blocks) {
+	    scope->context_blocks = (void**)block[0];
+	    free(block);
+      }
       free(scope->item);
 }
 #endif
 
+/*
+ * Threads are linked into the thread list of their scope so that
+ * %disable can find them. The list is doubly linked through the
+ * scope_pprev pointer, so unlinking a thread is constant time, and a
+ * nil scope_pprev marks a thread that is not in the list.
+ */
+static inline void scope_link_thread(__vpiScope*scope, vthread_t thr)
+{
+      thr->scope_next = scope->threads;
+      if (thr->scope_next)
+	    thr->scope_next->scope_pprev = &thr->scope_next;
+      thr->scope_pprev = &scope->threads;
+      scope->threads = thr;
+}
+
+static inline void scope_unlink_thread(vthread_t thr)
+{
+      if (thr->scope_pprev == 0)
+	    return;
+      *thr->scope_pprev = thr->scope_next;
+      if (thr->scope_next)
+	    thr->scope_next->scope_pprev = thr->scope_pprev;
+      thr->scope_next = 0;
+      thr->scope_pprev = 0;
+}
+
+/*
+ * Threads that end are kept in a short free list in their scope and
+ * reused by the next vthread_new for that scope. This saves the
+ * allocation of the thread and keeps the stacks it has already grown,
+ * which matters for functions and tasks that are called many times.
+ */
+static const unsigned VTHREAD_SCOPE_POOL_MAX = 32;
+
 /*
  * Create a new thread with the given start address.
  */
 vthread_t vthread_new(vvp_code_t pc, __vpiScope*scope)
 {
-      vthread_t thr = new struct vthread_s;
+      vthread_t thr = scope->free_threads;
+      if (thr) {
+	    scope->free_threads = thr->scope_next;
+	    scope->free_thread_count -= 1;
+	    count_thread_reuse += 1;
+      } else {
+	    thr = new struct vthread_s;
+	    count_thread_alloc += 1;
+      }
       thr->pc     = pc;
 	//thr->bits4  = vvp_vector4_t(32);
       thr->parent = 0;
@@ -560,7 +712,7 @@ vthread_t vthread_new(vvp_code_t pc, __vpiScope*scope)
       for (int idx = 4 ; idx < 8 ; idx += 1)
 	    thr->flags[idx] = BIT4_X;
 
-      scope->threads .insert(thr);
+      scope_link_thread(scope, thr);
       return thr;
 }
 
@@ -594,11 +746,15 @@ static void child_delete(vthread_t base)
 
 void vthreads_delete(struct __vpiScope*scope)
 {
-      for (std::set<vthread_t>::iterator cur = scope->threads.begin()
-		 ; cur != scope->threads.end() ; ++ cur ) {
-	    delete *cur;
+      while (vthread_t thr = scope->threads) {
+	    scope->threads = thr->scope_next;
+	    delete thr;
+      }
+      while (vthread_t thr = scope->free_threads) {
+	    scope->free_threads = thr->scope_next;
+	    delete thr;
       }
-      scope->threads.clear();
+      scope->free_thread_count = 0;
 }
 #endif
 
@@ -642,7 +798,7 @@ static void vthread_reap(vthread_t thr)
       thr->parent = 0;
 
 	// Remove myself from the containing scope if needed.
-      thr->parent_scope->threads.erase(thr);
+      scope_unlink_thread(thr);
 
       thr->pc = codespace_null();
 
@@ -662,7 +818,26 @@ static void vthread_reap(vthread_t thr)
 void vthread_delete(vthread_t thr)
 {
       thr->cleanup();
-      delete thr;
+
+      __vpiScope*scope = thr->parent_scope;
+      scope_unlink_thread(thr);
+      if (scope->free_thread_count >= VTHREAD_SCOPE_POOL_MAX) {
+	    delete thr;
+	    return;
+      }
+
+	/* Clear what the next user of the thread does not set. The
+	   stacks are already empty, but keep their storage. */
+      thr->children.clear();
+      thr->detached_children.clear();
+      thr->task_func_children.clear();
+      thr->args_real.clear();
+      thr->args_str.clear();
+      thr->args_vec4.clear();
+
+      thr->scope_next = scope->free_threads;
+      scope->free_threads = thr;
+      scope->free_thread_count += 1;
 }
 
 void vthread_mark_scheduled(vthread_t thr)
@@ -681,9 +856,195 @@ void vthread_delay_delete()
 }
 
 /*
- * This function runs each thread by fetching an instruction,
- * incrementing the PC, and executing the instruction. The thread may
- * be the head of a list, so each thread is run so far as possible.
+ * The threaded engine needs the GNU "labels as values" extension to
+ * build its dispatch table. Without it, only the call engine is
+ * available.
+ */
+#if defined(__GNUC__)
+# define VTHREAD_THREADED_ENGINE 1
+#endif
+
+static bool vthread_threaded_engine = false;
+
+bool vthread_set_engine(const char*name)
+{
+      if (strcmp(name, "call") == 0) {
+	    vthread_threaded_engine = false;
+	    return true;
+      }
+#ifdef VTHREAD_THREADED_ENGINE
+      if (strcmp(name, "threaded") == 0) {
+	    vthread_threaded_engine = true;
+	    return true;
+      }
+#endif
+      return false;
+}
+
+/*
+ * These are the dispatch codes that the threaded engine implements
+ * inline. Any instruction with another opcode keeps DISPATCH_CALL,
+ * which calls the opcode function.
+ */
+enum vthread_dispatch_e {
+      DISPATCH_CALL = 0,
+      DISPATCH_CHUNK_LINK,
+      DISPATCH_NOOP,
+      DISPATCH_JMP,
+      DISPATCH_JMP0,
+      DISPATCH_JMP0XZ,
+      DISPATCH_JMP1,
+      DISPATCH_JMP1XZ,
+      DISPATCH_FLAG_INV,
+      DISPATCH_FLAG_MOV,
+      DISPATCH_FLAG_OR,
+      DISPATCH_IX_MOV,
+      DISPATCH_COUNT
+};
+
+void vthread_predecode(vvp_code_t code)
+{
+      vvp_code_fun op = code->opcode;
+
+      if (op == &of_CHUNK_LINK)  code->dispatch = DISPATCH_CHUNK_LINK;
+      else if (op == &of_NOOP)   code->dispatch = DISPATCH_NOOP;
+      else if (op == &of_JMP)    code->dispatch = DISPATCH_JMP;
+      else if (op == &of_JMP0)   code->dispatch = DISPATCH_JMP0;
+      else if (op == &of_JMP0XZ) code->dispatch = DISPATCH_JMP0XZ;
+      else if (op == &of_JMP1)   code->dispatch = DISPATCH_JMP1;
+      else if (op == &of_JMP1XZ) code->dispatch = DISPATCH_JMP1XZ;
+      else if (op == &of_FLAG_INV) code->dispatch = DISPATCH_FLAG_INV;
+      else if (op == &of_FLAG_MOV) code->dispatch = DISPATCH_FLAG_MOV;
+      else if (op == &of_FLAG_OR)  code->dispatch = DISPATCH_FLAG_OR;
+      else if (op == &of_IX_MOV)   code->dispatch = DISPATCH_IX_MOV;
+      else code->dispatch = DISPATCH_CALL;
+}
+
+/*
+ * This is the call engine. It runs the thread by fetching an
+ * instruction, incrementing the PC, and calling the opcode function.
+ */
+static void vthread_run_call_(vthread_t thr)
+{
+      for (;;) {
+	    vvp_code_t cp = thr->pc;
+	    thr->pc += 1;
+
+	      /* Run the opcode implementation. If the execution of
+		 the opcode returns false, then the thread is meant to
+		 be paused, so break out of the loop. */
+	    bool rc = (cp->opcode)(thr, cp);
+	    if (rc == false)
+		  break;
+      }
+}
+
+#ifdef VTHREAD_THREADED_ENGINE
+/*
+ * This is the threaded engine. Each inline implementation ends by
+ * fetching the next instruction and jumping straight to the code for
+ * its dispatch code, so control flow and flag opcodes cost no call
+ * and no return test. The inline implementations must behave exactly
+ * like the opcode functions they replace.
+ */
+static void vthread_run_threaded_(vthread_t thr)
+{
+      static void* const dispatch_table[DISPATCH_COUNT] = {
+	    &&do_call,
+	    &&do_chunk_link,
+	    &&do_noop,
+	    &&do_jmp,
+	    &&do_jmp0,
+	    &&do_jmp0xz,
+	    &&do_jmp1,
+	    &&do_jmp1xz,
+	    &&do_flag_inv,
+	    &&do_flag_mov,
+	    &&do_flag_or,
+	    &&do_ix_mov
+      };
+
+      vvp_code_t cp;
+
+# define VTHREAD_DISPATCH() do { \
+	    cp = thr->pc; \
+	    thr->pc = cp + 1; \
+	    goto *dispatch_table[cp->dispatch]; \
+      } while (0)
+
+      VTHREAD_DISPATCH();
+
+ do_call:
+      if ((cp->opcode)(thr, cp))
+	    VTHREAD_DISPATCH();
+      return;
+
+ do_chunk_link:
+      assert(cp->cptr);
+      thr->pc = cp->cptr;
+      VTHREAD_DISPATCH();
+
+ do_noop:
+      VTHREAD_DISPATCH();
+
+ do_jmp:
+      thr->pc = cp->cptr;
+      goto jmp_done;
+
+ do_jmp0:
+      if (thr->flags[cp->bit_idx[0]] == BIT4_0)
+	    thr->pc = cp->cptr;
+      goto jmp_done;
+
+ do_jmp0xz:
+      if (thr->flags[cp->bit_idx[0]] != BIT4_1)
+	    thr->pc = cp->cptr;
+      goto jmp_done;
+
+ do_jmp1:
+      if (thr->flags[cp->bit_idx[0]] == BIT4_1)
+	    thr->pc = cp->cptr;
+      goto jmp_done;
+
+ do_jmp1xz:
+      if (thr->flags[cp->bit_idx[0]] != BIT4_0)
+	    thr->pc = cp->cptr;
+      goto jmp_done;
+
+	/* The jump instructions break out of the thread if there was
+	   a $stop or vpiStop. See of_JMP. */
+ jmp_done:
+      if (schedule_stopped()) {
+	    schedule_vthread(thr, 0, false);
+	    return;
+      }
+      VTHREAD_DISPATCH();
+
+ do_flag_inv:
+      thr->flags[cp->bit_idx[0]] = ~ thr->flags[cp->bit_idx[0]];
+      VTHREAD_DISPATCH();
+
+ do_flag_mov:
+      thr->flags[cp->bit_idx[0]] = thr->flags[cp->bit_idx[1]];
+      VTHREAD_DISPATCH();
+
+ do_flag_or:
+      thr->flags[cp->bit_idx[0]] = thr->flags[cp->bit_idx[0]]
+	                         | thr->flags[cp->bit_idx[1]];
+      VTHREAD_DISPATCH();
+
+ do_ix_mov:
+      thr->words[cp->bit_idx[0]].w_int = thr->words[cp->bit_idx[1]].w_int;
+      VTHREAD_DISPATCH();
+
+# undef VTHREAD_DISPATCH
+}
+#endif
+
+/*
+ * This function runs each thread until it is put to sleep, using the
+ * selected execution engine. The thread may be the head of a list,
+ * so each thread is run so far as possible.
  */
 void vthread_run(vthread_t thr)
 {
@@ -696,17 +1057,14 @@ void vthread_run(vthread_t thr)
 
             running_thread = thr;
 
-	    for (;;) {
-		  vvp_code_t cp = thr->pc;
-		  thr->pc += 1;
-
-		    /* Run the opcode implementation. If the execution of
-		       the opcode returns false, then the thread is meant to
-		       be paused, so break out of the loop. */
-		  bool rc = (cp->opcode)(thr, cp);
-		  if (rc == false)
-			break;
-	    }
+#ifdef VTHREAD_THREADED_ENGINE
+	    if (vthread_threaded_engine)
+		  vthread_run_threaded_(thr);
+	    else
+		  vthread_run_call_(thr);
+#else
+	    vthread_run_call_(thr);
+#endif
 
 	    thr = tmp;
       }
@@ -790,7 +1148,7 @@ bool of_ALLOC(vthread_t thr, vvp_code_t cp)
 
 bool of_AND(vthread_t thr, vvp_code_t)
 {
-      vvp_vector4_t valb = thr->pop_vec4();
+      const vvp_vector4_t&valb = thr->pop_vec4_ref();
       vvp_vector4_t&vala = thr->peek_vec4();
       assert(vala.size() == valb.size());
       vala &= valb;
@@ -859,7 +1217,7 @@ static void get_immediate_rval(vvp_code_t cp, vvp_vector4_t&val)
  */
 bool of_ADD(vthread_t thr, vvp_code_t)
 {
-      vvp_vector4_t r = thr->pop_vec4();
+      const vvp_vector4_t&r = thr->pop_vec4_ref();
 	// Rather then pop l, use it directly from the stack. When we
 	// assign to 'l', that will edit the top of the stack, which
 	// replaces a pop and a pull.
@@ -2366,7 +2724,7 @@ static bool do_disable(vthread_t thr, vthread_t match)
       bool flag = false;
 
 	/* Pull the target thread out of its scope if needed. */
-      thr->parent_scope->threads.erase(thr);
+      scope_unlink_thread(thr);
 
 	/* Turn the thread off by setting is program counter to
 	   zero and setting an OFF bit. */
@@ -2426,10 +2784,8 @@ bool of_DISABLE(vthread_t thr, vvp_code_t cp)
 
       bool disabled_myself_flag = false;
 
-      while (! scope->threads.empty()) {
-	    set<vthread_t>::iterator cur = scope->threads.begin();
-
-	    if (do_disable(*cur, thr))
+      while (scope->threads) {
+	    if (do_disable(scope->threads, thr))
 		  disabled_myself_flag = true;
       }
 
@@ -2463,134 +2819,6 @@ bool of_DISABLE_FORK(vthread_t thr, vvp_code_t)
       return true;
 }
 
-/*
- * This function divides a 2-word number {high, a} by a 1-word
- * number. Assume that high < b.
- */
-static unsigned long divide2words(unsigned long a, unsigned long b,
-				  unsigned long high)
-{
-      unsigned long result = 0;
-      while (high > 0) {
-	    unsigned long tmp_result = ULONG_MAX / b;
-	    unsigned long remain = ULONG_MAX % b;
-
-	    remain += 1;
-	    if (remain >= b) {
-		  remain -= b;
-		  tmp_result += 1;
-	    }
-
-	      // Now 0x1_0...0 = b*tmp_result + remain
-	      // high*0x1_0...0 = high*(b*tmp_result + remain)
-	      // high*0x1_0...0 = high*b*tmp_result + high*remain
-
-	      // We know that high*0x1_0...0 >= high*b*tmp_result, and
-	      // we know that high*0x1_0...0 > high*remain. Use
-	      // high*remain as the remainder for another iteration,
-	      // and add tmp_result*high into the current estimate of
-	      // the result.
-	    result += tmp_result * high;
-
-	      // The new iteration starts with high*remain + a.
-	    remain = multiply_with_carry(high, remain, high);
-	    a += remain;
-            if(a < remain)
-              high += 1;
-
-	      // Now result*b + {high,a} == the input {high,a}. It is
-	      // possible that the new high >= 1. If so, it will
-	      // certainly be less than high from the previous
-	      // iteration. Do another iteration and it will shrink,
-	      // eventually to 0.
-      }
-
-	// high is now 0, so a is the remaining remainder, so we can
-	// finish off the integer divide with a simple a/b.
-
-      return result + a/b;
-}
-
-static unsigned long* divide_bits(unsigned long*ap, unsigned long*bp, unsigned wid)
-{
-	// Do all our work a cpu-word at a time. The "words" variable
-	// is the number of words of the wid.
-      unsigned words = (wid+CPU_WORD_BITS-1) / CPU_WORD_BITS;
-
-      unsigned btop = words-1;
-      while (btop > 0 && bp[btop] == 0)
-	    btop -= 1;
-
-	// Detect divide by 0, and exit.
-      if (btop==0 && bp[0]==0)
-	    return 0;
-
-	// The result array will eventually accumulate the result. The
-	// diff array is a difference that we use in the intermediate.
-      unsigned long*diff  = new unsigned long[words];
-      unsigned long*result= new unsigned long[words];
-      for (unsigned idx = 0 ; idx < words ; idx += 1)
-	    result[idx] = 0;
-
-      for (unsigned cur = words-btop ; cur > 0 ; cur -= 1) {
-	    unsigned cur_ptr = cur-1;
-	    unsigned long cur_res;
-	    if (ap[cur_ptr+btop] >= bp[btop]) {
-		  unsigned long high = 0;
-		  if (cur_ptr+btop+1 < words)
-			high = ap[cur_ptr+btop+1];
-		  cur_res = divide2words(ap[cur_ptr+btop], bp[btop], high);
-
-	    } else if (cur_ptr+btop+1 >= words) {
-		  continue;
-
-	    } else if (ap[cur_ptr+btop+1] == 0) {
-		  continue;
-
-	    } else {
-		  cur_res = divide2words(ap[cur_ptr+btop], bp[btop],
-					 ap[cur_ptr+btop+1]);
-	    }
-
-	      // cur_res is a guesstimate of the result this far. It
-	      // may be 1 too big. (But it will also be >0) Try it,
-	      // and if the difference comes out negative, then adjust.
-
-	      // diff = (bp * cur_res)  << cur_ptr;
-	    multiply_array_imm(diff+cur_ptr, bp, words-cur_ptr, cur_res);
-	      // ap -= diff
-	    unsigned long carry = 1;
-	    for (unsigned idx = cur_ptr ; idx < words ; idx += 1)
-		  ap[idx] = add_with_carry(ap[idx], ~diff[idx], carry);
-
-	      // ap has the diff subtracted out of it. If cur_res was
-	      // too large, then ap will turn negative. (We easily
-	      // tell that ap turned negative by looking at
-	      // carry&1. If it is 0, then it is *negative*.) In that
-	      // case, we know that cur_res was too large by 1. Correct by
-	      // adding 1b back in and reducing cur_res.
-	    if ((carry&1) == 0) {
-		    // Keep adding b back in until the remainder
-		    // becomes positive again.
-		  do {
-			cur_res -= 1;
-			carry = 0;
-			for (unsigned idx = cur_ptr ; idx < words ; idx += 1)
-			      ap[idx] = add_with_carry(ap[idx], bp[idx-cur_ptr], carry);
-		  } while (carry == 0);
-	    }
-
-	    result[cur_ptr] = cur_res;
-      }
-
-	// Now ap contains the remainder and result contains the
-	// desired result. We should find that:
-	//  input-a = bp * result + ap;
-
-      delete[]diff;
-      return result;
-}
-
 /*
  * %div
  */
@@ -2632,8 +2860,7 @@ bool of_DIV(vthread_t thr, vvp_code_t)
 	    return true;
       }
 
-      unsigned long*result = divide_bits(ap, bp, wid);
-      if (result == 0) {
+      if (! vvp_words_divmod(ap, 0, ap, bp, wid)) {
 	    delete[]ap;
 	    delete[]bp;
 	    vvp_vector4_t tmp(wid, BIT4_X);
@@ -2641,15 +2868,10 @@ bool of_DIV(vthread_t thr, vvp_code_t)
 	    return true;
       }
 
-	// Now ap contains the remainder and result contains the
-	// desired result. We should find that:
-	//  input-a = bp * result + ap;
-
-      vala.setarray(0, wid, result);
+      vala.setarray(0, wid, ap);
       thr->push_vec4(vala);
       delete[]ap;
       delete[]bp;
-      delete[]result;
 
       return true;
 }
@@ -2735,8 +2957,7 @@ bool of_DIV_S(vthread_t thr, vvp_code_t)
 	    negate_words(bp, words);
       }
 
-      unsigned long*result = divide_bits(ap, bp, wid);
-      if (result == 0) {
+      if (! vvp_words_divmod(ap, 0, ap, bp, wid)) {
 	    delete[]ap;
 	    delete[]bp;
 	    vvp_vector4_t tmp(wid, BIT4_X);
@@ -2745,15 +2966,14 @@ bool of_DIV_S(vthread_t thr, vvp_code_t)
       }
 
       if (negate_flag) {
-	    negate_words(result, words);
+	    negate_words(ap, words);
       }
 
-      result[words-1] &= ~sign_mask;
+      ap[words-1] &= ~sign_mask;
 
-      vala.setarray(0, wid, result);
+      vala.setarray(0, wid, ap);
       delete[]ap;
       delete[]bp;
-      delete[]result;
       return true;
 }
 
@@ -3728,19 +3948,8 @@ bool of_LOAD_STRA(vthread_t thr, vvp_code_t cp)
 }
 
 
-/*
- * %load/vec4 <net>
- */
-bool of_LOAD_VEC4(vthread_t thr, vvp_code_t cp)
+static void load_vec4_value(vvp_net_t*net, vvp_vector4_t&sig_value)
 {
-	// Push a placeholder onto the stack in order to reserve the
-	// stack space. Use a reference for the stack top as a target
-	// for the load.
-      thr->push_vec4(vvp_vector4_t());
-      vvp_vector4_t&sig_value = thr->peek_vec4();
-
-      vvp_net_t*net = cp->net;
-
 	// For the %load to work, the functor must actually be a
 	// signal functor. Only signals save their vector value.
       vvp_signal_value*sig = dynamic_cast<vvp_signal_value*> (net->fil);
@@ -3750,13 +3959,76 @@ bool of_LOAD_VEC4(vthread_t thr, vvp_code_t cp)
 	    assert(sig);
       }
 
+      sig->vec4_value(sig_value);
+}
+
+/*
+ * %load/vec4 <net>
+ */
+bool of_LOAD_VEC4(vthread_t thr, vvp_code_t cp)
+{
+	// Push a slot onto the stack in order to reserve the stack
+	// space. Use a reference for the stack top as a target for
+	// the load.
+      vvp_vector4_t&sig_value = thr->push_vec4_slot();
+      unsigned old_wid = sig_value.size();
+
 	// Extract the value from the signal and directly into the
 	// target stack position.
-      sig->vec4_value(sig_value);
+      load_vec4_value(cp->net, sig_value);
+      if (vec4_storage_kept(old_wid, sig_value.size()))
+	    count_vec4_stack_reuse += 1;
 
       return true;
 }
 
+/*
+ * %load/vec4 <net>
+ * %cmpi/e <vala>, <valb>, <wid>
+ * %jmp/0xz <pc>, <flag>
+ *
+ * This fused instruction does the work of the above sequence without
+ * pushing the loaded value onto the vec4 stack. The operands of the
+ * %cmpi/e and %jmp/0xz are taken from the (unchanged) instructions
+ * that follow this one.
+ */
+bool of_LOAD_CMPIE_JMP0XZ(vthread_t thr, vvp_code_t cp)
+{
+      vvp_vector4_t lval;
+      load_vec4_value(cp->net, lval);
+
+      vvp_vector4_t rval (cp[1].number, BIT4_0);
+      get_immediate_rval (cp+1, rval);
+
+      do_CMPE(thr, lval, rval);
+
+      thr->pc = cp + 3;
+      return of_JMP0XZ(thr, cp+2);
+}
+
+/*
+ * %load/vec4 <net>
+ * %pushi/vec4 <vala>, <valb>, <wid>
+ * %cmp/e
+ * %jmp/0xz <pc>, <flag>
+ *
+ * This is the same as of_LOAD_CMPIE_JMP0XZ, but for the sequence
+ * where the immediate value is pushed separately.
+ */
+bool of_LOAD_PUSHI_CMPE_JMP0XZ(vthread_t thr, vvp_code_t cp)
+{
+      vvp_vector4_t lval;
+      load_vec4_value(cp->net, lval);
+
+      vvp_vector4_t rval (cp[1].number, BIT4_0);
+      get_immediate_rval (cp+1, rval);
+
+      do_CMPE(thr, lval, rval);
+
+      thr->pc = cp + 4;
+      return of_JMP0XZ(thr, cp+3);
+}
+
 /*
  * %load/vec4a <arr>, <adrx>
  */
@@ -3783,117 +4055,34 @@ bool of_LOAD_VEC4A(vthread_t thr, vvp_code_t cp)
 static void do_verylong_mod(vvp_vector4_t&vala, const vvp_vector4_t&valb,
 			    bool left_is_neg, bool right_is_neg)
 {
-      bool out_is_neg = left_is_neg;
-      const int len=vala.size();
-      unsigned char *a, *z, *t;
-      a = new unsigned char[len+1];
-      z = new unsigned char[len+1];
-      t = new unsigned char[len+1];
-
-      unsigned char carry;
-      unsigned char temp;
-
-      int mxa = -1, mxz = -1;
-      int i;
-      int current, copylen;
-
-      unsigned lb_carry = left_is_neg? 1 : 0;
-      unsigned rb_carry = right_is_neg? 1 : 0;
-      for (int idx = 0 ;  idx < len ;  idx += 1) {
-	    unsigned lb = vala.value(idx);
-	    unsigned rb = valb.value(idx);
-
-	    if ((lb | rb) & 2) {
-		  delete []t;
-		  delete []z;
-		  delete []a;
-		  vvp_vector4_t tmp(len, BIT4_X);
-		  vala = tmp;
-		  return;
-	    }
-
-	    if (left_is_neg) {
-		  lb = (1-lb) + lb_carry;
-		  lb_carry = (lb & ~1)? 1 : 0;
-		  lb &= 1;
-	    }
-	    if (right_is_neg) {
-		  rb = (1-rb) + rb_carry;
-		  rb_carry = (rb & ~1)? 1 : 0;
-		  rb &= 1;
-	    }
-
-	    z[idx]=lb;
-	    a[idx]=1-rb;	// for 2s complement add..
-      }
-
-      z[len]=0;
-      a[len]=1;
-
-      for(i=len-1;i>=0;i--) {
-	    if(! a[i]) {
-		  mxa=i;
-		  break;
-	    }
-      }
-
-      for(i=len-1;i>=0;i--) {
-	    if(z[i]) {
-		  mxz=i;
-		  break;
-	    }
-      }
-
-      if((mxa>mxz)||(mxa==-1)) {
-	    if(mxa==-1) {
-		  delete []t;
-		  delete []z;
-		  delete []a;
-		  vvp_vector4_t tmpx (len, BIT4_X);
-		  vala = tmpx;
-		  return;
-	    }
+      unsigned wid = vala.size();
+      unsigned words = (wid + CPU_WORD_BITS - 1) / CPU_WORD_BITS;
 
-	    goto tally;
+      unsigned long*ap = vala.subarray(0, wid);
+      unsigned long*bp = ap? valb.subarray(0, wid) : 0;
+      if (bp == 0) {
+	    delete[]ap;
+	    vala = vvp_vector4_t(wid, BIT4_X);
+	    return;
       }
 
-      copylen = mxa + 2;
-      current = mxz - mxa;
-
-      while(current > -1) {
-	    carry = 1;
-	    for(i=0;i<copylen;i++) {
-		  temp = z[i+current] + a[i] + carry;
-		  t[i] = (temp&1);
-		  carry = (temp>>1);
-	    }
-
-	    if(carry) {
-		  for(i=0;i<copylen;i++) {
-			z[i+current] = t[i];
-		  }
-	    }
+	// Take the remainder of the magnitudes. The result has the
+	// sign of the dividend.
+      if (left_is_neg)
+	    negate_words(ap, words);
+      if (right_is_neg)
+	    negate_words(bp, words);
 
-	    current--;
+      if (vvp_words_divmod(0, ap, ap, bp, wid)) {
+	    if (left_is_neg)
+		  negate_words(ap, words);
+	    vala.setarray(0, wid, ap);
+      } else {
+	    vala = vvp_vector4_t(wid, BIT4_X);
       }
 
- tally:
-
-      vvp_vector4_t tmp (len, BIT4_X);
-      carry = out_is_neg? 1 : 0;
-      for (int idx = 0 ;  idx < len ;  idx += 1) {
-	    unsigned ob = z[idx];
-	    if (out_is_neg) {
-		  ob = (1-ob) + carry;
-		  carry = (ob & ~1)? 1 : 0;
-		  ob = ob & 1;
-	    }
-	    tmp.set_bit(idx, ob?BIT4_1:BIT4_0);
-      }
-      vala = tmp;
-      delete []t;
-      delete []z;
-      delete []a;
+      delete[]ap;
+      delete[]bp;
 }
 
 bool of_MAX_WR(vthread_t thr, vvp_code_t)
@@ -4220,7 +4409,7 @@ bool of_MOV_WU(vthread_t thr, vvp_code_t cp)
  */
 bool of_MUL(vthread_t thr, vvp_code_t)
 {
-      vvp_vector4_t r = thr->pop_vec4();
+      const vvp_vector4_t&r = thr->pop_vec4_ref();
 	// Rather then pop l, use it directly from the stack. When we
 	// assign to 'l', that will edit the top of the stack, which
 	// replaces a pop and a pull.
@@ -4263,7 +4452,7 @@ bool of_MUL_WR(vthread_t thr, vvp_code_t)
 
 bool of_NAND(vthread_t thr, vvp_code_t)
 {
-      vvp_vector4_t valr = thr->pop_vec4();
+      const vvp_vector4_t&valr = thr->pop_vec4_ref();
       vvp_vector4_t&vall = thr->peek_vec4();
       assert(vall.size() == valr.size());
       unsigned wid = vall.size();
@@ -4515,7 +4704,7 @@ bool of_XNORR(vthread_t thr, vvp_code_t)
  */
 bool of_OR(vthread_t thr, vvp_code_t)
 {
-      vvp_vector4_t valb = thr->pop_vec4();
+      const vvp_vector4_t&valb = thr->pop_vec4_ref();
       vvp_vector4_t&vala = thr->peek_vec4();
       vala |= valb;
       return true;
@@ -4526,7 +4715,7 @@ bool of_OR(vthread_t thr, vvp_code_t)
  */
 bool of_NOR(vthread_t thr, vvp_code_t)
 {
-      vvp_vector4_t valr = thr->pop_vec4();
+      const vvp_vector4_t&valr = thr->pop_vec4_ref();
       vvp_vector4_t&vall = thr->peek_vec4();
       assert(vall.size() == valr.size());
       unsigned wid = vall.size();
@@ -4952,6 +5141,27 @@ bool of_QPOP_B_STR(vthread_t thr, vvp_code_t cp)
       return true;
 }
 
+/*
+ * %qpop/b/obj <var-label>
+ */
+bool of_QPOP_B_OBJ(vthread_t thr, vvp_code_t cp)
+{
+      vvp_net_t*net = cp->net;
+
+      vvp_queue*dqueue = get_queue_object<vvp_queue_object>(thr, net);
+      assert(dqueue);
+
+      size_t size = dqueue->get_size();
+      assert(size > 0);
+
+      vvp_object_t value;
+      dqueue->get_word(size-1, value);
+      dqueue->pop_back();
+
+      thr->push_object(value);
+      return true;
+}
+
 /*
  * %qpop/b/v <var-label>
  */
@@ -4988,6 +5198,27 @@ bool of_QPOP_F_STR(vthread_t thr, vvp_code_t cp)
       return true;
 }
 
+/*
+ * %qpop/f/obj <var-label>
+ */
+bool of_QPOP_F_OBJ(vthread_t thr, vvp_code_t cp)
+{
+      vvp_net_t*net = cp->net;
+
+      vvp_queue*dqueue = get_queue_object<vvp_queue_object>(thr, net);
+      assert(dqueue);
+
+      size_t size = dqueue->get_size();
+      assert(size > 0);
+
+      vvp_object_t value;
+      dqueue->get_word(0, value);
+      dqueue->pop_front();
+
+      thr->push_object(value);
+      return true;
+}
+
 /*
  * %qpop/f/v <var-label>
  */
@@ -5657,12 +5888,36 @@ bool of_STORE_PROP_V(vthread_t thr, vvp_code_t cp)
       return true;
 }
 
+/*
+ * %store/qb/obj <var-label>
+ */
+bool of_STORE_QB_OBJ(vthread_t thr, vvp_code_t cp)
+{
+	// Pop the object to be stored...
+      vvp_object_t value;
+      thr->pop_object(value);
+
+      vvp_net_t*net = cp->net;
+      vvp_queue*dqueue = get_queue_object<vvp_queue_object>(thr, net);
+
+      assert(dqueue);
+      dqueue->push_back(value);
+      return true;
+}
+
 /*
  * %store/qb/r <var-label>
  */
-bool of_STORE_QB_R(vthread_t, vvp_code_t)
+bool of_STORE_QB_R(vthread_t thr, vvp_code_t cp)
 {
-      fprintf(stderr, "XXXX %%store/qb/r NOT IMPLEMENTED\n");
+	// Pop the real value to be stored...
+      double value = thr->pop_real();
+
+      vvp_net_t*net = cp->net;
+      vvp_queue*dqueue = get_queue_object<vvp_queue_real>(thr, net);
+
+      assert(dqueue);
+      dqueue->push_back(value);
       return true;
 }
 
@@ -5702,22 +5957,73 @@ bool of_STORE_QB_V(vthread_t thr, vvp_code_t cp)
       return true;
 }
 
+/*
+ * %store/qb/vec2 <var-label>, <wid>
+ */
+bool of_STORE_QB_VEC2(vthread_t thr, vvp_code_t cp)
+{
+	// Pop the vec4 value to be stored...
+      vvp_vector4_t value = thr->pop_vec4();
+
+      vvp_net_t*net = cp->net;
+      unsigned wid = cp->bit_idx[0];
+
+      assert(value.size() == wid);
+
+      vvp_queue*dqueue = get_queue_vec2(thr, net, wid);
+
+      assert(dqueue);
+      dqueue->push_back(value);
+      return true;
+}
+
+
+/*
+ * %store/qf/obj <var-label>
+ */
+bool of_STORE_QF_OBJ(vthread_t thr, vvp_code_t cp)
+{
+	// Pop the object to be stored...
+      vvp_object_t value;
+      thr->pop_object(value);
+
+      vvp_net_t*net = cp->net;
+      vvp_queue*dqueue = get_queue_object<vvp_queue_object>(thr, net);
+
+      assert(dqueue);
+      dqueue->push_front(value);
+      return true;
+}
 
 /*
  * %store/qf/r <var-label>
  */
-bool of_STORE_QF_R(vthread_t, vvp_code_t)
+bool of_STORE_QF_R(vthread_t thr, vvp_code_t cp)
 {
-      fprintf(stderr, "XXXX %%store/qf/r NOT IMPLEMENTED\n");
+	// Pop the real value to be stored...
+      double value = thr->pop_real();
+
+      vvp_net_t*net = cp->net;
+      vvp_queue*dqueue = get_queue_object<vvp_queue_real>(thr, net);
+
+      assert(dqueue);
+      dqueue->push_front(value);
       return true;
 }
 
 /*
  * %store/qf/str <var-label>
  */
-bool of_STORE_QF_STR(vthread_t, vvp_code_t)
+bool of_STORE_QF_STR(vthread_t thr, vvp_code_t cp)
 {
-      fprintf(stderr, "XXXX %%store/qf/str NOT IMPLEMENTED\n");
+	// Pop the string to be stored...
+      string value = thr->pop_str();
+
+      vvp_net_t*net = cp->net;
+      vvp_queue*dqueue = get_queue_object<vvp_queue_string>(thr, net);
+
+      assert(dqueue);
+      dqueue->push_front(value);
       return true;
 }
 
@@ -5740,6 +6046,25 @@ bool of_STORE_QF_V(vthread_t thr, vvp_code_t cp)
       return true;
 }
 
+/*
+ * %store/qf/vec2 <var-label>, <wid>
+ */
+bool of_STORE_QF_VEC2(vthread_t thr, vvp_code_t cp)
+{
+	// Pop the vec4 value to be stored...
+      vvp_vector4_t value = thr->pop_vec4();
+
+      vvp_net_t*net = cp->net;
+      unsigned wid = cp->bit_idx[0];
+
+      vvp_queue*dqueue = get_queue_vec2(thr, net, wid);
+
+      assert(value.size() == wid);
+      assert(dqueue);
+      dqueue->push_front(value);
+      return true;
+}
+
 bool of_STORE_REAL(vthread_t thr, vvp_code_t cp)
 {
       double val = thr->pop_real();
@@ -5807,7 +6132,7 @@ bool of_STORE_STRA(vthread_t thr, vvp_code_t cp)
  * not consistent with the %store/vec4/<etc> instructions which have
  * no <wid>.
  */
-bool of_STORE_VEC4(vthread_t thr, vvp_code_t cp)
+static void store_vec4_value(vthread_t thr, vvp_code_t cp, vvp_vector4_t&val)
 {
       vvp_net_ptr_t ptr(cp->net, 0);
       vvp_signal_value*sig = dynamic_cast<vvp_signal_value*> (cp->net->fil);
@@ -5817,7 +6142,6 @@ bool of_STORE_VEC4(vthread_t thr, vvp_code_t cp)
       int off = off_index? thr->words[off_index].w_int : 0;
       const int sig_value_size = sig->value_size();
 
-      vvp_vector4_t&val = thr->peek_vec4();
       unsigned val_size = val.size();
 
       if ((int)val_size < wid) {
@@ -5833,17 +6157,14 @@ bool of_STORE_VEC4(vthread_t thr, vvp_code_t cp)
 	// If there is a problem loading the index register, flags-4
 	// will be set to 1, and we know here to skip the actual assignment.
       if (off_index!=0 && thr->flags[4] == BIT4_1) {
-	    thr->pop_vec4(1);
-	    return true;
+	    return;
       }
 
       if (off <= -wid) {
-	    thr->pop_vec4(1);
-	    return true;
+	    return;
       }
       if (off >= sig_value_size) {
-	    thr->pop_vec4(1);
-	    return true;
+	    return;
       }
 
 	// If the index is below the vector, then only assign the high
@@ -5870,11 +6191,41 @@ bool of_STORE_VEC4(vthread_t thr, vvp_code_t cp)
 	    vvp_send_vec4(ptr, val, thr->wt_context);
       else
 	    vvp_send_vec4_pv(ptr, val, off, wid, sig_value_size, thr->wt_context);
+}
 
+bool of_STORE_VEC4(vthread_t thr, vvp_code_t cp)
+{
+      vvp_vector4_t&val = thr->peek_vec4();
+      store_vec4_value(thr, cp, val);
       thr->pop_vec4(1);
       return true;
 }
 
+/*
+ * %load/vec4 <net>
+ * %addi <vala>, <valb>, <wid>
+ * %store/vec4 <var>, <offset>, <wid>
+ *
+ * This fused instruction does the work of the above sequence (i.e. a
+ * simple increment of a variable) without using the vec4 stack. The
+ * operands of the %addi and %store/vec4 are taken from the
+ * instructions that follow this one.
+ */
+bool of_LOAD_ADDI_STORE_VEC4(vthread_t thr, vvp_code_t cp)
+{
+      vvp_vector4_t val;
+      load_vec4_value(cp->net, val);
+
+      vvp_vector4_t r (cp[1].number, BIT4_0);
+      get_immediate_rval (cp+1, r);
+      val.add(r);
+
+      store_vec4_value(thr, cp+2, val);
+
+      thr->pc = cp + 3;
+      return true;
+}
+
 /*
  * %store/vec4a <var-label>, <addr>, <offset>
  */
@@ -5908,7 +6259,7 @@ bool of_STORE_VEC4A(vthread_t thr, vvp_code_t cp)
  */
 bool of_SUB(vthread_t thr, vvp_code_t)
 {
-      vvp_vector4_t r = thr->pop_vec4();
+      const vvp_vector4_t&r = thr->pop_vec4_ref();
       vvp_vector4_t&l = thr->peek_vec4();
 
       l.sub(r);
@@ -6124,6 +6475,26 @@ bool of_WAIT(vthread_t thr, vvp_code_t cp)
       return false;
 }
 
+/*
+ * %jmp <pc>
+ *
+ * This fused instruction is a %jmp to a %wait instruction, which is
+ * how the loop of an "always @(...)" statement is compiled. It does
+ * the wait directly, and leaves the thread ready to continue after
+ * the %wait when it is woken.
+ */
+bool of_JMP_WAIT(vthread_t thr, vvp_code_t cp)
+{
+      if (schedule_stopped()) {
+	    thr->pc = cp->cptr;
+	    schedule_vthread(thr, 0, false);
+	    return false;
+      }
+
+      thr->pc = cp->cptr + 1;
+      return of_WAIT(thr, cp->cptr);
+}
+
 /*
  * Implement the %wait/fork (SystemVerilog) instruction by suspending
  * the current thread until all the detached children have finished.
@@ -6154,7 +6525,7 @@ bool of_WAIT_FORK(vthread_t thr, vvp_code_t)
  */
 bool of_XNOR(vthread_t thr, vvp_code_t)
 {
-      vvp_vector4_t valr = thr->pop_vec4();
+      const vvp_vector4_t&valr = thr->pop_vec4_ref();
       vvp_vector4_t&vall = thr->peek_vec4();
       assert(vall.size() == valr.size());
       unsigned wid = vall.size();
@@ -6174,7 +6545,7 @@ bool of_XNOR(vthread_t thr, vvp_code_t)
  */
 bool of_XOR(vthread_t thr, vvp_code_t)
 {
-      vvp_vector4_t valr = thr->pop_vec4();
+      const vvp_vector4_t&valr = thr->pop_vec4_ref();
       vvp_vector4_t&vall = thr->peek_vec4();
       assert(vall.size() == valr.size());
       unsigned wid = vall.size();
@@ -65,6 +65,30 @@ extern void vthread_delay_delete();
  */
 extern void vthread_run(vthread_t thr);
 
+/*
+ * Select the instruction execution engine used by vthread_run. The
+ * "call" engine calls the opcode function of each instruction in
+ * turn. The "threaded" engine uses the dispatch codes filled in by
+ * vthread_predecode to branch directly to inline implementations of
+ * the simplest opcodes, and falls back to calling the opcode function
+ * for the rest. Return false if the engine is not known or is not
+ * supported by this build.
+ */
+extern bool vthread_set_engine(const char*name);
+
+/*
+ * Fill in the dispatch code of the instruction for the threaded
+ * execution engine.
+ */
+extern void vthread_predecode(vvp_code_t code);
+
+/*
+ * Get the scope and program counter of the thread that is currently
+ * running, if any. The sampling profiler calls this from a signal
+ * handler, so it must only read the thread state.
+ */
+extern bool vthread_profile_point(__vpiScope*&scope, vvp_code_t&pc);
+
 /*
  * This function schedules all the threads in the list to be scheduled
  * for execution with delay 0. The thr pointer is taken to be the head
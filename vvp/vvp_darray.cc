@@ -20,6 +20,7 @@
 # include  "vvp_darray.h"
 # include  <iostream>
 # include  <typeinfo>
+# include  <algorithm>
 
 using namespace std;
 
@@ -125,44 +126,79 @@ template class vvp_darray_atom<int16_t>;
 template class vvp_darray_atom<int32_t>;
 template class vvp_darray_atom<int64_t>;
 
+static inline unsigned darray_word_count(unsigned word_wid)
+{
+      const unsigned BITS_PER_WORD = 8*sizeof(unsigned long);
+      return (word_wid + BITS_PER_WORD - 1) / BITS_PER_WORD;
+}
+
+/*
+ * The items of a vec4 dynamic array start out as all X bits, and
+ * that is all ones in both the abits and bbits words.
+ */
+vvp_darray_vec4::vvp_darray_vec4(size_t siz, unsigned word_wid)
+: size_(siz), word_wid_(word_wid), word_cnt_(darray_word_count(word_wid)),
+  array_(2*siz*word_cnt_, ~0UL)
+{
+}
+
 vvp_darray_vec4::~vvp_darray_vec4()
 {
 }
 
 size_t vvp_darray_vec4::get_size(void) const
 {
-      return array_.size();
+      return size_;
 }
 
 void vvp_darray_vec4::set_word(unsigned adr, const vvp_vector4_t&value)
 {
-      if (adr >= array_.size()) return;
+      if (adr >= size_) return;
       assert(value.size() == word_wid_);
-      array_[adr] = value;
+
+      unsigned long*ap = &array_[2*adr*word_cnt_];
+      unsigned long*bp = ap + word_cnt_;
+      const unsigned long*vap = value.abits_words();
+      const unsigned long*vbp = value.bbits_words();
+      for (unsigned idx = 0 ; idx < word_cnt_ ; idx += 1) {
+	    ap[idx] = vap[idx];
+	    bp[idx] = vbp[idx];
+      }
 }
 
 void vvp_darray_vec4::get_word(unsigned adr, vvp_vector4_t&value)
 {
 	/*
-	 * Return an undefined value for an out of range address or if the
-	 * value has not been written yet (has a size of zero).
+	 * Return an undefined value for an out of range address. The
+	 * items that have not been written yet are still all X.
 	 */
-      if ((adr >= array_.size()) || (array_[adr].size() == 0)) {
+      if (adr >= size_) {
 	    value = vvp_vector4_t(word_wid_, BIT4_X);
 	    return;
       }
-      value = array_[adr];
-      assert(value.size() == word_wid_);
+
+      if (value.size() != word_wid_)
+	    value = vvp_vector4_t(word_wid_);
+
+      const unsigned long*ap = &array_[2*adr*word_cnt_];
+      value.set_words(ap, ap + word_cnt_);
 }
 
 void vvp_darray_vec4::shallow_copy(const vvp_object*obj)
 {
       const vvp_darray_vec4*that = dynamic_cast<const vvp_darray_vec4*>(obj);
       assert(that);
+      assert(word_cnt_ == that->word_cnt_);
 
-      unsigned num_items = min(array_.size(), that->array_.size());
-      for (unsigned idx = 0 ; idx < num_items ; idx += 1)
-	    array_[idx] = that->array_[idx];
+      size_t num_words = min(array_.size(), that->array_.size());
+      copy(that->array_.begin(), that->array_.begin()+num_words,
+           array_.begin());
+}
+
+vvp_darray_vec2::vvp_darray_vec2(size_t siz, unsigned word_wid)
+: size_(siz), word_wid_(word_wid), word_cnt_(darray_word_count(word_wid)),
+  array_(siz*word_cnt_, 0UL)
+{
 }
 
 vvp_darray_vec2::~vvp_darray_vec2()
@@ -171,41 +207,48 @@ vvp_darray_vec2::~vvp_darray_vec2()
 
 size_t vvp_darray_vec2::get_size(void) const
 {
-      return array_.size();
+      return size_;
 }
 
 void vvp_darray_vec2::set_word(unsigned adr, const vvp_vector4_t&value)
 {
-      if (adr >= array_.size()) return;
+      if (adr >= size_) return;
       assert(value.size() == word_wid_);
-      array_[adr] = value;
+
+	// X and Z bits are saved as 0.
+      unsigned long*ap = &array_[adr*word_cnt_];
+      const unsigned long*vap = value.abits_words();
+      const unsigned long*vbp = value.bbits_words();
+      for (unsigned idx = 0 ; idx < word_cnt_ ; idx += 1)
+	    ap[idx] = vap[idx] & ~vbp[idx];
 }
 
 void vvp_darray_vec2::get_word(unsigned adr, vvp_vector4_t&value)
 {
 	/*
-	 * Return a zero value for an out of range address or if the
-	 * value has not been written yet (has a size of zero).
+	 * Return a zero value for an out of range address. The items
+	 * that have not been written yet are still all zero.
 	 */
-      if ((adr >= array_.size()) || (array_[adr].size() == 0)) {
+      if (adr >= size_) {
 	    value = vvp_vector4_t(word_wid_, BIT4_0);
 	    return;
       }
-      assert(array_[adr].size() == word_wid_);
-      value.resize(word_wid_);
-      for (unsigned idx = 0; idx < word_wid_; idx += 1) {
-	    value.set_bit(idx, array_[adr].value4(idx));
-      }
+
+      if (value.size() != word_wid_)
+	    value = vvp_vector4_t(word_wid_);
+
+      value.set_words(&array_[adr*word_cnt_], 0);
 }
 
 void vvp_darray_vec2::shallow_copy(const vvp_object*obj)
 {
       const vvp_darray_vec2*that = dynamic_cast<const vvp_darray_vec2*>(obj);
       assert(that);
+      assert(word_cnt_ == that->word_cnt_);
 
-      unsigned num_items = min(array_.size(), that->array_.size());
-      for (unsigned idx = 0 ; idx < num_items ; idx += 1)
-	    array_[idx] = that->array_[idx];
+      size_t num_words = min(array_.size(), that->array_.size());
+      copy(that->array_.begin(), that->array_.begin()+num_words,
+           array_.begin());
 }
 
 vvp_darray_object::~vvp_darray_object()
@@ -350,6 +393,16 @@ void vvp_queue::push_front(const string&)
       cerr << "XXXX push_front(string) not implemented for " << typeid(*this).name() << endl;
 }
 
+void vvp_queue::push_back(const vvp_object_t&)
+{
+      cerr << "XXXX push_back(vvp_object_t) not implemented for " << typeid(*this).name() << endl;
+}
+
+void vvp_queue::push_front(const vvp_object_t&)
+{
+      cerr << "XXXX push_front(vvp_object_t) not implemented for " << typeid(*this).name() << endl;
+}
+
 vvp_queue_string::~vvp_queue_string()
 {
 }
@@ -364,18 +417,17 @@ void vvp_queue_string::push_back(const string&val)
       array_.push_back(val);
 }
 
+void vvp_queue_string::push_front(const string&val)
+{
+      array_.push_front(val);
+}
+
 void vvp_queue_string::set_word(unsigned adr, const string&value)
 {
       if (adr >= array_.size())
 	    return;
 
-      list<string>::iterator cur = array_.begin();
-      while (adr > 0) {
-	    ++ cur;
-	    adr -= 1;
-      }
-
-      *cur = value;
+      array_[adr] = value;
 }
 
 void vvp_queue_string::get_word(unsigned adr, string&value)
@@ -385,13 +437,7 @@ void vvp_queue_string::get_word(unsigned adr, string&value)
 	    return;
       }
 
-      list<string>::const_iterator cur = array_.begin();
-      while (adr > 0) {
-	    ++ cur;
-	    adr -= 1;
-      }
-
-      value = *cur;
+      value = array_[adr];
 }
 
 void vvp_queue_string::pop_back(void)
@@ -404,6 +450,53 @@ void vvp_queue_string::pop_front(void)
       array_.pop_front();
 }
 
+vvp_queue_real::~vvp_queue_real()
+{
+}
+
+size_t vvp_queue_real::get_size() const
+{
+      return array_.size();
+}
+
+void vvp_queue_real::set_word(unsigned adr, double value)
+{
+      if (adr >= array_.size())
+	    return;
+
+      array_[adr] = value;
+}
+
+void vvp_queue_real::get_word(unsigned adr, double&value)
+{
+      if (adr >= array_.size()) {
+	    value = 0.0;
+	    return;
+      }
+
+      value = array_[adr];
+}
+
+void vvp_queue_real::push_back(double val)
+{
+      array_.push_back(val);
+}
+
+void vvp_queue_real::push_front(double val)
+{
+      array_.push_front(val);
+}
+
+void vvp_queue_real::pop_back(void)
+{
+      array_.pop_back();
+}
+
+void vvp_queue_real::pop_front(void)
+{
+      array_.pop_front();
+}
+
 vvp_queue_vec4::~vvp_queue_vec4()
 {
 }
@@ -418,13 +511,7 @@ void vvp_queue_vec4::set_word(unsigned adr, const vvp_vector4_t&value)
       if (adr >= array_.size())
 	    return;
 
-      list<vvp_vector4_t>::iterator cur = array_.begin();
-      while (adr > 0) {
-	    ++ cur;
-	    adr -= 1;
-      }
-
-      *cur = value;
+      array_[adr] = value;
 }
 
 void vvp_queue_vec4::get_word(unsigned adr, vvp_vector4_t&value)
@@ -434,13 +521,7 @@ void vvp_queue_vec4::get_word(unsigned adr, vvp_vector4_t&value)
 	    return;
       }
 
-      list<vvp_vector4_t>::const_iterator cur = array_.begin();
-      while (adr > 0) {
-	    ++ cur;
-	    adr -= 1;
-      }
-
-      value = *cur;
+      value = array_[adr];
 }
 
 void vvp_queue_vec4::push_back(const vvp_vector4_t&val)
@@ -462,3 +543,205 @@ void vvp_queue_vec4::pop_front(void)
 {
       array_.pop_front();
 }
+
+vvp_queue_vec2::vvp_queue_vec2(unsigned word_wid)
+: word_wid_(word_wid), word_cnt_(darray_word_count(word_wid)),
+  slot_wid_(0), slot_cnt_(1), head_(0), size_(0)
+{
+      const unsigned BITS_PER_WORD = 8*sizeof(unsigned long);
+      if (word_wid_ <= BITS_PER_WORD/2) {
+	    slot_wid_ = 1;
+	    while (slot_wid_ < word_wid_)
+		  slot_wid_ *= 2;
+	    slot_cnt_ = BITS_PER_WORD / slot_wid_;
+      }
+}
+
+vvp_queue_vec2::~vvp_queue_vec2()
+{
+}
+
+size_t vvp_queue_vec2::get_size() const
+{
+      return size_;
+}
+
+void vvp_queue_vec2::set_word(unsigned adr, const vvp_vector4_t&value)
+{
+      if (adr >= size_)
+	    return;
+      assert(value.size() == word_wid_);
+
+	// X and Z bits are saved as 0.
+      const unsigned long*vap = value.abits_words();
+      const unsigned long*vbp = value.bbits_words();
+
+      if (slot_wid_) {
+	    size_t pos = head_ + adr;
+	    unsigned shift = (pos % slot_cnt_) * slot_wid_;
+	    unsigned long mask = ((1UL << slot_wid_) - 1UL) << shift;
+	    unsigned long&word = array_[pos / slot_cnt_];
+	    word = (word & ~mask) | (((vap[0] & ~vbp[0]) << shift) & mask);
+	    return;
+      }
+
+      deque<unsigned long>::iterator cur = array_.begin() + adr*word_cnt_;
+      for (unsigned idx = 0 ; idx < word_cnt_ ; idx += 1)
+	    cur[idx] = vap[idx] & ~vbp[idx];
+}
+
+void vvp_queue_vec2::get_word(unsigned adr, vvp_vector4_t&value)
+{
+      if (adr >= size_) {
+	    value = vvp_vector4_t(word_wid_, BIT4_0);
+	    return;
+      }
+
+      if (value.size() != word_wid_)
+	    value = vvp_vector4_t(word_wid_);
+
+      if (slot_wid_) {
+	    size_t pos = head_ + adr;
+	    unsigned long word = array_[pos / slot_cnt_]
+		  >> ((pos % slot_cnt_) * slot_wid_);
+	    value.set_words(&word, 0);
+	    return;
+      }
+
+	/*
+	 * The words of an item need not be contiguous in the deque,
+	 * so wide items are gathered into a temporary first.
+	 */
+      deque<unsigned long>::const_iterator cur = array_.begin() + adr*word_cnt_;
+      if (word_cnt_ == 1) {
+	    unsigned long word = *cur;
+	    value.set_words(&word, 0);
+      } else {
+	    vector<unsigned long> words (cur, cur+word_cnt_);
+	    value.set_words(&words[0], 0);
+      }
+}
+
+void vvp_queue_vec2::push_back(const vvp_vector4_t&val)
+{
+      assert(val.size() == word_wid_);
+      if (slot_wid_) {
+	    if ((head_ + size_) % slot_cnt_ == 0)
+		  array_.push_back(0);
+	    size_ += 1;
+	    set_word(size_-1, val);
+	    return;
+      }
+
+      const unsigned long*vap = val.abits_words();
+      const unsigned long*vbp = val.bbits_words();
+      for (unsigned idx = 0 ; idx < word_cnt_ ; idx += 1)
+	    array_.push_back(vap[idx] & ~vbp[idx]);
+      size_ += 1;
+}
+
+void vvp_queue_vec2::push_front(const vvp_vector4_t&val)
+{
+      assert(val.size() == word_wid_);
+      if (slot_wid_) {
+	    if (head_ == 0) {
+		  array_.push_front(0);
+		  head_ = slot_cnt_;
+	    }
+	    head_ -= 1;
+	    size_ += 1;
+	    set_word(0, val);
+	    return;
+      }
+
+      const unsigned long*vap = val.abits_words();
+      const unsigned long*vbp = val.bbits_words();
+      for (unsigned idx = word_cnt_ ; idx > 0 ; idx -= 1)
+	    array_.push_front(vap[idx-1] & ~vbp[idx-1]);
+      size_ += 1;
+}
+
+void vvp_queue_vec2::pop_back(void)
+{
+      if (size_ == 0)
+	    return;
+      size_ -= 1;
+      if (slot_wid_) {
+	    if ((head_ + size_) % slot_cnt_ == 0)
+		  array_.pop_back();
+	    if (size_ == 0) {
+		  array_.clear();
+		  head_ = 0;
+	    }
+	    return;
+      }
+
+      array_.erase(array_.end()-word_cnt_, array_.end());
+}
+
+void vvp_queue_vec2::pop_front(void)
+{
+      if (size_ == 0)
+	    return;
+      size_ -= 1;
+      if (slot_wid_) {
+	    head_ += 1;
+	    if (size_ == 0) {
+		  array_.clear();
+		  head_ = 0;
+	    } else if (head_ == slot_cnt_) {
+		  array_.pop_front();
+		  head_ = 0;
+	    }
+	    return;
+      }
+
+      array_.erase(array_.begin(), array_.begin()+word_cnt_);
+}
+
+vvp_queue_object::~vvp_queue_object()
+{
+}
+
+size_t vvp_queue_object::get_size() const
+{
+      return array_.size();
+}
+
+void vvp_queue_object::set_word(unsigned adr, const vvp_object_t&value)
+{
+      if (adr >= array_.size())
+	    return;
+
+      array_[adr] = value;
+}
+
+void vvp_queue_object::get_word(unsigned adr, vvp_object_t&value)
+{
+      if (adr >= array_.size()) {
+	    value = vvp_object_t();
+	    return;
+      }
+
+      value = array_[adr];
+}
+
+void vvp_queue_object::push_back(const vvp_object_t&val)
+{
+      array_.push_back(val);
+}
+
+void vvp_queue_object::push_front(const vvp_object_t&val)
+{
+      array_.push_front(val);
+}
+
+void vvp_queue_object::pop_back(void)
+{
+      array_.pop_back();
+}
+
+void vvp_queue_object::pop_front(void)
+{
+      array_.pop_front();
+}
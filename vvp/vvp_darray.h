@@ -21,7 +21,7 @@
 
 # include  "vvp_object.h"
 # include  "vvp_net.h"
-# include  <list>
+# include  <deque>
 # include  <string>
 # include  <vector>
 
@@ -63,11 +63,17 @@ template <class TYPE> class vvp_darray_atom : public vvp_darray {
       std::vector<TYPE> array_;
 };
 
+/*
+ * The vec4 and vec2 dynamic arrays keep the bits of all the items
+ * packed in one vector of words. Each item takes word_cnt_ words for
+ * its abits, and (for vec4 only) another word_cnt_ words for its
+ * bbits, so there is no per-item allocation and 2-state items take
+ * no space for bbits at all.
+ */
 class vvp_darray_vec4 : public vvp_darray {
 
     public:
-      inline vvp_darray_vec4(size_t siz, unsigned word_wid) :
-                             array_(siz), word_wid_(word_wid) { }
+      vvp_darray_vec4(size_t siz, unsigned word_wid);
       ~vvp_darray_vec4();
 
       size_t get_size(void) const;
@@ -76,15 +82,16 @@ class vvp_darray_vec4 : public vvp_darray {
       void shallow_copy(const vvp_object*obj);
 
     private:
-      std::vector<vvp_vector4_t> array_;
+      size_t size_;
       unsigned word_wid_;
+      unsigned word_cnt_;
+      std::vector<unsigned long> array_;
 };
 
 class vvp_darray_vec2 : public vvp_darray {
 
     public:
-      inline vvp_darray_vec2(size_t siz, unsigned word_wid) :
-                             array_(siz), word_wid_(word_wid) { }
+      vvp_darray_vec2(size_t siz, unsigned word_wid);
       ~vvp_darray_vec2();
 
       size_t get_size(void) const;
@@ -93,8 +100,10 @@ class vvp_darray_vec2 : public vvp_darray {
       void shallow_copy(const vvp_object*obj);
 
     private:
-      std::vector<vvp_vector2_t> array_;
+      size_t size_;
       unsigned word_wid_;
+      unsigned word_cnt_;
+      std::vector<unsigned long> array_;
 };
 
 class vvp_darray_real : public vvp_darray {
@@ -142,6 +151,11 @@ class vvp_darray_object : public vvp_darray {
       std::vector<vvp_object_t> array_;
 };
 
+/*
+ * The queue objects keep their items in a std::deque so that pushing
+ * and popping at either end is amortized constant time and q[i]
+ * accesses go straight to the item.
+ */
 class vvp_queue : public vvp_darray {
 
     public:
@@ -157,6 +171,9 @@ class vvp_queue : public vvp_darray {
       virtual void push_back(const std::string&value);
       virtual void push_front(const std::string&value);
 
+      virtual void push_back(const vvp_object_t&value);
+      virtual void push_front(const vvp_object_t&value);
+
       virtual void pop_back(void) =0;
       virtual void pop_front(void)=0;
 };
@@ -175,9 +192,58 @@ class vvp_queue_vec4 : public vvp_queue {
       void pop_front(void);
 
     private:
-      std::list<vvp_vector4_t> array_;
+      std::deque<vvp_vector4_t> array_;
 };
 
+/*
+ * The 2-state queues keep only the abits of their items, in a deque
+ * of words. Items of up to half a word are packed into slots of
+ * slot_wid_ bits (the item width rounded up to a power of 2), so a
+ * bit queue takes one bit per item and a byte queue 8. Wider items
+ * take word_cnt_ whole words each, the same as in vvp_darray_vec2.
+ * head_ is the slot of the first item within the first word, so
+ * items can be pushed and popped at either end a slot at a time.
+ */
+class vvp_queue_vec2 : public vvp_queue {
+
+    public:
+      explicit vvp_queue_vec2(unsigned word_wid);
+      ~vvp_queue_vec2();
+
+      size_t get_size(void) const;
+      void set_word(unsigned adr, const vvp_vector4_t&value);
+      void get_word(unsigned adr, vvp_vector4_t&value);
+      void push_back(const vvp_vector4_t&value);
+      void push_front(const vvp_vector4_t&value);
+      void pop_back(void);
+      void pop_front(void);
+
+    private:
+      unsigned word_wid_;
+      unsigned word_cnt_;
+      unsigned slot_wid_;
+      unsigned slot_cnt_;
+      unsigned head_;
+      size_t size_;
+      std::deque<unsigned long> array_;
+};
+
+class vvp_queue_real : public vvp_queue {
+
+    public:
+      ~vvp_queue_real();
+
+      size_t get_size(void) const;
+      void set_word(unsigned adr, double value);
+      void get_word(unsigned adr, double&value);
+      void push_back(double value);
+      void push_front(double value);
+      void pop_back(void);
+      void pop_front(void);
+
+    private:
+      std::deque<double> array_;
+};
 
 class vvp_queue_string : public vvp_queue {
 
@@ -188,12 +254,29 @@ class vvp_queue_string : public vvp_queue {
       void set_word(unsigned adr, const std::string&value);
       void get_word(unsigned adr, std::string&value);
       void push_back(const std::string&value);
-	//void push_front(const std::string&value);
+      void push_front(const std::string&value);
+      void pop_back(void);
+      void pop_front(void);
+
+    private:
+      std::deque<std::string> array_;
+};
+
+class vvp_queue_object : public vvp_queue {
+
+    public:
+      ~vvp_queue_object();
+
+      size_t get_size(void) const;
+      void set_word(unsigned adr, const vvp_object_t&value);
+      void get_word(unsigned adr, vvp_object_t&value);
+      void push_back(const vvp_object_t&value);
+      void push_front(const vvp_object_t&value);
       void pop_back(void);
       void pop_front(void);
 
     private:
-      std::list<std::string> array_;
+      std::deque<vvp_object_t> array_;
 };
 
 #endif /* IVL_vvp_darray_H */
@@ -26,7 +26,6 @@
 # include  "vvp_cleanup.h"
 #endif
 # include  <iostream>
-# include  <list>
 # include  <cassert>
 # include  <cstdlib>
 # include  <cstring>
@@ -36,11 +35,15 @@ static bool at_EOS = false;
 
 void island_send_value(vvp_net_t*net, const vvp_vector8_t&val)
 {
-      vvp_island_port*fun = dynamic_cast<vvp_island_port*>(net->fun);
+      vvp_island_port*fun = static_cast<vvp_island_port*>(net->fun);
       if (fun->outvalue .eeq(val))
 	    return;
 
       fun->outvalue = val;
+	// Branches that this port enables read the outvalue, so the
+	// island needs to retest them the next time it runs.
+      if (fun->enables)
+	    fun->mark_changed();
       net->send_vec8(fun->outvalue);
 }
 
@@ -51,6 +54,7 @@ vvp_island::vvp_island()
 {
       flagged_ = false;
       branches_ = 0;
+      changed_ = 0;
       ports_ = 0;
       anodes_ = 0;
       bnodes_ = 0;
@@ -68,8 +72,19 @@ vvp_island::~vvp_island()
       }
 }
 
-void vvp_island::flag_island()
+void vvp_island::mark_changed(vvp_island_port*port)
 {
+      if (port->changed)
+	    return;
+
+      port->changed = true;
+      port->next_changed = changed_;
+      changed_ = port;
+}
+
+void vvp_island::flag_island(vvp_island_port*port)
+{
+      mark_changed(port);
       if (flagged_ == true)
 	    return;
 
@@ -98,6 +113,9 @@ void vvp_island::add_port(const char*key, vvp_net_t*net)
       assert(ports_->sym_get_value(key) == 0);
 
       ports_->sym_set_value(key, net);
+
+      vvp_island_port*port = static_cast<vvp_island_port*>(net->fun);
+      mark_changed(port);
 }
 
 void vvp_island::add_branch(vvp_island_branch*branch, const char*pa, const char*pb)
@@ -151,6 +169,20 @@ vvp_net_t* vvp_island::find_port(const char*key)
 
 void vvp_island::compile_cleanup()
 {
+      unsigned order = 0;
+      for (vvp_island_branch*cur = branches_ ; cur ; cur = cur->next_branch) {
+	    vvp_island_port*port = static_cast<vvp_island_port*>(cur->a->fun);
+	    if (port->node.nil()) {
+		  port->node = vvp_branch_ptr_t(cur, 0);
+		  port->order = order++;
+	    }
+	    port = static_cast<vvp_island_port*>(cur->b->fun);
+	    if (port->node.nil()) {
+		  port->node = vvp_branch_ptr_t(cur, 1);
+		  port->order = order++;
+	    }
+      }
+
       delete ports_;
       ports_ = 0;
 
@@ -162,7 +194,8 @@ void vvp_island::compile_cleanup()
 }
 
 vvp_island_port::vvp_island_port(vvp_island*ip)
-: island_(ip)
+: enables(0), next_changed(0), changed(false), mark(false), order(0),
+  island_(ip)
 {
 }
 
@@ -178,7 +211,7 @@ void vvp_island_port::recv_vec4(vvp_net_ptr_t, const vvp_vector4_t&bit,
 	    return;
 
       invalue = tmp;
-      island_->flag_island();
+      island_->flag_island(this);
 }
 
 void vvp_island_port::recv_vec4_pv(vvp_net_ptr_t port, const vvp_vector4_t&bit,
@@ -196,7 +229,7 @@ void vvp_island_port::recv_vec8(vvp_net_ptr_t, const vvp_vector8_t&bit)
 	    return;
 
       invalue = bit;
-      island_->flag_island();
+      island_->flag_island(this);
 }
 
 void vvp_island_port::recv_vec8_pv(vvp_net_ptr_t, const vvp_vector8_t&bit,
@@ -214,28 +247,23 @@ void vvp_island_port::recv_vec8_pv(vvp_net_ptr_t, const vvp_vector8_t&bit,
 	    }
       }
 
-      island_->flag_island();
+      island_->flag_island(this);
 }
 
 void vvp_island_port::force_flag(bool run_now)
 {
-      if (run_now)
+      if (run_now) {
+	    island_->mark_changed(this);
 	    island_->run_island();
-      else
-	    island_->flag_island();
+      } else {
+	    island_->flag_island(this);
+      }
 }
 
 vvp_island_branch::~vvp_island_branch()
 {
 }
 
-void island_collect_node(list<vvp_branch_ptr_t>&conn, vvp_branch_ptr_t cur)
-{
-      conn .push_back(cur);
-      for (vvp_branch_ptr_t idx = next(cur) ; idx != cur ; idx = next(idx))
-	    conn.push_back(idx);
-}
-
 /* **** COMPILE/LINK SUPPORT **** */
 
 /*
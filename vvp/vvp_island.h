@@ -24,7 +24,6 @@
 # include  "vvp_net_sig.h"
 # include  "symbols.h"
 # include  "schedule.h"
-# include  <list>
 # include  <cassert>
 
 /*
@@ -57,6 +56,8 @@
 struct vvp_island_branch;
 class vvp_island_port;
 
+typedef vvp_sub_pointer_t<vvp_island_branch> vvp_branch_ptr_t;
+
 class vvp_island  : private vvp_gen_event_s {
 
     public:
@@ -67,7 +68,12 @@ class vvp_island  : private vvp_gen_event_s {
 	// the input. The island will use this to create an active
 	// event. The run_run() method will then be called by the
 	// scheduler to process whatever happened.
-      void flag_island();
+      void flag_island(vvp_island_port*port);
+
+	// Add the port to the list of changed ports without
+	// scheduling the island. The port will be looked at the
+	// next time the island runs.
+      void mark_changed(vvp_island_port*port);
 
 	// This is the method that is called, eventually, to process
 	// whatever happened. The derived island class implements this
@@ -84,6 +90,12 @@ class vvp_island  : private vvp_gen_event_s {
 	// scanning the mesh.
       vvp_island_branch*branches_;
 
+	// The ports that changed since the last time the island
+	// ran, linked through their next_changed member. All the
+	// ports start out on this list, so the first run is a full
+	// run. The derived class takes the list when it runs.
+      vvp_island_port*changed_;
+
     public: /* These methods are used during linking. */
 
 	// Add a port to the island. The key is added to the island
@@ -94,7 +106,9 @@ class vvp_island  : private vvp_gen_event_s {
 
       vvp_net_t* find_port(const char*key);
 
-	// Call this method when linking is done.
+	// Call this method when linking is done. This also finds a
+	// node for each port and numbers the ports in the order that
+	// a scan of the branches first reaches them.
       void compile_cleanup(void);
 
     private:
@@ -142,11 +156,28 @@ class vvp_island_port  : public vvp_net_fun_t {
 	// the current time slot.
       virtual void force_flag(bool run_now);
 
+      void mark_changed() { island_->mark_changed(this); }
+
     public:
       vvp_vector8_t invalue;
       vvp_vector8_t outvalue;
       vvp_vector8_t value;
 
+	// One of the branch endpoints that is attached to this
+	// port. This is nil if no branch is attached (i.e. the port
+	// is only used as an enable).
+      vvp_branch_ptr_t node;
+	// The branches that this port enables, if the island has
+	// that sort of branch.
+      vvp_island_branch*enables;
+	// Link and flag for the island list of changed ports.
+      vvp_island_port*next_changed;
+      bool changed;
+	// Scratch flag and ordering for the island to use while it
+	// collects the ports that it needs to run.
+      bool mark;
+      unsigned order;
+
     private:
       vvp_island*island_;
 
@@ -163,7 +194,7 @@ class vvp_island_port  : public vvp_net_fun_t {
 
 inline vvp_vector8_t island_get_value(vvp_net_t*net)
 {
-      vvp_island_port*fun = dynamic_cast<vvp_island_port*>(net->fun);
+      vvp_island_port*fun = static_cast<vvp_island_port*>(net->fun);
       vvp_wire_vec8*fil = dynamic_cast<vvp_wire_vec8*>(net->fil);
 
       if (fil == 0) {
@@ -186,7 +217,7 @@ inline vvp_vector8_t island_get_value(vvp_net_t*net)
 
 inline vvp_vector8_t island_get_sent_value(vvp_net_t*net)
 {
-      vvp_island_port*fun = dynamic_cast<vvp_island_port*>(net->fun);
+      vvp_island_port*fun = static_cast<vvp_island_port*>(net->fun);
       return fun->outvalue;
 }
 
@@ -200,8 +231,6 @@ extern void island_send_value(vvp_net_t*net, const vvp_vector8_t&val);
 * of the island.
 */
 
-typedef vvp_sub_pointer_t<vvp_island_branch> vvp_branch_ptr_t;
-
 struct vvp_island_branch {
       virtual ~vvp_island_branch();
 	// Keep a list of branches in the island.
@@ -221,14 +250,6 @@ static inline vvp_branch_ptr_t next(vvp_branch_ptr_t cur)
       return ptr->link[ab];
 }
 
-/*
- * This function collects into the conn list all the branch ends
- * that are connected together with the reference branch endpoint
- * cur. All these branch ends together form a "node" of the branch
- * network. (In other words, this does *not* follow the branches.)
- */
-extern void island_collect_node(std::list<vvp_branch_ptr_t>&conn, vvp_branch_ptr_t cur);
-
 /*
  * These functions support compile/linking.
  */
@@ -33,6 +33,8 @@
 # include  <climits>
 # include  <cmath>
 # include  <cassert>
+# include  <vector>
+# include  <algorithm>
 #ifdef CHECK_WITH_VALGRIND
 # include  <valgrind/memcheck.h>
 # include  <map>
@@ -49,8 +51,12 @@
 permaheap vvp_net_fun_t::heap_;
 permaheap vvp_net_fil_t::heap_;
 
-// Allocate around 1Megabyte/chunk.
+// Allocate around 1Megabyte/chunk. The compact layout takes its
+// chunks from the shared arena, and keeps them small so that the
+// functors created right after a net land close to it.
 static const size_t VVP_NET_CHUNK = 1024*1024/sizeof(vvp_net_t);
+static const size_t VVP_NET_COMPACT_CHUNK = 8;
+static size_t vvp_net_chunk_size = VVP_NET_CHUNK;
 static vvp_net_t*vvp_net_alloc_table = NULL;
 #ifdef CHECK_WITH_VALGRIND
 static vvp_net_t **vvp_net_pool = NULL;
@@ -61,14 +67,49 @@ static size_t vvp_net_alloc_remaining = 0;
 // chunks allocated.
 unsigned long count_vvp_nets = 0;
 size_t size_vvp_nets = 0;
+// Keep the allocation chunks so that the partition analysis can
+// enumerate all the vvp_net_t objects.
+static std::vector<vvp_net_t*> vvp_net_chunks;
+
+static permaheap vvp_net_compact_heap_;
+permaheap*vvp_net_compact_heap = 0;
+
+bool vvp_net_set_layout(const char*text)
+{
+      if (strcmp(text, "split") == 0) {
+	    vvp_net_compact_heap = 0;
+	    vvp_net_chunk_size = VVP_NET_CHUNK;
+	    return true;
+      }
+      if (strcmp(text, "compact") == 0) {
+#ifdef CHECK_WITH_VALGRIND
+	      // The valgrind support needs the nets in their own pools.
+	    return false;
+#else
+	    vvp_net_compact_heap = &vvp_net_compact_heap_;
+	    vvp_net_chunk_size = VVP_NET_COMPACT_CHUNK;
+	    return true;
+#endif
+      }
+      return false;
+}
 
 void* vvp_net_t::operator new (size_t size)
 {
       assert(size == sizeof(vvp_net_t));
+      if (vvp_net_compact_heap && vvp_net_alloc_remaining == 0) {
+	    vvp_net_alloc_table = (vvp_net_t*)
+		  vvp_net_compact_heap->alloc(size*VVP_NET_COMPACT_CHUNK);
+	    vvp_net_alloc_remaining = VVP_NET_COMPACT_CHUNK;
+	    size_vvp_nets += size*VVP_NET_COMPACT_CHUNK;
+	    vvp_net_chunks.push_back(vvp_net_alloc_table);
+      }
+
       if (vvp_net_alloc_remaining == 0) {
 	    vvp_net_alloc_table = ::new vvp_net_t[VVP_NET_CHUNK];
 	    vvp_net_alloc_remaining = VVP_NET_CHUNK;
 	    size_vvp_nets += size*VVP_NET_CHUNK;
+	    vvp_net_chunks.push_back(vvp_net_alloc_table);
 #ifdef CHECK_WITH_VALGRIND
 	    VALGRIND_MAKE_MEM_NOACCESS(vvp_net_alloc_table, size*VVP_NET_CHUNK);
 	    VALGRIND_CREATE_MEMPOOL(vvp_net_alloc_table, 0, 0);
@@ -91,6 +132,176 @@ void* vvp_net_t::operator new (size_t size)
       return return_this;
 }
 
+unsigned long count_net_regions = 0;
+unsigned long count_net_region_max = 0;
+unsigned long count_net_regions_parallel = 0;
+
+/*
+ * The partition of the netlist, kept for the -j mode of the
+ * scheduler. The nets are numbered in address order through the
+ * allocation chunks: region_chunks holds the chunks sorted by address
+ * with the number of their first net, and region_of_net the region
+ * of each net. Region numbers start at 1, and region_serial tells
+ * which regions must run on the main thread. region_filters maps the
+ * filters of the nets to their region so that VPI callbacks can find
+ * it.
+ */
+struct region_chunk_s {
+      vvp_net_t*base;
+      size_t used;
+      size_t first;
+      bool operator < (const region_chunk_s&that) const
+	    { return base < that.base; }
+};
+typedef std::pair<const vvp_vpi_callback*,unsigned> region_filter_t;
+static std::vector<region_chunk_s> region_chunks;
+static std::vector<unsigned> region_of_net;
+static std::vector<bool> region_serial;
+static std::vector<region_filter_t> region_filters;
+
+/*
+ * Return the number of the net, or the number of nets if the net was
+ * made after the partition.
+ */
+static size_t vvp_net_number(const vvp_net_t*net)
+{
+      region_chunk_s key;
+      key.base = const_cast<vvp_net_t*>(net);
+      std::vector<region_chunk_s>::const_iterator pos
+	    = std::upper_bound(region_chunks.begin(), region_chunks.end(), key);
+      if (pos == region_chunks.begin())
+	    return region_of_net.size();
+      --pos;
+      size_t off = net - pos->base;
+      if (off >= pos->used)
+	    return region_of_net.size();
+      return pos->first + off;
+}
+
+static size_t vvp_net_find_root(std::vector<size_t>&parent, size_t idx)
+{
+      while (parent[idx] != idx) {
+	    parent[idx] = parent[parent[idx]];
+	    idx = parent[idx];
+      }
+      return idx;
+}
+
+static bool vvp_net_parallel_safe(const vvp_net_t*net)
+{
+      if (net->fun && ! net->fun->parallel_safe())
+	    return false;
+      if (net->fil && net->fil->has_vpi_callbacks())
+	    return false;
+      return true;
+}
+
+void vvp_net_partition(void)
+{
+      count_net_regions = 0;
+      count_net_region_max = 0;
+      count_net_regions_parallel = 0;
+
+	// Number all the nets in address order. All the chunks are
+	// full except the last one allocated.
+      region_chunks.resize(vvp_net_chunks.size());
+      for (size_t idx = 0 ; idx < vvp_net_chunks.size() ; idx += 1) {
+	    region_chunks[idx].base = vvp_net_chunks[idx];
+	    region_chunks[idx].used = vvp_net_chunk_size;
+	    if (idx+1 == vvp_net_chunks.size())
+		  region_chunks[idx].used -= vvp_net_alloc_remaining;
+      }
+      std::sort(region_chunks.begin(), region_chunks.end());
+
+      std::vector<vvp_net_t*> nets;
+      for (size_t idx = 0 ; idx < region_chunks.size() ; idx += 1) {
+	    region_chunks[idx].first = nets.size();
+	    for (size_t off = 0 ; off < region_chunks[idx].used ; off += 1)
+		  nets.push_back(region_chunks[idx].base + off);
+      }
+      region_of_net.assign(nets.size(), 0);
+      if (nets.empty()) return;
+
+      std::vector<size_t> parent (nets.size());
+      for (size_t idx = 0 ; idx < nets.size() ; idx += 1)
+	    parent[idx] = idx;
+
+      for (size_t idx = 0 ; idx < nets.size() ; idx += 1) {
+	    size_t root = vvp_net_find_root(parent, idx);
+
+	    vvp_net_ptr_t cur = nets[idx]->out_;
+	    while (vvp_net_t*dst = cur.ptr()) {
+		  size_t dnum = vvp_net_number(dst);
+		  if (dnum < nets.size()) {
+			size_t droot = vvp_net_find_root(parent, dnum);
+			if (droot != root)
+			      parent[droot] = root;
+		  }
+		  cur = dst->port[cur.port()];
+	    }
+      }
+
+	// Number the regions, and find the ones that hold a net that
+	// cannot be evaluated by a worker thread.
+      std::vector<unsigned long> size (nets.size(), 0);
+      std::vector<unsigned> number (nets.size(), 0);
+      region_serial.assign(1, true);
+      region_filters.clear();
+      for (size_t idx = 0 ; idx < nets.size() ; idx += 1) {
+	    size_t root = vvp_net_find_root(parent, idx);
+	    if (size[root] == 0) {
+		  count_net_regions += 1;
+		  number[root] = region_serial.size();
+		  region_serial.push_back(false);
+	    }
+	    size[root] += 1;
+	    if (size[root] > count_net_region_max)
+		  count_net_region_max = size[root];
+
+	    unsigned region = number[root];
+	    region_of_net[idx] = region;
+	    if (! vvp_net_parallel_safe(nets[idx]))
+		  region_serial[region] = true;
+	    if (nets[idx]->fil)
+		  region_filters.push_back(region_filter_t(nets[idx]->fil, region));
+      }
+      std::sort(region_filters.begin(), region_filters.end());
+
+      for (size_t idx = 1 ; idx < region_serial.size() ; idx += 1) {
+	    if (! region_serial[idx])
+		  count_net_regions_parallel += 1;
+      }
+}
+
+unsigned vvp_net_region(const vvp_net_t*net)
+{
+      size_t num = vvp_net_number(net);
+      if (num >= region_of_net.size())
+	    return 0;
+
+      unsigned region = region_of_net[num];
+      return region_serial[region]? 0 : region;
+}
+
+static void vvp_net_region_serial_net(const vvp_net_t*net)
+{
+      size_t num = vvp_net_number(net);
+      if (num < region_of_net.size())
+	    region_serial[region_of_net[num]] = true;
+}
+
+void vvp_net_region_serial(const vvp_vpi_callback*obj)
+{
+      if (region_filters.empty())
+	    return;
+
+      std::vector<region_filter_t>::const_iterator pos
+	    = std::lower_bound(region_filters.begin(), region_filters.end(),
+			       region_filter_t(obj, 0));
+      if (pos != region_filters.end() && pos->first == obj)
+	    region_serial[pos->second] = true;
+}
+
 #ifdef CHECK_WITH_VALGRIND
 static map<vvp_net_t*, bool> vvp_net_map;
 static map<sfunc_core*, bool> sfunc_map;
@@ -199,6 +410,13 @@ void vvp_net_t::link(vvp_net_ptr_t port_to_link)
       vvp_net_t*net = port_to_link.ptr();
       net->port[port_to_link.port()] = out_;
       out_ = port_to_link;
+
+	// A link made after the partition may join two regions, so
+	// neither can be evaluated apart from the other any more.
+      if (! region_of_net.empty()) {
+	    vvp_net_region_serial_net(this);
+	    vvp_net_region_serial_net(net);
+      }
 }
 
 /*
@@ -1198,6 +1416,79 @@ void vvp_vector4_t::setarray(unsigned adr, unsigned wid, const unsigned long*val
       }
 }
 
+/*
+ * The s_vpi_vecval entries hold 32 bits each, so pack them into (or
+ * unpack them from) as many entries as fit in each vector word.
+ */
+void vvp_vector4_t::set_vecval(const s_vpi_vecval*val)
+{
+      const unsigned PER_WORD = BITS_PER_WORD / 32;
+      unsigned long*ap = size_ > BITS_PER_WORD? abits_ptr_ : &abits_val_;
+      unsigned long*bp = size_ > BITS_PER_WORD? bbits_ptr_ : &bbits_val_;
+      unsigned nval = (size_ + 31) / 32;
+      unsigned nwords = (size_ + BITS_PER_WORD - 1) / BITS_PER_WORD;
+
+      for (unsigned idx = 0 ;  idx < nwords ;  idx += 1) {
+	    unsigned long aw = 0, bw = 0;
+	    for (unsigned sub = 0 ; sub < PER_WORD ; sub += 1) {
+		  unsigned vdx = idx*PER_WORD + sub;
+		  if (vdx >= nval) break;
+		  aw |= (unsigned long)(PLI_UINT32)val[vdx].aval << (32*sub);
+		  bw |= (unsigned long)(PLI_UINT32)val[vdx].bval << (32*sub);
+	    }
+	    ap[idx] = aw;
+	    bp[idx] = bw;
+      }
+
+      unsigned tail = size_ % BITS_PER_WORD;
+      if (tail != 0) {
+	    unsigned long mask = (1UL << tail) - 1UL;
+	    ap[nwords-1] &= mask;
+	    bp[nwords-1] &= mask;
+      }
+}
+
+void vvp_vector4_t::get_vecval(s_vpi_vecval*val) const
+{
+      const unsigned PER_WORD = BITS_PER_WORD / 32;
+      const unsigned long*ap = abits_words();
+      const unsigned long*bp = bbits_words();
+      unsigned nval = (size_ + 31) / 32;
+
+      for (unsigned vdx = 0 ;  vdx < nval ;  vdx += 1) {
+	    unsigned shift = 32 * (vdx % PER_WORD);
+	    val[vdx].aval = (PLI_INT32)(PLI_UINT32)(ap[vdx/PER_WORD] >> shift);
+	    val[vdx].bval = (PLI_INT32)(PLI_UINT32)(bp[vdx/PER_WORD] >> shift);
+      }
+
+      unsigned tail = size_ % 32;
+      if (tail != 0) {
+	    PLI_UINT32 mask = (1U << tail) - 1U;
+	    val[nval-1].aval &= mask;
+	    val[nval-1].bval &= mask;
+      }
+}
+
+void vvp_vector4_t::set_words(const unsigned long*abits,
+			      const unsigned long*bbits)
+{
+      unsigned long*ap = size_ > BITS_PER_WORD? abits_ptr_ : &abits_val_;
+      unsigned long*bp = size_ > BITS_PER_WORD? bbits_ptr_ : &bbits_val_;
+      unsigned nwords = (size_ + BITS_PER_WORD - 1) / BITS_PER_WORD;
+
+      for (unsigned idx = 0 ;  idx < nwords ;  idx += 1) {
+	    ap[idx] = abits[idx];
+	    bp[idx] = bbits? bbits[idx] : 0;
+      }
+
+      unsigned tail = size_ % BITS_PER_WORD;
+      if (tail != 0) {
+	    unsigned long mask = (1UL << tail) - 1UL;
+	    ap[nwords-1] &= mask;
+	    bp[nwords-1] &= mask;
+      }
+}
+
 /*
  * Set the bits of that vector, which must be a subset of this vector,
  * into the addressed part of this vector. Use bit masking and word
@@ -1670,45 +1961,8 @@ void vvp_vector4_t::mul(const vvp_vector4_t&that)
 	    }
       }
 
-	// Calculate the result into a res array. We need to keep is
-	// separate from the "this" array because we are making
-	// multiple passes.
-      unsigned long*res = new unsigned long[cnt];
-      for (int idx = 0 ; idx < cnt ; idx += 1)
-	    res[idx] = 0;
-
-      for (int mul_a = 0 ; mul_a < cnt ; mul_a += 1) {
-	    unsigned long lval = abits_ptr_[mul_a];
-	    if (mul_a == (cnt-1))
-		  lval &= mask;
-
-	    for (int mul_b = 0 ; mul_b < (cnt-mul_a) ; mul_b += 1) {
-		  unsigned long rval = that.abits_ptr_[mul_b];
-		  if (mul_b == (cnt-1))
-			rval &= mask;
-
-		  unsigned long sum;
-		  unsigned long tmp = multiply_with_carry(lval, rval, sum);
-		  int base = mul_a + mul_b;
-		  unsigned long carry = 0;
-		  res[base] = add_with_carry(res[base], tmp, carry);
-		  for (int add_idx = base+1 ; add_idx < cnt ; add_idx += 1) {
-			res[add_idx] = add_with_carry(res[add_idx], sum, carry);
-			sum = 0;
-		  }
-	    }
-      }
-
-	// Replace the "this" value with the calculated result. We
-	// know a-priori that the bbits are zero and unchanged.
-      res[cnt-1] &= mask;
-      for (int idx = 0 ; idx < cnt ; idx += 1)
-	    abits_ptr_[idx] = res[idx];
-
-      delete[]res;
-      return;
-
-
+	// We know a-priori that the bbits are zero and unchanged.
+      vvp_words_mul(abits_ptr_, abits_ptr_, that.abits_ptr_, size_);
 }
 
 bool vvp_vector4_t::eeq(const vvp_vector4_t&that) const
@@ -2334,6 +2588,170 @@ vvp_vector4_t vvp_vector4array_aa::get_word(unsigned index) const
       return get_word_(cell);
 }
 
+vvp_vector4array_sparse::vvp_vector4array_sparse(unsigned width__, unsigned words__)
+: vvp_vector4array_t(width__, words__)
+{
+      cnt_ = (width_ + vvp_vector4_t::BITS_PER_WORD-1)/vvp_vector4_t::BITS_PER_WORD;
+      npages_ = (words_ + PAGE_WORDS-1) / PAGE_WORDS;
+      pages_ = new page_s*[npages_];
+      for (unsigned idx = 0 ; idx < npages_ ; idx += 1)
+	    pages_[idx] = 0;
+}
+
+vvp_vector4array_sparse::~vvp_vector4array_sparse()
+{
+      for (unsigned idx = 0 ; idx < npages_ ; idx += 1) {
+	    page_s*page = pages_[idx];
+	    if (page == 0) continue;
+	    delete[]page->abits;
+	    delete[]page->bbits;
+	    delete[]page->valid;
+	    delete page;
+      }
+      delete[]pages_;
+}
+
+vvp_vector4array_sparse::page_s* vvp_vector4array_sparse::new_page_(bool two_state)
+{
+      const unsigned BPW = vvp_vector4_t::BITS_PER_WORD;
+      unsigned nbits = PAGE_WORDS * cnt_;
+
+      page_s*page = new page_s;
+      page->abits = new unsigned long[nbits];
+      if (two_state) {
+	    page->bbits = 0;
+	    page->valid = new unsigned long[PAGE_WORDS/BPW];
+	    for (unsigned idx = 0 ; idx < PAGE_WORDS/BPW ; idx += 1)
+		  page->valid[idx] = 0;
+      } else {
+	    page->bbits = new unsigned long[nbits];
+	    page->valid = 0;
+	    for (unsigned idx = 0 ; idx < nbits ; idx += 1) {
+		  page->abits[idx] = vvp_vector4_t::WORD_X_ABITS;
+		  page->bbits[idx] = vvp_vector4_t::WORD_X_BBITS;
+	    }
+      }
+      count_sparse_array_pages += 1;
+      return page;
+}
+
+/*
+ * Give a 2-state page its bbits. The words that were never written
+ * become X.
+ */
+void vvp_vector4array_sparse::make_4state_(page_s*page)
+{
+      const unsigned BPW = vvp_vector4_t::BITS_PER_WORD;
+      assert(page->valid && page->bbits == 0);
+
+      page->bbits = new unsigned long[PAGE_WORDS * cnt_];
+      for (unsigned idx = 0 ; idx < PAGE_WORDS ; idx += 1) {
+	    bool valid = page->valid[idx/BPW] & (1UL << idx%BPW);
+	    unsigned long*ap = page->abits + idx*cnt_;
+	    unsigned long*bp = page->bbits + idx*cnt_;
+	    for (unsigned n = 0 ; n < cnt_ ; n += 1) {
+		  if (valid) {
+			bp[n] = vvp_vector4_t::WORD_0_BBITS;
+		  } else {
+			ap[n] = vvp_vector4_t::WORD_X_ABITS;
+			bp[n] = vvp_vector4_t::WORD_X_BBITS;
+		  }
+	    }
+      }
+      delete[]page->valid;
+      page->valid = 0;
+}
+
+bool vvp_vector4array_sparse::all_x_(const vvp_vector4_t&that)
+{
+      const unsigned BPW = vvp_vector4_t::BITS_PER_WORD;
+      const unsigned long*ap = that.abits_words();
+      const unsigned long*bp = that.bbits_words();
+      unsigned full = that.size_ / BPW;
+
+      for (unsigned idx = 0 ; idx < full ; idx += 1) {
+	    if ((ap[idx] & bp[idx]) != vvp_vector4_t::WORD_X_ABITS)
+		  return false;
+      }
+
+      if (that.size_ % BPW) {
+	    unsigned long mask = -1UL >> (BPW - that.size_%BPW);
+	    if ((ap[full] & bp[full] & mask) != mask)
+		  return false;
+      }
+      return true;
+}
+
+void vvp_vector4array_sparse::set_word(unsigned index, const vvp_vector4_t&that)
+{
+      const unsigned BPW = vvp_vector4_t::BITS_PER_WORD;
+      assert(index < words_);
+      assert(that.size_ == width_);
+
+      page_s*&page = pages_[index / PAGE_WORDS];
+      unsigned off = index % PAGE_WORDS;
+      bool xz = that.has_xz();
+
+      if (page == 0) {
+	      // Writing X to a missing page changes nothing.
+	    if (xz && all_x_(that))
+		  return;
+	    page = new_page_(! xz);
+      }
+
+      if (page->valid) {
+	    unsigned long bit = 1UL << off%BPW;
+	    if (! xz) {
+		  page->valid[off/BPW] |= bit;
+	    } else if (all_x_(that)) {
+		  page->valid[off/BPW] &= ~bit;
+		  return;
+	    } else {
+		  make_4state_(page);
+	    }
+      }
+
+      const unsigned long*src_a = that.abits_words();
+      const unsigned long*src_b = that.bbits_words();
+      unsigned long*ap = page->abits + off*cnt_;
+      for (unsigned n = 0 ; n < cnt_ ; n += 1)
+	    ap[n] = src_a[n];
+      if (page->bbits) {
+	    unsigned long*bp = page->bbits + off*cnt_;
+	    for (unsigned n = 0 ; n < cnt_ ; n += 1)
+		  bp[n] = src_b[n];
+      }
+}
+
+vvp_vector4_t vvp_vector4array_sparse::get_word(unsigned index) const
+{
+      const unsigned BPW = vvp_vector4_t::BITS_PER_WORD;
+      if (index >= words_)
+	    return vvp_vector4_t(width_, BIT4_X);
+
+      const page_s*page = pages_[index / PAGE_WORDS];
+      unsigned off = index % PAGE_WORDS;
+      if (page == 0)
+	    return vvp_vector4_t(width_, BIT4_X);
+      if (page->valid && !(page->valid[off/BPW] & (1UL << off%BPW)))
+	    return vvp_vector4_t(width_, BIT4_X);
+
+      const unsigned long*ap = page->abits + off*cnt_;
+      const unsigned long*bp = page->bbits? page->bbits + off*cnt_ : 0;
+
+      vvp_vector4_t res (width_, BIT4_X);
+      if (width_ <= BPW) {
+	    res.abits_val_ = ap[0];
+	    res.bbits_val_ = bp? bp[0] : 0UL;
+      } else {
+	    for (unsigned n = 0 ; n < cnt_ ; n += 1) {
+		  res.abits_ptr_[n] = ap[n];
+		  res.bbits_ptr_[n] = bp? bp[n] : 0UL;
+	    }
+      }
+      return res;
+}
+
 vvp_vector2_t::vvp_vector2_t()
 {
       vec_ = 0;
@@ -2709,6 +3127,7 @@ vvp_vector2_t pow(const vvp_vector2_t&x, vvp_vector2_t&y)
       return res;
 }
 
+#if !defined(__SIZEOF_INT128__)
 static void multiply_long(unsigned long a, unsigned long b,
 			  unsigned long&low, unsigned long&high)
 {
@@ -2748,85 +3167,402 @@ static void multiply_long(unsigned long a, unsigned long b,
       high = (res[3] << 4UL*sizeof(unsigned long)) | res[2];
       low  = (res[1] << 4UL*sizeof(unsigned long)) | res[0];
 }
+#endif
 
-vvp_vector2_t operator * (const vvp_vector2_t&a, const vvp_vector2_t&b)
+/*
+ * The wide multiply, divide and modulus operators all work on arrays
+ * of words, least significant word first. The functions below are
+ * the shared kernels for them. They use private scratch buffers that
+ * grow to fit the largest operands seen, so once warmed up they do
+ * not allocate memory.
+ */
+static unsigned long*words_scratch_ptr = 0;
+static size_t words_scratch_size = 0;
+
+static unsigned long*words_scratch(size_t need)
 {
-      const unsigned bits_per_word = 8 * sizeof(a.vec_[0]);
+      if (need > words_scratch_size) {
+	    delete[]words_scratch_ptr;
+	    words_scratch_size = need + need/2;
+	    words_scratch_ptr = new unsigned long[words_scratch_size];
+      }
+      return words_scratch_ptr;
+}
 
-	// The compiler ensures that the two operands are of equal size.
-      assert(a.size() == b.size());
-      vvp_vector2_t r (0, a.size());
+static inline unsigned long mul_word(unsigned long a, unsigned long b,
+				     unsigned long&high)
+{
+#if defined(__SIZEOF_INT128__)
+      unsigned __int128 tmp = (unsigned __int128)a * b;
+      high = (unsigned long)(tmp >> CPU_WORD_BITS);
+      return (unsigned long)tmp;
+#else
+      unsigned long low;
+      multiply_long(a, b, low, high);
+      return low;
+#endif
+}
 
-      unsigned words = (r.wid_ + bits_per_word - 1) / bits_per_word;
+/*
+ * res[0..n) += a[0..n) * b, returning the carry out of the top word.
+ */
+static unsigned long mul_add_words(unsigned long*res, const unsigned long*a,
+				   unsigned n, unsigned long b)
+{
+      unsigned long carry = 0;
+      for (unsigned idx = 0 ; idx < n ; idx += 1) {
+	    unsigned long high;
+	    unsigned long low = mul_word(a[idx], b, high);
+	    low += carry;
+	    high += (low < carry);
+	    res[idx] += low;
+	    high += (res[idx] < low);
+	    carry = high;
+      }
+      return carry;
+}
 
-      for (unsigned bdx = 0 ;  bdx < words ;  bdx += 1) {
-	    unsigned long tmpb = b.vec_[bdx];
-	    if (tmpb == 0)
-		  continue;
+/*
+ * res[0..n) += a[0..na), returning the carry out of the top word.
+ */
+static unsigned long add_words(unsigned long*res, unsigned n,
+			       const unsigned long*a, unsigned na)
+{
+      unsigned long carry = 0;
+      unsigned idx = 0;
+      for ( ; idx < na ; idx += 1)
+	    res[idx] = add_with_carry(res[idx], a[idx], carry);
+      for ( ; carry && idx < n ; idx += 1) {
+	    res[idx] += 1;
+	    carry = (res[idx] == 0);
+      }
+      return carry;
+}
 
-	    for (unsigned adx = 0 ;  adx < words ;  adx += 1) {
-		  unsigned long tmpa = a.vec_[adx];
-		  if (tmpa == 0)
-			continue;
+/*
+ * res[0..n) -= a[0..na). The caller knows that res >= a.
+ */
+static void sub_words(unsigned long*res, unsigned n,
+		      const unsigned long*a, unsigned na)
+{
+      unsigned long carry = 1;
+      unsigned idx = 0;
+      for ( ; idx < na ; idx += 1)
+	    res[idx] = add_with_carry(res[idx], ~a[idx], carry);
+      for ( ; !carry && idx < n ; idx += 1) {
+	    carry = (res[idx] != 0);
+	    res[idx] -= 1;
+      }
+}
 
-		  unsigned long low, hig;
-		  multiply_long(tmpa, tmpb, low, hig);
+/*
+ * Below this many words the schoolbook multiply is faster than
+ * Karatsuba. KARATSUBA_SCRATCH(n) bounds the scratch words that the
+ * recursion needs for n word operands.
+ */
+static const unsigned KARATSUBA_THRESHOLD = 32;
+# define KARATSUBA_SCRATCH(n) (6*(size_t)(n) + 128)
 
-		  unsigned long carry = 0;
-		  for (unsigned sdx = 0
-			     ; (adx+bdx+sdx) < words
-			     ;  sdx += 1) {
+/*
+ * res[0..2n) = a[0..n) * b[0..n). The result may not overlap the
+ * operands.
+ */
+static void mul_words_full(unsigned long*res, const unsigned long*a,
+			   const unsigned long*b, unsigned n,
+			   unsigned long*scratch)
+{
+      if (n < KARATSUBA_THRESHOLD) {
+	    for (unsigned idx = 0 ; idx < n ; idx += 1)
+		  res[idx] = 0;
+	    for (unsigned idx = 0 ; idx < n ; idx += 1)
+		  res[idx+n] = mul_add_words(res+idx, a, n, b[idx]);
+	    return;
+      }
 
-			r.vec_[adx+bdx+sdx] = add_carry(r.vec_[adx+bdx+sdx],
-							low, carry);
-			low = hig;
-			hig = 0;
-		  }
-	    }
+	// Split a = a1*B^h + a0 and b = b1*B^h + b0, where the high
+	// halves have m >= h words. Then
+	//   a*b = z2*B^2h + (z1-z2-z0)*B^h + z0
+	// with z0 = a0*b0, z2 = a1*b1 and z1 = (a0+a1)*(b0+b1).
+      unsigned h = n / 2;
+      unsigned m = n - h;
+
+      unsigned long*sa = scratch;
+      unsigned long*sb = sa + m;
+      unsigned long*z1 = sb + m;
+      unsigned long*rest = z1 + 2*m + 2;
+
+      mul_words_full(res, a, b, h, rest);
+      mul_words_full(res+2*h, a+h, b+h, m, rest);
+
+      for (unsigned idx = 0 ; idx < m ; idx += 1) {
+	    sa[idx] = a[h+idx];
+	    sb[idx] = b[h+idx];
       }
+      unsigned long ca = add_words(sa, m, a, h);
+      unsigned long cb = add_words(sb, m, b, h);
 
-      return r;
+      mul_words_full(z1, sa, sb, m, rest);
+      z1[2*m] = 0;
+      z1[2*m+1] = 0;
+      if (ca) add_words(z1+m, m+2, sb, m);
+      if (cb) add_words(z1+m, m+2, sa, m);
+      if (ca && cb) {
+	    unsigned long one = 1;
+	    add_words(z1+2*m, 2, &one, 1);
+      }
+
+      sub_words(z1, 2*m+2, res, 2*h);
+      sub_words(z1, 2*m+2, res+2*h, 2*m);
+      add_words(res+h, 2*n-h, z1, 2*m+2);
 }
 
-static void div_mod (vvp_vector2_t dividend, vvp_vector2_t divisor,
-		     vvp_vector2_t&quotient, vvp_vector2_t&remainder)
-{
+/*
+ * res[0..n) = the low n words of a[0..n) * b[0..n). This is all that
+ * the Verilog operators need, since the result has the width of the
+ * operands. The result may not overlap the operands.
+ */
+static void mul_words_low(unsigned long*res, const unsigned long*a,
+			  const unsigned long*b, unsigned n,
+			  unsigned long*scratch)
+{
+      if (n < KARATSUBA_THRESHOLD) {
+	    for (unsigned idx = 0 ; idx < n ; idx += 1)
+		  res[idx] = 0;
+	    for (unsigned idx = 0 ; idx < n ; idx += 1)
+		  mul_add_words(res+idx, a, n-idx, b[idx]);
+	    return;
+      }
 
-      quotient = vvp_vector2_t(0, dividend.size());
+	// The low n words of a*b are the low n words of
+	//   z0 + (a0*b1 + a1*b0)*B^h + a1*b1*B^2h
+	// where only the low word of a1*b1 is needed, and only if
+	// n is odd. The cross products are themselves truncated.
+      unsigned h = n / 2;
+      unsigned m = n - h;
 
-      if (divisor == quotient) {
-	    cerr << "ERROR: division by zero, exiting." << endl;
-	    exit(255);
+      mul_words_full(scratch, a, b, h, scratch+2*h);
+      for (unsigned idx = 0 ; idx < 2*h ; idx += 1)
+	    res[idx] = scratch[idx];
+      if (m > h) {
+	    unsigned long high;
+	    res[n-1] = mul_word(a[h], b[h], high);
       }
 
-      if (dividend < divisor) {
-	    remainder = dividend;
+      unsigned long*ext = scratch;
+      unsigned long*tmp = ext + m;
+      unsigned long*rest = tmp + m;
+
+      for (unsigned idx = 0 ; idx < m ; idx += 1)
+	    ext[idx] = idx < h? a[idx] : 0;
+      mul_words_low(tmp, ext, b+h, m, rest);
+      add_words(res+h, m, tmp, m);
+
+      for (unsigned idx = 0 ; idx < m ; idx += 1)
+	    ext[idx] = idx < h? b[idx] : 0;
+      mul_words_low(tmp, a+h, ext, m, rest);
+      add_words(res+h, m, tmp, m);
+}
+
+void vvp_words_mul(unsigned long*res, const unsigned long*a,
+		   const unsigned long*b, unsigned wid)
+{
+      unsigned words = (wid + CPU_WORD_BITS - 1) / CPU_WORD_BITS;
+      if (words == 0)
 	    return;
+
+      unsigned long*tmp = words_scratch(words + KARATSUBA_SCRATCH(words));
+      mul_words_low(tmp, a, b, words, tmp+words);
+
+      for (unsigned idx = 0 ; idx < words ; idx += 1)
+	    res[idx] = tmp[idx];
+      if (unsigned tail = wid % CPU_WORD_BITS)
+	    res[words-1] &= ~(-1UL << tail);
+}
+
+/*
+ * The division works on 32 bit digits, so that the partial
+ * quotients and products fit in a uint64_t on any host.
+ */
+static uint32_t*digits_scratch_ptr = 0;
+static size_t digits_scratch_size = 0;
+
+static uint32_t*digits_scratch(size_t need)
+{
+      if (need > digits_scratch_size) {
+	    delete[]digits_scratch_ptr;
+	    digits_scratch_size = need + need/2;
+	    digits_scratch_ptr = new uint32_t[digits_scratch_size];
       }
+      return digits_scratch_ptr;
+}
+
+static const unsigned DIGITS_PER_WORD = sizeof(unsigned long) / sizeof(uint32_t);
+
+/*
+ * Unpack the low wid bits of the words into digits, and return the
+ * number of significant digits.
+ */
+static unsigned words_to_digits(uint32_t*dst, const unsigned long*src,
+				unsigned wid)
+{
+      unsigned words = (wid + CPU_WORD_BITS - 1) / CPU_WORD_BITS;
+      for (unsigned idx = 0 ; idx < words ; idx += 1) {
+	    unsigned long val = src[idx];
+	    if (idx == words-1 && (wid % CPU_WORD_BITS))
+		  val &= ~(-1UL << (wid % CPU_WORD_BITS));
+	    for (unsigned dig = 0 ; dig < DIGITS_PER_WORD ; dig += 1)
+		  dst[idx*DIGITS_PER_WORD + dig] = (uint32_t)(val >> (32*dig));
+      }
+
+      unsigned cnt = words * DIGITS_PER_WORD;
+      while (cnt > 0 && dst[cnt-1] == 0)
+	    cnt -= 1;
+      return cnt;
+}
 
-      vvp_vector2_t mask (1, dividend.size());
+static void digits_to_words(unsigned long*dst, const uint32_t*src,
+			    unsigned cnt, unsigned words)
+{
+      for (unsigned idx = 0 ; idx < words ; idx += 1) {
+	    unsigned long val = 0;
+	    for (unsigned dig = 0 ; dig < DIGITS_PER_WORD ; dig += 1) {
+		  unsigned pos = idx*DIGITS_PER_WORD + dig;
+		  if (pos < cnt)
+			val |= (unsigned long)src[pos] << (32*dig);
+	    }
+	    dst[idx] = val;
+      }
+}
 
-	// Make the dividend 1 bit larger to prevent overflow of
-	// divtmp in startup.
-      dividend = vvp_vector2_t(dividend, dividend.size()+1);
-      vvp_vector2_t divtmp (divisor, dividend.size());
+/*
+ * This is Knuth's Algorithm D (TAOCP vol. 2, 4.3.1) on base 2^32
+ * digits. The quotient of u[0..m) / v[0..n) goes into q[0..m-n+1)
+ * and the remainder replaces u[0..n). The caller makes sure that
+ * m >= n >= 2 and v[n-1] != 0. The un and vn arrays hold the
+ * normalized operands, and have m+1 and n digits.
+ */
+static void divide_digits(uint32_t*q, uint32_t*u, unsigned m,
+			  const uint32_t*v, unsigned n,
+			  uint32_t*un, uint32_t*vn)
+{
+      const uint64_t base = 1ULL << 32;
+
+	// Normalize so that the top bit of the divisor is set.
+      unsigned shift = 0;
+      while (((v[n-1] << shift) & 0x80000000U) == 0)
+	    shift += 1;
+
+      for (unsigned idx = n-1 ; idx > 0 ; idx -= 1)
+	    vn[idx] = (v[idx] << shift)
+		  | (shift? v[idx-1] >> (32-shift) : 0);
+      vn[0] = v[0] << shift;
+
+      un[m] = shift? u[m-1] >> (32-shift) : 0;
+      for (unsigned idx = m-1 ; idx > 0 ; idx -= 1)
+	    un[idx] = (u[idx] << shift)
+		  | (shift? u[idx-1] >> (32-shift) : 0);
+      un[0] = u[0] << shift;
+
+      for (unsigned jdx = m-n+1 ; jdx > 0 ; jdx -= 1) {
+	    unsigned j = jdx - 1;
+
+	      // Estimate the quotient digit from the top two digits
+	      // of the remainder. It is never too small, and at most
+	      // 2 too large after this correction.
+	    uint64_t num = ((uint64_t)un[j+n] << 32) | un[j+n-1];
+	    uint64_t qhat = num / vn[n-1];
+	    uint64_t rhat = num - qhat*vn[n-1];
+	    while (qhat >= base
+		   || qhat*vn[n-2] > ((rhat << 32) | un[j+n-2])) {
+		  qhat -= 1;
+		  rhat += vn[n-1];
+		  if (rhat >= base)
+			break;
+	    }
 
-      while (divtmp < dividend) {
-	    divtmp <<= 1;
-	    mask <<= 1;
+	      // Multiply and subtract.
+	    int64_t borrow = 0;
+	    int64_t tmp;
+	    for (unsigned idx = 0 ; idx < n ; idx += 1) {
+		  uint64_t prod = qhat * vn[idx];
+		  tmp = (int64_t)un[idx+j] - borrow - (int64_t)(prod & 0xffffffffU);
+		  un[idx+j] = (uint32_t)tmp;
+		  borrow = (int64_t)(prod >> 32) - (tmp >> 32);
+	    }
+	    tmp = (int64_t)un[j+n] - borrow;
+	    un[j+n] = (uint32_t)tmp;
+
+	      // If the estimate was too large, add the divisor back.
+	    if (tmp < 0) {
+		  qhat -= 1;
+		  uint64_t carry = 0;
+		  for (unsigned idx = 0 ; idx < n ; idx += 1) {
+			uint64_t sum = (uint64_t)un[idx+j] + vn[idx] + carry;
+			un[idx+j] = (uint32_t)sum;
+			carry = sum >> 32;
+		  }
+		  un[j+n] += (uint32_t)carry;
+	    }
+	    q[j] = (uint32_t)qhat;
       }
 
-      while (dividend >= divisor) {
-	    if (divtmp <= dividend) {
-		  dividend -= divtmp;
-		  quotient += mask;
+	// Unnormalize the remainder.
+      for (unsigned idx = 0 ; idx < n ; idx += 1)
+	    u[idx] = (un[idx] >> shift)
+		  | (shift? un[idx+1] << (32-shift) : 0);
+}
+
+bool vvp_words_divmod(unsigned long*quot, unsigned long*rem,
+		      const unsigned long*a, const unsigned long*b,
+		      unsigned wid)
+{
+      unsigned words = (wid + CPU_WORD_BITS - 1) / CPU_WORD_BITS;
+      unsigned digits = words * DIGITS_PER_WORD;
+
+      uint32_t*u  = digits_scratch(5*digits + 1);
+      uint32_t*v  = u + digits;
+      uint32_t*q  = v + digits;
+      uint32_t*un = q + digits;
+      uint32_t*vn = un + digits + 1;
+
+      unsigned m = words_to_digits(u, a, wid);
+      unsigned n = words_to_digits(v, b, wid);
+      if (n == 0)
+	    return false;
+
+      for (unsigned idx = 0 ; idx < digits ; idx += 1)
+	    q[idx] = 0;
+
+      if (m < n) {
+	      // The quotient is 0 and the remainder is the dividend.
+
+      } else if (n == 1) {
+	    uint64_t rem_digit = 0;
+	    for (unsigned idx = m ; idx > 0 ; idx -= 1) {
+		  uint64_t num = (rem_digit << 32) | u[idx-1];
+		  q[idx-1] = (uint32_t)(num / v[0]);
+		  rem_digit = num % v[0];
 	    }
+	    u[0] = (uint32_t)rem_digit;
+	    m = 1;
 
-	    divtmp >>= 1;
-	    mask >>= 1;
+      } else {
+	    divide_digits(q, u, m, v, n, un, vn);
+	    m = n;
       }
 
-      remainder = vvp_vector2_t(dividend, mask.size());
+      if (quot) digits_to_words(quot, q, digits, words);
+      if (rem)  digits_to_words(rem, u, m, words);
+      return true;
+}
+
+vvp_vector2_t operator * (const vvp_vector2_t&a, const vvp_vector2_t&b)
+{
+	// The compiler ensures that the two operands are of equal size.
+      assert(a.size() == b.size());
+      vvp_vector2_t r (0, a.size());
+      vvp_words_mul(r.vec_, a.vec_, b.vec_, r.wid_);
+      return r;
 }
 
 vvp_vector2_t operator - (const vvp_vector2_t&that)
@@ -2844,19 +3580,31 @@ vvp_vector2_t operator - (const vvp_vector2_t&that)
       return neg;
 }
 
+static void divide_by_zero(void)
+{
+      cerr << "ERROR: division by zero, exiting." << endl;
+      exit(255);
+}
+
 vvp_vector2_t operator / (const vvp_vector2_t&dividend,
 			  const vvp_vector2_t&divisor)
 {
-      vvp_vector2_t quot, rem;
-      div_mod(dividend, divisor, quot, rem);
+      assert(dividend.size() == divisor.size());
+      vvp_vector2_t quot (0, dividend.size());
+      if (! vvp_words_divmod(quot.vec_, 0, dividend.vec_, divisor.vec_,
+			     quot.wid_))
+	    divide_by_zero();
       return quot;
 }
 
 vvp_vector2_t operator % (const vvp_vector2_t&dividend,
 			  const vvp_vector2_t&divisor)
 {
-      vvp_vector2_t quot, rem;
-      div_mod(dividend, divisor, quot, rem);
+      assert(dividend.size() == divisor.size());
+      vvp_vector2_t rem (0, dividend.size());
+      if (! vvp_words_divmod(0, rem.vec_, dividend.vec_, divisor.vec_,
+			     rem.wid_))
+	    divide_by_zero();
       return rem;
 }
 
@@ -63,7 +63,7 @@ class  vvp_delay_t;
 
 /*
  * Storage for items declared in automatically allocated scopes (i.e. automatic
- * tasks and functions). The first two slots in each context are reserved for
+ * tasks and functions). The first three slots in each context are reserved for
  * linking to other contexts. The function that adds items to a context knows
  * this, and allocates context indices accordingly.
  */
@@ -71,9 +71,11 @@ typedef void**vvp_context_t;
 
 typedef void*vvp_context_item_t;
 
-inline vvp_context_t vvp_allocate_context(unsigned nitem)
+enum { VVP_CONTEXT_LINKS = 3 };
+
+inline size_t vvp_context_size(unsigned nitem)
 {
-      return (vvp_context_t)malloc((2 + nitem) * sizeof(void*));
+      return (VVP_CONTEXT_LINKS + nitem) * sizeof(void*);
 }
 
 inline vvp_context_t vvp_get_next_context(vvp_context_t context)
@@ -86,6 +88,20 @@ inline void vvp_set_next_context(vvp_context_t context, vvp_context_t next)
       context[0] = next;
 }
 
+/*
+ * The live contexts of a scope are doubly linked, so the previous
+ * context link is only meaningful while the context is live.
+ */
+inline vvp_context_t vvp_get_prev_context(vvp_context_t context)
+{
+      return (vvp_context_t)context[2];
+}
+
+inline void vvp_set_prev_context(vvp_context_t context, vvp_context_t prev)
+{
+      context[2] = prev;
+}
+
 inline vvp_context_t vvp_get_stacked_context(vvp_context_t context)
 {
       return (vvp_context_t)context[1];
@@ -232,6 +248,24 @@ static inline unsigned long add_with_carry(unsigned long a, unsigned long b,
 extern unsigned long multiply_with_carry(unsigned long a, unsigned long b,
 					 unsigned long&carry);
 
+/*
+ * These are the kernels for the wide multiply, divide and modulus
+ * operators. The operands and results are arrays of enough words to
+ * hold wid bits, least significant word first, and the results may
+ * overlap the operands. Bits of the operands above wid are ignored.
+ *
+ * vvp_words_mul sets res to the low wid bits of a*b.
+ *
+ * vvp_words_divmod sets quot to a/b and rem to a%b. Either result
+ * pointer may be nil if the result is not wanted. If b is zero the
+ * results are not touched and the function returns false.
+ */
+extern void vvp_words_mul(unsigned long*res, const unsigned long*a,
+			  const unsigned long*b, unsigned wid);
+extern bool vvp_words_divmod(unsigned long*quot, unsigned long*rem,
+			     const unsigned long*a, const unsigned long*b,
+			     unsigned wid);
+
 /*
  * This class represents scalar values collected into vectors. The
  * vector values can be accessed individually, or treated as a
@@ -247,6 +281,7 @@ class vvp_vector4_t {
       friend class vvp_vector4array_t;
       friend class vvp_vector4array_sa;
       friend class vvp_vector4array_aa;
+      friend class vvp_vector4array_sparse;
 
     public:
       static const vvp_vector4_t nil;
@@ -321,6 +356,27 @@ class vvp_vector4_t {
 	// Display the value into the buf as a string.
       char*as_string(char*buf, size_t buf_len) const;
 
+	// Direct read-only access to the a and b words of the vector,
+	// least significant word first. The bits past the end of the
+	// vector in the last word are undefined.
+      inline const unsigned long* abits_words() const
+      { return size_ > BITS_PER_WORD? abits_ptr_ : &abits_val_; }
+      inline const unsigned long* bbits_words() const
+      { return size_ > BITS_PER_WORD? bbits_ptr_ : &bbits_val_; }
+
+	// Copy the whole vector from or to an array of s_vpi_vecval
+	// (the vpiVectorVal encoding, 32 bits per entry). Bits past
+	// the end of the vector in the last entry are ignored on input
+	// and cleared on output.
+      void set_vecval(const s_vpi_vecval*val);
+      void get_vecval(s_vpi_vecval*val) const;
+
+	// Copy the whole vector from arrays of a and b words, laid
+	// out like abits_words() and bbits_words(). Bits past the end
+	// of the vector in the last word are ignored. A nil bbits
+	// array sets a 2-state value.
+      void set_words(const unsigned long*abits, const unsigned long*bbits);
+
       void invert();
       vvp_vector4_t& operator &= (const vvp_vector4_t&that);
       vvp_vector4_t& operator |= (const vvp_vector4_t&that);
@@ -424,8 +480,21 @@ inline vvp_vector4_t& vvp_vector4_t::operator= (const vvp_vector4_t&that)
       if (this == &that)
 	    return *this;
 
-      if (size_ > BITS_PER_WORD)
+      if (size_ > BITS_PER_WORD) {
+	      // If both vectors need the same number of words, then
+	      // copy the words into the array that I already have
+	      // instead of allocating a new one.
+	    unsigned words = (size_+BITS_PER_WORD-1) / BITS_PER_WORD;
+	    if (that.size_ > BITS_PER_WORD
+		&& words == (that.size_+BITS_PER_WORD-1) / BITS_PER_WORD) {
+		  size_ = that.size_;
+		  for (unsigned idx = 0 ; idx < 2*words ; idx += 1)
+			abits_ptr_[idx] = that.abits_ptr_[idx];
+		  return *this;
+	    }
+
 	    delete[] abits_ptr_;
+      }
 
       copy_from_(that);
 
@@ -643,6 +712,45 @@ class vvp_vector4array_aa : public vvp_vector4array_t, public automatic_hooks_s
       unsigned context_idx_;
 };
 
+/*
+ * Sparse statically allocated vvp_vector4array_t, for very large
+ * memories. The words are kept in pages that are only allocated when
+ * a word in them is first written with something other than X, so a
+ * nil page reads as all X. A page starts out 2-state, with only the
+ * abits and a bit per word that tells if the word was written, and is
+ * changed to a 4-state page the first time an X or Z bit is written.
+ */
+class vvp_vector4array_sparse : public vvp_vector4array_t {
+
+    public:
+      vvp_vector4array_sparse(unsigned width, unsigned words);
+      ~vvp_vector4array_sparse();
+
+      vvp_vector4_t get_word(unsigned idx) const;
+      void set_word(unsigned idx, const vvp_vector4_t&that);
+
+      enum { PAGE_WORDS = 1024 };
+
+    private:
+      struct page_s {
+	      // PAGE_WORDS words of cnt_ words of bits each.
+	    unsigned long*abits;
+	      // Nil while the page is 2-state.
+	    unsigned long*bbits;
+	      // A bit per word for a 2-state page, set if the word has
+	      // been written. The other words are X.
+	    unsigned long*valid;
+      };
+
+      page_s*new_page_(bool two_state);
+      void make_4state_(page_s*page);
+      static bool all_x_(const vvp_vector4_t&that);
+
+      unsigned cnt_;
+      unsigned npages_;
+      page_s**pages_;
+};
+
 /* vvp_vector2_t
  */
 class vvp_vector2_t {
@@ -652,6 +760,10 @@ class vvp_vector2_t {
 				       const vvp_vector2_t&);
       friend vvp_vector2_t operator * (const vvp_vector2_t&,
 				       const vvp_vector2_t&);
+      friend vvp_vector2_t operator / (const vvp_vector2_t&,
+				       const vvp_vector2_t&);
+      friend vvp_vector2_t operator % (const vvp_vector2_t&,
+				       const vvp_vector2_t&);
       friend bool operator >  (const vvp_vector2_t&, const vvp_vector2_t&);
       friend bool operator >= (const vvp_vector2_t&, const vvp_vector2_t&);
       friend bool operator <  (const vvp_vector2_t&, const vvp_vector2_t&);
@@ -1071,6 +1183,26 @@ typedef vvp_sub_pointer_t<vvp_net_t> vvp_net_ptr_t;
 template <class T> ostream& operator << (ostream&out, vvp_sub_pointer_t<T> val)
 { out << val.ptr() << "[" << val.port() << "]"; return out; }
 
+/*
+ * The vvp_net_t objects and the functors and filters attached to them
+ * are normally allocated from separate heaps, so following a fan-out
+ * link and then calling into the functor touches memory that is far
+ * apart. The compact layout allocates all three from a single arena
+ * in creation order. The nets are taken from the arena a few at a
+ * time, and the compiler creates the functor and filter of a net right
+ * after the net itself, so they land within a few cache lines of each
+ * other. The layout must be selected before the design is compiled.
+ */
+extern bool vvp_net_set_layout(const char*text);
+extern permaheap*vvp_net_compact_heap;
+
+inline void* vvp_net_heap_alloc(permaheap&heap, std::size_t size)
+{
+      if (vvp_net_compact_heap)
+	    return vvp_net_compact_heap->alloc(size);
+      return heap.alloc(size);
+}
+
 /*
  * This is the basic unit of netlist connectivity. It is a fan-in of
  * up to 4 inputs, and output pointer, and a pointer to the node's
@@ -1157,6 +1289,9 @@ class vvp_net_t {
     private:
       vvp_net_ptr_t out_;
 
+	// The partition analysis walks the fan-out of every net.
+      friend void vvp_net_partition(void);
+
     public: // Need a better new for these objects.
       static void* operator new(std::size_t size);
       static void operator delete(void*); // not implemented
@@ -1167,6 +1302,28 @@ class vvp_net_t {
 #endif
 };
 
+/*
+ * Partition the netlist into regions of vvp_net_t objects that are
+ * connected through fan-out links, and record the number of regions
+ * and the size of the largest region in the statistics. Nets that are
+ * only coupled through threads, events or VPI are not connected by
+ * this analysis, so the regions are the most that any partitioned
+ * evaluation of the netlist could hope to keep apart.
+ *
+ * The partition is kept for the -j mode of the scheduler. The
+ * vvp_net_region() function returns the region number of a net, or 0
+ * if the region must be evaluated by the main thread. That is the
+ * case if any functor in the region is not parallel_safe(), if any
+ * net has VPI callbacks, and for nets made after the partition.
+ *
+ * The vvp_net_region_serial() function moves the region of the net
+ * with the given filter to the main thread. Adding VPI callbacks to a
+ * filter does this, as does linking nets while the simulation runs.
+ */
+extern void vvp_net_partition(void);
+extern unsigned vvp_net_region(const vvp_net_t*net);
+extern void vvp_net_region_serial(const vvp_vpi_callback*obj);
+
 /*
  * Instances of this class represent the functionality of a
  * node. vvp_net_t objects hold pointers to the vvp_net_fun_t
@@ -1232,6 +1389,13 @@ class vvp_net_fun_t {
 	// do something about it.
       virtual void force_flag(bool run_now);
 
+	// The -j mode of the scheduler may run the functors of a
+	// region of the netlist on a worker thread if they all return
+	// true here. A functor may only do so if it keeps all its
+	// state in the object, and calls nothing but the send methods
+	// of its net and schedule_functor().
+      virtual bool parallel_safe() const { return false; }
+
    protected:
       void recv_vec4_pv_(vvp_net_ptr_t p, const vvp_vector4_t&bit,
 			 unsigned base, unsigned wid, unsigned vwid,
@@ -1240,7 +1404,7 @@ class vvp_net_fun_t {
 			 unsigned base, unsigned wid, unsigned vwid);
 
     public: // These objects are only permallocated.
-      static void* operator new(std::size_t size) { return heap_.alloc(size); }
+      static void* operator new(std::size_t size) { return vvp_net_heap_alloc(heap_, size); }
       static void operator delete(void*); // not implemented
 
       static std::size_t heap_total() { return heap_.heap_total(); }
@@ -1313,7 +1477,7 @@ class vvp_net_fil_t  : public vvp_vpi_callback {
       virtual void force_fil_real(double val, const vvp_vector2_t&mask) =0;
 
     public: // These objects are only permallocated.
-      static void* operator new(std::size_t size) { return heap_.alloc(size); }
+      static void* operator new(std::size_t size) { return vvp_net_heap_alloc(heap_, size); }
       static void operator delete(void*); // not implemented
 
       static size_t heap_total() { return heap_.heap_total(); }
@@ -1390,6 +1554,7 @@ class vvp_fun_concat  : public vvp_net_fun_t {
       void recv_vec4_pv(vvp_net_ptr_t port, const vvp_vector4_t&bit,
 			unsigned base, unsigned wid, unsigned vwid,
                         vvp_context_t);
+      bool parallel_safe() const { return true; }
     private:
       unsigned wid_[4];
       vvp_vector4_t val_;
@@ -1411,6 +1576,7 @@ class vvp_fun_concat8  : public vvp_net_fun_t {
                         vvp_context_t);
       void recv_vec8_pv(vvp_net_ptr_t p, const vvp_vector8_t&bit,
 			unsigned base, unsigned wid, unsigned vwid);
+      bool parallel_safe() const { return true; }
 
     private:
       unsigned wid_[4];
@@ -1452,6 +1618,7 @@ class vvp_fun_repeat  : public vvp_net_fun_t {
 
       void recv_vec4(vvp_net_ptr_t port, const vvp_vector4_t&bit,
                      vvp_context_t context);
+      bool parallel_safe() const { return true; }
 
     private:
       unsigned wid_;
@@ -1482,6 +1649,7 @@ class vvp_fun_drive  : public vvp_net_fun_t {
       void recv_vec4_pv(vvp_net_ptr_t port, const vvp_vector4_t&bit,
 			unsigned base, unsigned wid, unsigned vwid,
                         vvp_context_t);
+      bool parallel_safe() const { return true; }
     private:
       unsigned char drive0_;
       unsigned char drive1_;
@@ -1505,6 +1673,7 @@ class vvp_fun_extend_signed  : public vvp_net_fun_t {
       void recv_vec4_pv(vvp_net_ptr_t port, const vvp_vector4_t&bit,
 			unsigned base, unsigned wid, unsigned vwid,
                         vvp_context_t);
+      bool parallel_safe() const { return true; }
     private:
       unsigned width_;
 };
@@ -584,7 +584,7 @@ void vvp_fun_signal_real_aa::vec4_value(vvp_vector4_t&) const
 
 void* vvp_fun_signal_real_aa::operator new(std::size_t size)
 {
-      return vvp_net_fun_t::heap_.alloc(size);
+      return vvp_net_heap_alloc(vvp_net_fun_t::heap_, size);
 }
 
 void vvp_fun_signal_real_aa::operator delete(void*)
@@ -701,7 +701,7 @@ const std::string& vvp_fun_signal_string_aa::get_string() const
 
 void* vvp_fun_signal_string_aa::operator new(std::size_t size)
 {
-      return vvp_net_fun_t::heap_.alloc(size);
+      return vvp_net_heap_alloc(vvp_net_fun_t::heap_, size);
 }
 
 void vvp_fun_signal_string_aa::operator delete(void*)
@@ -812,7 +812,7 @@ void vvp_fun_signal_object_aa::vec4_value(vvp_vector4_t&) const
 
 void* vvp_fun_signal_object_aa::operator new(std::size_t size)
 {
-      return vvp_net_fun_t::heap_.alloc(size);
+      return vvp_net_heap_alloc(vvp_net_fun_t::heap_, size);
 }
 
 void vvp_fun_signal_object_aa::operator delete(void*)
@@ -874,6 +874,7 @@ vvp_wire_vec4::vvp_wire_vec4(unsigned wid, vvp_bit4_t init)
 : bits4_(wid, init)
 {
       needs_init_ = true;
+      stamp_ = 0;
 }
 
 vvp_net_fil_t::prop_t vvp_wire_vec4::filter_vec4(const vvp_vector4_t&bit, vvp_vector4_t&rep,
@@ -888,6 +889,7 @@ vvp_net_fil_t::prop_t vvp_wire_vec4::filter_vec4(const vvp_vector4_t&bit, vvp_ve
 	    if (bits4_ .eeq(tmp) && !needs_init_) return STOP;
 	    bits4_ = tmp;
 	    needs_init_ = false;
+	    stamp_ += 1;
 	    return filter_mask_(tmp, force4_, rep, 0);
       }
 
@@ -910,6 +912,7 @@ vvp_net_fil_t::prop_t vvp_wire_vec4::filter_vec4(const vvp_vector4_t&bit, vvp_ve
       }
 
       needs_init_ = false;
+      stamp_ += 1;
       return filter_mask_(bit, force4_, rep, base);
 }
 
@@ -932,6 +935,7 @@ vvp_net_fil_t::prop_t vvp_wire_vec4::filter_vec8(const vvp_vector8_t&bit,
       }
 
       needs_init_ = false;
+      stamp_ += 1;
       return filter_mask_(bit, vvp_vector8_t(force4_,6,6), rep, base);
 }
 
@@ -954,6 +958,7 @@ void vvp_wire_vec4::force_fil_vec4(const vvp_vector4_t&val, const vvp_vector2_t&
 		  force4_.set_bit(idx, val.value(idx));
 	    }
       }
+      stamp_ += 1;
       run_vpi_callbacks();
 }
 
@@ -970,6 +975,7 @@ void vvp_wire_vec4::force_fil_real(double, const vvp_vector2_t&)
 void vvp_wire_vec4::release(vvp_net_ptr_t ptr, bool net_flag)
 {
       vvp_vector2_t mask (vvp_vector2_t::FILL1, bits4_.size());
+      stamp_ += 1;
       if (net_flag) {
 	      // Wires revert to their unforced value after release.
             release_mask(mask);
@@ -994,6 +1000,7 @@ void vvp_wire_vec4::release_pv(vvp_net_ptr_t ptr, unsigned base, unsigned wid, b
       for (unsigned idx = 0 ; idx < wid ; idx += 1)
 	    mask.set_bit(base+idx, 1);
 
+      stamp_ += 1;
       if (net_flag) {
 	      // Wires revert to their unforced value after release.
 	    release_mask(mask);
@@ -1054,6 +1061,13 @@ bool vvp_wire_vec4::is_forced(unsigned idx) const
       return test_force_mask(idx);
 }
 
+const vvp_vector4_t* vvp_wire_vec4::raw_value() const
+{
+      if (! test_force_mask_is_zero())
+	    return 0;
+      return &bits4_;
+}
+
 vvp_wire_vec8::vvp_wire_vec8(unsigned wid)
 : bits8_(wid)
 {
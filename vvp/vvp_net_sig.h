@@ -153,6 +153,8 @@ class vvp_fun_signal4_sa : public vvp_fun_signal_vec {
 	// Get information about the vector value.
       const vvp_vector4_t& vec4_unfiltered_value() const;
 
+      bool parallel_safe() const { return true; }
+
     private:
       vvp_vector4_t bits4_;
 };
@@ -188,7 +190,7 @@ class vvp_fun_signal4_aa : public vvp_fun_signal_vec, public automatic_signal_ba
       const vvp_vector4_t& vec4_unfiltered_value() const;
 
     public: // These objects are only permallocated.
-      static void* operator new(std::size_t size) { return vvp_net_fun_t::heap_.alloc(size); }
+      static void* operator new(std::size_t size) { return vvp_net_heap_alloc(vvp_net_fun_t::heap_, size); }
       static void operator delete(void*obj);
 
     private:
@@ -451,11 +453,18 @@ class vvp_wire_vec4 : public vvp_wire_base {
       vvp_bit4_t driven_value(unsigned idx) const;
       bool is_forced(unsigned idx) const;
 
+	// Support for vpip_get_vec4_raw. The raw value is only
+	// available if no bits are forced. The stamp is incremented
+	// every time the value changes.
+      const vvp_vector4_t* raw_value() const;
+      unsigned long change_stamp() const { return stamp_; }
+
     private:
       vvp_bit4_t filtered_value_(unsigned idx) const;
 
     private:
       bool needs_init_;
+      unsigned long stamp_;
       vvp_vector4_t bits4_; // The tracked driven value
       vvp_vector4_t force4_; // the value being forced
 };
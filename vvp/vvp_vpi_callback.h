@@ -41,6 +41,11 @@ class vvp_vpi_callback {
       void attach_as_word(struct __vpiArray* arr, unsigned long addr);
 
       void add_vpi_callback(value_callback*);
+
+	// True if a change of the value has to run callbacks or
+	// update array words.
+      bool has_vpi_callbacks() const
+	    { return vpi_callbacks_ != 0 || array_words_ != 0; }
 #ifdef CHECK_WITH_VALGRIND
 	/* This has only been tested at EOS. */
       void clear_all_callbacks(void);